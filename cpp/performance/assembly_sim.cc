@@ -0,0 +1,633 @@
+#include "../src/brain.h"
+#include "../src/tool_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 与 python/brain.py 相同语义的大脑：任意两个脑区之间以及每个刺激到
+ * 每个脑区都有 fiber，进入一个脑区的 fiber 使用该脑区的 beta。每次 Project
+ * 只模拟一步，并记录目标脑区的 saved_w 和 saved_winners。
+ */
+class SimBrain {
+ public:
+  SimBrain(float p, uint32_t seed, bool save_winners = false)
+      : brain_(p, 0.0f, std::numeric_limits<float>::infinity(), seed),
+        save_winners_(save_winners) {}
+
+  void AddStimulus(const std::string& name, uint32_t k) {
+    brain_.AddStimulusInput(name, k);
+    for (const auto& [area, beta] : area_beta_) ConnectStimulus(name, area);
+    stimuli_.push_back(name);
+  }
+
+  void AddArea(const std::string& name, uint32_t n, uint32_t k, float beta,
+               bool is_explicit = false) {
+    brain_.AddArea(name, n, k, /*recurrent=*/false, is_explicit);
+    area_beta_[name] = beta;
+    for (const auto& stimulus : stimuli_) ConnectStimulus(stimulus, name);
+    for (const auto& [other, other_beta] : area_beta_) {
+      Connect(other, name);
+      if (other != name) Connect(name, other);
+    }
+  }
+
+  // 对应 brain.py 的 project(areas_by_stim, dst_areas_by_src_area)
+  void Project(const ProjectMap& areas_by_stim,
+               const ProjectMap& dst_areas_by_src_area,
+               bool update_plasticity = true) {
+    ProjectMap graph = areas_by_stim;
+    std::unordered_set<std::string> targets;
+    for (const auto& [from, to_areas] : dst_areas_by_src_area) {
+      graph[from].insert(to_areas.begin(), to_areas.end());
+    }
+    for (const auto& [from, to_areas] : graph) {
+      targets.insert(to_areas.begin(), to_areas.end());
+    }
+    brain_.Project(graph, 1, update_plasticity);
+    Record(targets);
+  }
+
+  // 在 brain() 上直接执行一步之后，与 Project 一样记录目标脑区
+  template<typename Names>
+  void Record(const Names& areas) {
+    for (const auto& name : areas) {
+      saved_w_[name].push_back(W(name));
+      if (save_winners_) saved_winners_[name].push_back(Winners(name));
+    }
+  }
+
+  uint32_t W(const std::string& name) const {
+    return brain_.GetArea(name).support;
+  }
+  const std::vector<uint32_t>& Winners(const std::string& name) const {
+    return brain_.GetArea(name).activated;
+  }
+  void SetWinners(const std::string& name, const std::vector<uint32_t>& winners) {
+    brain_.GetArea(name).activated = winners;
+  }
+  void FixAssembly(const std::string& name, bool fixed = true) {
+    brain_.GetArea(name).fixed_assembly = fixed;
+  }
+  const std::vector<uint32_t>& SavedW(const std::string& name) {
+    return saved_w_[name];
+  }
+  const std::vector<std::vector<uint32_t>>& SavedWinners(const std::string& name) {
+    return saved_winners_[name];
+  }
+  Brain& brain() { return brain_; }
+  const Brain& brain() const { return brain_; }
+
+ private:
+  void Connect(const std::string& from, const std::string& to) {
+    brain_.AddFiber(from, to);
+    brain_.SetFiberBeta(from, to, area_beta_[to]);
+  }
+  void ConnectStimulus(const std::string& stimulus, const std::string& to) {
+    brain_.AddStimulusFiber(stimulus, to);
+    brain_.SetStimulusBeta(stimulus, to, area_beta_[to]);
+  }
+
+  Brain brain_;
+  bool save_winners_;
+  std::vector<std::string> stimuli_;
+  std::map<std::string, float> area_beta_;
+  std::map<std::string, std::vector<uint32_t>> saved_w_;
+  std::map<std::string, std::vector<std::vector<uint32_t>>> saved_winners_;
+};
+
+// 两组激活神经元的交集大小，对应 brain_util.overlap
+size_t Overlap(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  std::unordered_set<uint32_t> set(a.begin(), a.end());
+  size_t overlap = 0;
+  for (uint32_t neuron : std::unordered_set<uint32_t>(b.begin(), b.end())) {
+    overlap += set.count(neuron);
+  }
+  return overlap;
+}
+
+// ---------------------------------------------------------------------------
+// 结果以 pickle（protocol 0）写出，与 brain_util.sim_save 保存的对象相同，
+// simulations.py 的 plot_* 函数可以直接用 brain_util.sim_load 读取
+
+struct Value {
+  enum Kind { kInt, kFloat, kString, kList, kTuple, kDict };
+  explicit Value(Kind kind) : kind(kind) {}
+
+  Kind kind;
+  double number = 0;
+  std::string text;
+  std::vector<Value> items;  // kDict 时依次为键、值
+
+  static Value Int(long long x) { Value v(kInt); v.number = x; return v; }
+  static Value Float(double x) { Value v(kFloat); v.number = x; return v; }
+  static Value String(const std::string& s) { Value v(kString); v.text = s; return v; }
+  static Value List(std::vector<Value> items = {}) {
+    Value v(kList); v.items = std::move(items); return v;
+  }
+  static Value Tuple(std::vector<Value> items) {
+    Value v(kTuple); v.items = std::move(items); return v;
+  }
+  static Value Dict() { return Value(kDict); }
+  void Set(Value key, Value value) {
+    items.push_back(std::move(key));
+    items.push_back(std::move(value));
+  }
+};
+
+void WritePickle(const Value& v, std::ostream& out) {
+  switch (v.kind) {
+    case Value::kInt:
+      out << 'I' << static_cast<long long>(v.number) << '\n';
+      break;
+    case Value::kFloat: {
+      std::ostringstream number;
+      number.precision(17);
+      number << v.number;
+      out << 'F' << number.str() << '\n';
+      break;
+    }
+    case Value::kString:
+      // 只用于不含特殊字符的键
+      out << 'V' << v.text << '\n';
+      break;
+    case Value::kList:
+      out << "(l";
+      for (const Value& item : v.items) {
+        WritePickle(item, out);
+        out << 'a';
+      }
+      break;
+    case Value::kTuple:
+      out << '(';
+      for (const Value& item : v.items) WritePickle(item, out);
+      out << 't';
+      break;
+    case Value::kDict:
+      out << "(d";
+      for (size_t i = 0; i < v.items.size(); i += 2) {
+        WritePickle(v.items[i], out);
+        WritePickle(v.items[i + 1], out);
+        out << 's';
+      }
+      break;
+  }
+}
+
+Value FloatList(std::vector<double>::const_iterator begin, size_t size) {
+  Value list = Value::List();
+  for (size_t i = 0; i < size; ++i) list.items.push_back(Value::Float(begin[i]));
+  return list;
+}
+
+// ---------------------------------------------------------------------------
+// 实验
+
+struct SimOptions {
+  uint32_t n = 100000;
+  uint32_t k = 317;
+  double p = 0.01;
+  std::vector<double> betas;
+  uint32_t t = 100;
+  uint32_t min_iter = 10;
+  uint32_t max_iter = 20;
+  double alpha = 0.4;
+  uint32_t comp_iter = 8;
+  uint32_t rounds = 20;
+  uint32_t overlap = 0;
+};
+
+/**
+ * @brief 一个实验协议。每个 (beta, 种子) 独立运行一次 Run，返回长度固定的
+ * 数值序列，多个种子的结果逐项取平均后由 Format 组织为 plot_* 读取的对象。
+ */
+struct Experiment {
+  const char* name;
+  const char* output;               // simulations.py 中保存结果的默认文件名
+  const char* description;
+  std::vector<double> default_betas;
+  std::function<void(SimOptions&)> defaults;
+  std::function<std::vector<double>(const SimOptions&, float beta, uint32_t seed)> run;
+  std::function<Value(const SimOptions&, const std::vector<std::vector<double>>&)> format;
+};
+
+// 以 beta 为键：{beta: f(该 beta 的平均结果)}
+Value ByBeta(const SimOptions& options, const std::vector<std::vector<double>>& results,
+             const std::function<Value(const std::vector<double>&)>& f) {
+  Value dict = Value::Dict();
+  for (size_t i = 0; i < options.betas.size(); ++i) {
+    dict.Set(Value::Float(options.betas[i]), f(results[i]));
+  }
+  return dict;
+}
+
+// 以迭代次数为键：{t: 结果}，t 为 min_iter .. max_iter
+Value ByIteration(const SimOptions& options, const std::vector<double>& result) {
+  Value dict = Value::Dict();
+  for (uint32_t t = options.min_iter; t <= options.max_iter; ++t) {
+    dict.Set(Value::Int(t), Value::Float(result[t - options.min_iter]));
+  }
+  return dict;
+}
+
+std::vector<double> ToDouble(const std::vector<uint32_t>& values) {
+  return std::vector<double>(values.begin(), values.end());
+}
+
+// simulations.project_sim
+std::vector<double> ProjectSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed);
+  b.AddStimulus("stim", o.k);
+  b.AddArea("A", o.n, o.k, beta);
+  b.Project({{"stim", {"A"}}}, {});
+  for (uint32_t i = 0; i + 1 < o.t; ++i) {
+    b.Project({{"stim", {"A"}}}, {{"A", {"A"}}});
+  }
+  return ToDouble(b.SavedW("A"));
+}
+
+// simulations.merge_sim：依次为 A、B、C 的 saved_w
+std::vector<double> MergeSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed);
+  b.AddStimulus("stimA", o.k);
+  b.AddStimulus("stimB", o.k);
+  b.AddArea("A", o.n, o.k, beta);
+  b.AddArea("B", o.n, o.k, beta);
+  b.AddArea("C", o.n, o.k, beta);
+  b.Project({{"stimA", {"A"}}}, {});
+  b.Project({{"stimB", {"B"}}}, {});
+  b.Project({{"stimA", {"A"}}, {"stimB", {"B"}}},
+            {{"A", {"A", "C"}}, {"B", {"B", "C"}}});
+  for (uint32_t i = 0; i < o.t; ++i) {
+    b.brain().Merge("A", "B", "C", 1, {{"stimA", {"A"}}, {"stimB", {"B"}}});
+    b.Record(std::vector<std::string>{"A", "B", "C"});
+  }
+  std::vector<double> result;
+  for (const char* area : {"A", "B", "C"}) {
+    for (uint32_t w : b.SavedW(area)) result.push_back(w);
+  }
+  return result;
+}
+
+// 在刺激的驱动下，A 和 B 同时投影到 C 一步（Brain::Associate）
+void AssociateStep(SimBrain& b) {
+  b.brain().Associate("A", "B", "C", 1, {{"stimA", {"A"}}, {"stimB", {"B"}}});
+  b.Record(std::vector<std::string>{"A", "B", "C"});
+}
+
+// A、B 各自建立 assembly，分别投影到 C，再同时投影到 C（association_grand_sim
+// 与 overlap_grand_sim 共同的前半部分），最后一步之前停止
+void BuildAssociation(SimBrain& b, const SimOptions& o, float beta, uint32_t rounds,
+                      float d_beta) {
+  b.AddStimulus("stimA", o.k);
+  b.AddArea("A", o.n, o.k, beta);
+  b.AddStimulus("stimB", o.k);
+  b.AddArea("B", o.n, o.k, beta);
+  b.AddArea("C", o.n, o.k, beta);
+  if (d_beta >= 0) b.AddArea("D", o.n, o.k, d_beta);
+  b.Project({{"stimA", {"A"}}, {"stimB", {"B"}}}, {});
+  for (uint32_t i = 0; i < rounds; ++i) {
+    b.Project({{"stimA", {"A"}}, {"stimB", {"B"}}}, {{"A", {"A"}}, {"B", {"B"}}});
+  }
+  b.Project({{"stimA", {"A"}}}, {{"A", {"A", "C"}}});
+  for (uint32_t i = 0; i < rounds; ++i) {
+    b.Project({{"stimA", {"A"}}}, {{"A", {"A", "C"}}, {"C", {"C"}}});
+  }
+  b.Project({{"stimB", {"B"}}}, {{"B", {"B", "C"}}});
+  for (uint32_t i = 0; i < rounds; ++i) {
+    b.Project({{"stimB", {"B"}}}, {{"B", {"B", "C"}}, {"C", {"C"}}});
+  }
+  b.Project({{"stimA", {"A"}}, {"stimB", {"B"}}}, {{"A", {"A", "C"}}, {"B", {"B", "C"}}});
+  for (uint32_t i = 0; i + 2 < o.min_iter; ++i) {
+    AssociateStep(b);
+  }
+}
+
+// simulations.association_grand_sim：每个 t 上 A、B 分别激活的 C 的重叠比例
+std::vector<double> AssociationSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed, /*save_winners=*/true);
+  BuildAssociation(b, o, beta, 9, -1);
+  std::vector<double> result;
+  for (uint32_t t = o.min_iter; t <= o.max_iter; ++t) {
+    AssociateStep(b);
+    SimBrain copy1 = b;
+    SimBrain copy2 = b;
+    copy1.Project({{"stimA", {"A"}}}, {});
+    copy1.Project({}, {{"A", {"C"}}});
+    copy2.Project({{"stimB", {"B"}}}, {});
+    copy2.Project({}, {{"B", {"C"}}});
+    result.push_back(double(Overlap(copy1.Winners("C"), copy2.Winners("C"))) / o.k);
+  }
+  return result;
+}
+
+// overlap_sim.overlap_grand_sim：每个 t 上 C 中的 assembly 重叠比例，以及它们
+// 投影到 D 之后的重叠比例
+std::vector<double> OverlapSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed, /*save_winners=*/true);
+  BuildAssociation(b, o, beta, 10, 0.0f);
+  std::vector<double> result;
+  for (uint32_t t = o.min_iter; t <= o.max_iter; ++t) {
+    AssociateStep(b);
+    SimBrain copy1 = b;
+    SimBrain copy2 = b;
+    copy1.Project({{"stimA", {"A"}}}, {});
+    copy1.Project({}, {{"A", {"C"}}});
+    copy2.Project({{"stimB", {"B"}}}, {});
+    copy2.Project({}, {{"B", {"C"}}});
+    result.push_back(double(Overlap(copy1.Winners("C"), copy2.Winners("C"))) / o.k);
+    copy1.Project({}, {{"C", {"D"}}});
+    copy1.Project({{"stimB", {"B"}}}, {});
+    copy1.Project({}, {{"B", {"C"}}});
+    copy1.Project({}, {{"C", {"D"}}});
+    const auto& d_winners = copy1.SavedWinners("D");
+    result.push_back(double(Overlap(d_winners[0], d_winners[1])) / o.k);
+  }
+  return result;
+}
+
+// simulations.pattern_com_iterations：用 alpha 比例的 assembly 恢复整个 assembly
+std::vector<double> PatternComSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed);
+  b.AddStimulus("stim", o.k);
+  b.AddArea("A", o.n, o.k, beta);
+  b.Project({{"stim", {"A"}}}, {});
+  for (uint32_t i = 0; i + 2 < o.min_iter; ++i) {
+    b.Project({{"stim", {"A"}}}, {{"A", {"A"}}});
+  }
+  std::vector<uint32_t> subsample;
+  std::mt19937 rng(seed ^ 0x9E3779B9u);
+  std::sample(b.Winners("A").begin(), b.Winners("A").end(),
+              std::back_inserter(subsample), uint32_t(o.k * o.alpha), rng);
+  std::vector<double> result;
+  for (uint32_t t = o.min_iter; t <= o.max_iter; ++t) {
+    b.Project({{"stim", {"A"}}}, {{"A", {"A"}}});
+    SimBrain copy = b;
+    copy.SetWinners("A", subsample);
+    for (uint32_t j = 0; j < o.comp_iter; ++j) copy.Project({}, {{"A", {"A"}}});
+    result.push_back(double(Overlap(copy.Winners("A"), b.Winners("A"))) / o.k);
+  }
+  return result;
+}
+
+// simulations.density：最终 assembly 内部 A -> A 的连接密度
+std::vector<double> DensitySim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed);
+  b.AddStimulus("stim", o.k);
+  b.AddArea("A", o.n, o.k, beta);
+  b.Project({{"stim", {"A"}}}, {});
+  for (uint32_t i = 0; i < o.rounds; ++i) {
+    b.Project({{"stim", {"A"}}}, {{"A", {"A"}}});
+  }
+  const auto& winners = b.Winners("A");
+  const std::unordered_set<uint32_t> assembly(winners.begin(), winners.end());
+  const Fiber& fiber = b.brain().GetFiber("A", "A");
+  size_t edges = 0;
+  for (uint32_t from : winners) {
+    fiber.ForEachSynapse(from, [&](uint32_t to, float) { edges += assembly.count(to); });
+  }
+  return {double(edges) / (double(o.k) * o.k)};
+}
+
+// simulations.separate：两个部分重叠的显式刺激在 A 中形成的 assembly 的重叠，
+// 以及关闭可塑性后各自能恢复的比例
+std::vector<double> SeparateSim(const SimOptions& o, float beta, uint32_t seed) {
+  SimBrain b(o.p, seed);
+  b.AddArea("EXP", 2 * o.k, o.k, beta, /*is_explicit=*/true);
+  b.AddArea("A", o.n, o.k, beta);
+  auto fire = [&](uint32_t first) {
+    std::vector<uint32_t> winners(o.k);
+    for (uint32_t i = 0; i < o.k; ++i) winners[i] = first + i;
+    b.SetWinners("EXP", winners);
+    b.FixAssembly("EXP");
+  };
+  auto form_assembly = [&] {
+    b.Project({}, {{"EXP", {"A"}}});
+    for (uint32_t i = 0; i < o.rounds; ++i) {
+      b.Project({}, {{"EXP", {"A"}}, {"A", {"A"}}});
+    }
+    return b.Winners("A");
+  };
+  fire(0);
+  const std::vector<uint32_t> assembly1 = form_assembly();
+  fire(o.k - o.overlap);
+  const std::vector<uint32_t> assembly2 = form_assembly();
+  const double separation = double(Overlap(assembly1, assembly2)) / o.k;
+  fire(0);
+  b.Project({}, {{"EXP", {"A"}}}, /*update_plasticity=*/false);
+  const double restored1 = double(Overlap(b.Winners("A"), assembly1)) / o.k;
+  fire(o.k - o.overlap);
+  b.Project({}, {{"EXP", {"A"}}}, /*update_plasticity=*/false);
+  const double restored2 = double(Overlap(b.Winners("A"), assembly2)) / o.k;
+  return {separation, restored1, restored2};
+}
+
+const std::vector<Experiment>& Experiments() {
+  static const std::vector<Experiment> experiments = {
+    {"project", "project_results",
+     "saved_w of A while a stimulus projects into it for t rounds (project_beta_sim)",
+     {0.25, 0.1, 0.075, 0.05, 0.03, 0.01, 0.007, 0.005, 0.003, 0.001},
+     [](SimOptions& o) { o.t = 100; },
+     ProjectSim,
+     [](const SimOptions& o, const auto& results) {
+       return ByBeta(o, results, [](const std::vector<double>& r) {
+         return FloatList(r.begin(), r.size());
+       });
+     }},
+    {"merge", "merge_betas",
+     "saved_w of A, B and the merged area C (merge_beta_sim)",
+     {0.3, 0.2, 0.1, 0.075, 0.05},
+     [](SimOptions& o) { o.t = 100; },
+     MergeSim,
+     [](const SimOptions& o, const auto& results) {
+       return ByBeta(o, results, [&](const std::vector<double>& r) {
+         // A 和 B 各投影 t + 2 次，C 投影 t + 1 次
+         const size_t ab = o.t + 2;
+         return Value::Tuple({FloatList(r.begin(), ab), FloatList(r.begin() + ab, ab),
+                              FloatList(r.begin() + 2 * ab, o.t + 1)});
+       });
+     }},
+    {"association", "association_results",
+     "overlap in C of the projections of associated A and B (association_grand_sim)",
+     {0.05},
+     [](SimOptions& o) { o.min_iter = 10; o.max_iter = 20; },
+     AssociationSim,
+     [](const SimOptions& o, const auto& results) { return ByIteration(o, results[0]); }},
+    {"pattern_com", "pattern_com_iterations",
+     "fraction of A recovered from an alpha-subsample (pattern_com_iterations)",
+     {0.05},
+     [](SimOptions& o) { o.min_iter = 20; o.max_iter = 30; },
+     PatternComSim,
+     [](const SimOptions& o, const auto& results) { return ByIteration(o, results[0]); }},
+    {"overlap", "overlap_results",
+     "assembly overlap in C -> overlap of its projections into D (overlap_grand_sim)",
+     {0.05},
+     [](SimOptions& o) { o.min_iter = 10; o.max_iter = 30; },
+     OverlapSim,
+     [](const SimOptions&, const auto& results) {
+       Value dict = Value::Dict();
+       const auto& r = results[0];
+       for (size_t i = 0; i + 1 < r.size(); i += 2) {
+         dict.Set(Value::Float(r[i]), Value::Float(r[i + 1]));
+       }
+       return dict;
+     }},
+    {"density", "density_results",
+     "edge density inside the final assembly of A (density_sim)",
+     {0, 0.025, 0.05, 0.075, 0.1},
+     [](SimOptions& o) { o.rounds = 20; },
+     DensitySim,
+     [](const SimOptions& o, const auto& results) {
+       return ByBeta(o, results, [](const std::vector<double>& r) {
+         return Value::Float(r[0]);
+       });
+     }},
+    {"separate", "separate_results",
+     "overlap of the assemblies of two explicit stimuli and their recovery (separate)",
+     {0.05},
+     [](SimOptions& o) { o.n = 10000; o.k = 100; o.rounds = 10; },
+     SeparateSim,
+     [](const SimOptions& o, const auto& results) {
+       return ByBeta(o, results, [](const std::vector<double>& r) {
+         Value dict = Value::Dict();
+         dict.Set(Value::String("assembly_overlap"), Value::Float(r[0]));
+         dict.Set(Value::String("restored_1"), Value::Float(r[1]));
+         dict.Set(Value::String("restored_2"), Value::Float(r[2]));
+         return dict;
+       });
+     }},
+  };
+  return experiments;
+}
+
+std::vector<double> ParseList(const std::string& text) {
+  std::vector<double> values;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) values.push_back(atof(item.c_str()));
+  }
+  return values;
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s <experiment> [--n=N] [--k=K] [--p=P] [--beta=b1,b2,...] [--t=T]\n"
+          "          [--min_iter=N] [--max_iter=N] [--alpha=A] [--comp_iter=N]\n"
+          "          [--rounds=N] [--overlap=N] [--trials=N] [--first_seed=S]\n"
+          "          [--threads=N] [--out=file]\n"
+          "experiments:\n", name);
+  for (const Experiment& e : Experiments()) {
+    fprintf(stderr, "  %-12s %s\n", e.name, e.description);
+  }
+}
+
+} // namespace nemo
+
+// 在 C++ 引擎上运行 python/simulations.py 和 python/overlap_sim.py 的实验。
+// 每个 (beta, 种子) 是一个独立的试验，在全部核上并行运行；多个种子的结果
+// 取平均后写成 brain_util.sim_save 格式的 pickle
+int main(int argc, char** argv) {
+  using namespace nemo;
+  if (argc < 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+  const Experiment* experiment = nullptr;
+  for (const Experiment& e : Experiments()) {
+    if (argv[1] == std::string(e.name)) experiment = &e;
+  }
+  if (!experiment) {
+    Usage(argv[0]);
+    return 1;
+  }
+  SimOptions options;
+  options.betas = experiment->default_betas;
+  experiment->defaults(options);
+  int trials = 1;
+  uint32_t first_seed = 0;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string out_path = experiment->output;
+
+  const bool parsed = ParseOptions(argc, argv, 2, [&](const std::string& key,
+                                                      const std::string& value) {
+    const uint32_t number = strtoul(value.c_str(), nullptr, 10);
+    if (key == "n") options.n = number;
+    else if (key == "k") options.k = number;
+    else if (key == "p") options.p = atof(value.c_str());
+    else if (key == "beta") options.betas = ParseList(value);
+    else if (key == "t") options.t = number;
+    else if (key == "min_iter") options.min_iter = number;
+    else if (key == "max_iter") options.max_iter = number;
+    else if (key == "alpha") options.alpha = atof(value.c_str());
+    else if (key == "comp_iter") options.comp_iter = number;
+    else if (key == "rounds") options.rounds = number;
+    else if (key == "overlap") options.overlap = number;
+    else if (key == "trials") trials = std::max(1, atoi(value.c_str()));
+    else if (key == "first_seed") first_seed = number;
+    else if (key == "threads") threads = std::max(1, atoi(value.c_str()));
+    else if (key == "out") out_path = value;
+    else return false;
+    return true;
+  });
+  if (!parsed) {
+    Usage(argv[0]);
+    return 1;
+  }
+  if (options.betas.empty() || options.k == 0 || options.k > options.n ||
+      options.min_iter < 2 || options.min_iter > options.max_iter ||
+      options.overlap > options.k) {
+    fprintf(stderr, "Invalid options\n");
+    return 1;
+  }
+
+  const size_t num_jobs = options.betas.size() * trials;
+  std::vector<std::vector<double>> results(num_jobs);
+  size_t done = 0;
+  std::mutex progress_mutex;
+  try {
+    ParallelFor(num_jobs, threads, [&](size_t job) {
+      const float beta = options.betas[job / trials];
+      results[job] = experiment->run(options, beta, first_seed + job % trials);
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      fprintf(stderr, "\r%zu / %zu trials", ++done, num_jobs);
+    });
+  } catch (const std::exception& e) {
+    fprintf(stderr, "\nTrial failed: %s\n", e.what());
+    return 1;
+  }
+  fprintf(stderr, "\n");
+
+  // 每个 beta 的结果逐项取平均
+  std::vector<std::vector<double>> mean(options.betas.size());
+  for (size_t job = 0; job < num_jobs; ++job) {
+    auto& m = mean[job / trials];
+    m.resize(results[job].size());
+    for (size_t i = 0; i < m.size(); ++i) m[i] += results[job][i] / trials;
+  }
+  std::ofstream out(out_path);
+  WritePickle(experiment->format(options, mean), out);
+  out << '.';
+  if (!out) {
+    fprintf(stderr, "Could not write %s\n", out_path.c_str());
+    return 1;
+  }
+  fprintf(stderr, "Wrote %s\n", out_path.c_str());
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include "../src/brain.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 显式脑区 A 的一个 assembly 投射到显式脑区 B（B 有自连接），只计算
+ * 已有突触的输入、选择前 k 个和更新可塑性，不生成新神经元。返回每一步的平均耗时（微秒）。
+ */
+double TimeProjection(uint32_t n, uint32_t k, float p, bool dense, uint32_t steps,
+                      uint32_t seed) {
+  Brain b(p, 0.05, 10000.0, seed);
+  b.AddArea("A", n, k, /*recurrent=*/false, /*is_explicit=*/true);
+  b.AddArea("B", n, k, /*recurrent=*/true, /*is_explicit=*/true);
+  b.AddFiber("A", "B");
+  DenseFiberOptions options;
+  if (dense) {
+    options.enter_density = options.exit_density = 0.0f;
+    options.max_cells = SIZE_MAX;
+  } else {
+    options.enter_density = options.exit_density = 2.0f;
+  }
+  b.SetDenseFiberOptions(options);
+  b.ActivateArea("A", 0);
+  b.Project({{"A", {"B"}}}, 1);
+  const ProjectMap graph = {{"A", {"B"}}, {"B", {"B"}}};
+  auto start = std::chrono::steady_clock::now();
+  b.Project(graph, steps);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(end - start).count() / steps;
+}
+
+}  // namespace nemo
+
+// 对不同的脑区大小 n 和突触密度 p，比较稀疏的突触行和稠密矩阵每一步的耗时，
+// 用于选择 DenseFiberOptions 的默认值
+int main(int argc, char** argv) {
+  using namespace nemo;
+  const uint32_t steps = argc > 1 ? atoi(argv[1]) : 50;
+  const std::vector<uint32_t> sizes = {64, 128, 256, 512, 1024, 2048, 4096};
+  const std::vector<float> densities = {0.05f, 0.1f, 0.15f, 0.2f, 0.3f, 0.5f};
+  printf("%6s %6s %6s %12s %12s %8s\n", "n", "k", "p", "sparse_us", "dense_us", "speedup");
+  for (uint32_t n : sizes) {
+    const uint32_t k = std::min(n / 2, 100u);
+    for (float p : densities) {
+      const double sparse = TimeProjection(n, k, p, false, steps, 7);
+      const double dense = TimeProjection(n, k, p, true, steps, 7);
+      printf("%6u %6u %6.2f %12.1f %12.1f %8.2f\n", n, k, p, sparse, dense, sparse / dense);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,218 @@
+#include "../src/learner.h"
+#include "../src/tool_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nemo {
+
+struct LearnerSimOptions {
+  LearnOptions brain;
+  double start = 0;
+  double end = 0;
+  double step = 0;
+  uint32_t repeat = 1;
+  uint32_t max_samples = 500;
+  uint32_t increment = 1;
+  uint32_t single_word_frequency = 2;
+  bool use_extra_context = false;
+};
+
+/**
+ * @brief learner.py 中的一个实验：对参数 start, start ± step, ... 的每个取值
+ * 构造 repeat 个 LearnBrain，每个独立训练到所有单词都学会为止。
+ */
+struct LearnerExperiment {
+  const char* name;
+  const char* description;
+  std::function<void(LearnerSimOptions&)> defaults;
+  std::function<void(LearnOptions&, double value)> apply;    // 把参数取值写入模型参数
+  std::function<int(LearnBrain&, const LearnerSimOptions&)> run;
+};
+
+int TrainRandomized(LearnBrain& brain, const LearnerSimOptions& o) {
+  return brain.TrainExperimentRandomized(o.max_samples, o.increment, 0,
+                                         o.use_extra_context);
+}
+
+const std::vector<LearnerExperiment>& Experiments() {
+  static const std::vector<LearnerExperiment> experiments = {
+    {"lexicon_sizes",
+     "random sentences needed for n nouns and n verbs (lexicon_sizes_experiment)",
+     [](LearnerSimOptions& o) {
+       o.start = 2; o.end = 10; o.step = 1; o.repeat = 5;
+       o.brain.LEX_k = 50; o.brain.LEX_n = 100000;
+     },
+     [](LearnOptions& b, double n) { b.num_nouns = b.num_verbs = uint32_t(n); },
+     TrainRandomized},
+    {"betas",
+     "random sentences needed for each beta, from start down to end (betas_experiment)",
+     [](LearnerSimOptions& o) {
+       o.start = 0.1; o.end = 0.015; o.step = -0.005; o.repeat = 5;
+       o.brain.LEX_k = 50; o.brain.LEX_n = 100000;
+     },
+     [](LearnOptions& b, double beta) { b.beta = beta; },
+     TrainRandomized},
+    {"p",
+     "random sentences needed for each connection probability p (p_experiment)",
+     [](LearnerSimOptions& o) {
+       o.start = 0.01; o.end = 0.05; o.step = 0.01; o.increment = 5;
+       o.brain.LEX_k = 50; o.brain.LEX_n = 100000; o.brain.beta = 0.05f;
+     },
+     [](LearnOptions& b, double p) { b.p = p; },
+     TrainRandomized},
+    {"tutoring",
+     "words needed when every few samples is a single tutored word (single_word_tutoring_exp)",
+     [](LearnerSimOptions& o) {
+       o.start = 2; o.end = 3; o.step = 1;
+       o.brain.LEX_k = 50; o.brain.LEX_n = 100000;
+     },
+     [](LearnOptions& b, double n) { b.num_nouns = b.num_verbs = uint32_t(n); },
+     [](LearnBrain& brain, const LearnerSimOptions& o) {
+       return brain.TrainExperimentRandomizedWithTutoring(
+           o.max_samples, o.increment, 0, o.single_word_frequency);
+     }},
+  };
+  return experiments;
+}
+
+void Usage(const char* name) {
+  fprintf(stderr,
+          "Usage: %s <experiment> [--start=X] [--end=X] [--step=X] [--repeat=N]\n"
+          "          [--p=P] [--beta=B] [--LEX_k=K] [--LEX_n=N] [--PHON_k=K]\n"
+          "          [--CONTEXTUAL_k=K] [--proj_rounds=N] [--num_nouns=N] [--num_verbs=N]\n"
+          "          [--extra_context_areas=N] [--extra_context_area_k=K]\n"
+          "          [--extra_context_model=A|B|C] [--extra_context_delay=N]\n"
+          "          [--use_extra_context=0|1] [--max_samples=N] [--increment=N]\n"
+          "          [--single_word_frequency=N] [--first_seed=S] [--threads=N]\n"
+          "          [--out=file]\n"
+          "experiments:\n", name);
+  for (const LearnerExperiment& e : Experiments()) {
+    fprintf(stderr, "  %-14s %s\n", e.name, e.description);
+  }
+}
+
+} // namespace nemo
+
+// 在 C++ 引擎上运行 python/learner.py 的单词习得实验。每个 (参数取值, 重复)
+// 是一个独立的试验，在全部核上并行运行；每个试验结束时立即打印结果，最后按
+// learner.py 的格式（每行 "取值,结果,结果,..."，未成功为 None）追加写入 --out
+int main(int argc, char** argv) {
+  using namespace nemo;
+  if (argc < 2) {
+    Usage(argv[0]);
+    return 1;
+  }
+  const LearnerExperiment* experiment = nullptr;
+  for (const LearnerExperiment& e : Experiments()) {
+    if (argv[1] == std::string(e.name)) experiment = &e;
+  }
+  if (!experiment) {
+    Usage(argv[0]);
+    return 1;
+  }
+  LearnerSimOptions options;
+  experiment->defaults(options);
+  uint32_t first_seed = 0;
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string out_path;
+
+  const bool parsed = ParseOptions(argc, argv, 2, [&](const std::string& key,
+                                                      const std::string& value) {
+    const uint32_t number = strtoul(value.c_str(), nullptr, 10);
+    LearnOptions& b = options.brain;
+    if (key == "start") options.start = atof(value.c_str());
+    else if (key == "end") options.end = atof(value.c_str());
+    else if (key == "step") options.step = atof(value.c_str());
+    else if (key == "repeat") options.repeat = std::max(1u, number);
+    else if (key == "p") b.p = atof(value.c_str());
+    else if (key == "beta") b.beta = atof(value.c_str());
+    else if (key == "LEX_k") b.LEX_k = number;
+    else if (key == "LEX_n") b.LEX_n = number;
+    else if (key == "PHON_k") b.PHON_k = number;
+    else if (key == "CONTEXTUAL_k") b.CONTEXTUAL_k = number;
+    else if (key == "proj_rounds") b.proj_rounds = number;
+    else if (key == "num_nouns") b.num_nouns = number;
+    else if (key == "num_verbs") b.num_verbs = number;
+    else if (key == "extra_context_areas") b.extra_context_areas = number;
+    else if (key == "extra_context_area_k") b.extra_context_area_k = number;
+    else if (key == "extra_context_model") b.extra_context_model = value[0];
+    else if (key == "extra_context_delay") b.extra_context_delay = number;
+    else if (key == "use_extra_context") options.use_extra_context = number != 0;
+    else if (key == "max_samples") options.max_samples = number;
+    else if (key == "increment") options.increment = std::max(1u, number);
+    else if (key == "single_word_frequency") options.single_word_frequency = std::max(1u, number);
+    else if (key == "first_seed") first_seed = number;
+    else if (key == "threads") threads = std::max(1, atoi(value.c_str()));
+    else if (key == "out") out_path = value;
+    else return false;
+    return true;
+  });
+  if (!parsed) {
+    Usage(argv[0]);
+    return 1;
+  }
+  // 与 learner.py 的 while 循环相同，包含 end；加上一点容差避免浮点累加误差
+  std::vector<double> values;
+  const double tolerance = 1e-9 * std::max(1.0, std::abs(options.step));
+  for (double v = options.start;
+       options.step > 0 ? v <= options.end + tolerance : v >= options.end - tolerance;
+       v += options.step) {
+    values.push_back(v);
+    if (options.step == 0) break;
+  }
+  const std::string model = "ABC";
+  if (values.empty() || model.find(options.brain.extra_context_model) == std::string::npos) {
+    fprintf(stderr, "Invalid options\n");
+    return 1;
+  }
+
+  const size_t num_jobs = values.size() * options.repeat;
+  std::vector<int> results(num_jobs);
+  std::mutex print_mutex;
+  try {
+    ParallelFor(num_jobs, threads, [&](size_t job) {
+      const double value = values[job / options.repeat];
+      LearnOptions brain_options = options.brain;
+      experiment->apply(brain_options, value);
+      brain_options.seed = first_seed + job;
+      LearnBrain brain(brain_options);
+      results[job] = experiment->run(brain, options);
+      std::lock_guard<std::mutex> lock(print_mutex);
+      if (results[job] < 0) printf("%g: None\n", value);
+      else printf("%g: %d\n", value, results[job]);
+      fflush(stdout);
+    });
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Trial failed: %s\n", e.what());
+    return 1;
+  }
+
+  if (!out_path.empty()) {
+    std::ofstream out(out_path, std::ios::app);
+    for (size_t i = 0; i < values.size(); ++i) {
+      out << values[i] << ",";
+      for (uint32_t r = 0; r < options.repeat; ++r) {
+        const int result = results[i * options.repeat + r];
+        if (result < 0) out << "None,";
+        else out << result << ",";
+      }
+      out << "\n";
+    }
+    if (!out) {
+      fprintf(stderr, "Could not write %s\n", out_path.c_str());
+      return 1;
+    }
+    fprintf(stderr, "Wrote %s\n", out_path.c_str());
+  }
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include "../src/lexicon.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 生成一个 50k 单词的词表，测量从词性文件和二进制词表启动的耗时
+int main(int argc, char** argv) {
+    const int num_words = argc > 1 ? atoi(argv[1]) : 50000;
+    const std::vector<std::string> pos_names = {
+        "adjective", "adverb", "copula", "determinant",
+        "intrans_verb", "noun", "preposition", "trans_verb"};
+
+    char dir_template[] = "/tmp/nemo_lexicon_XXXXXX";
+    std::string dir = mkdtemp(dir_template);
+    {
+        std::vector<std::ofstream> files;
+        for (const auto& pos : pos_names) files.emplace_back(dir + "/" + pos + ".txt");
+        for (int i = 0; i < num_words; ++i) {
+            files[i % pos_names.size()] << "word" << i << "\n";
+        }
+    }
+    std::string binary = dir + "/lexicon.bin";
+
+    auto time = [](auto&& f) {
+        auto start = std::chrono::high_resolution_clock::now();
+        f();
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    };
+
+    nemo::Lexicon lexicon;
+    double t_text = time([&] { lexicon = nemo::Lexicon::FromWordLists(dir); });
+    double t_save = time([&] { lexicon.SaveBinary(binary); });
+    double t_binary = time([&] { lexicon = nemo::Lexicon::FromBinary(binary); });
+    uint32_t found = 0;
+    double t_lookup = time([&] {
+        for (uint32_t id = 0; id < lexicon.size(); ++id) {
+            found += lexicon.Find(lexicon.Word(id)) == id;
+        }
+    });
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "Words: " << lexicon.size() << " (found " << found << ")\n"
+              << "Load from word lists: " << t_text << " ms\n"
+              << "Save binary:          " << t_save << " ms\n"
+              << "Load from binary:     " << t_binary << " ms\n"
+              << "Lookup per word:      " << t_lookup * 1e6 / lexicon.size() << " ns\n";
+
+    for (const auto& pos : pos_names) unlink((dir + "/" + pos + ".txt").c_str());
+    unlink(binary.c_str());
+    rmdir(dir.c_str());
+    return 0;
+}
@@ -0,0 +1,255 @@
+#include "../src/parser.h"
+#include "../src/tool_util.h"
+#include "../test/dependency.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nemo {
+
+// 每个超参数的候选值，网格为它们的笛卡尔积
+struct SweepGrid {
+    std::vector<double> p = {0.1};
+    std::vector<double> LEX_k = {20};
+    std::vector<double> project_rounds = {20};
+    std::vector<double> non_LEX_n = {10000};
+    std::vector<double> non_LEX_k = {100};
+    std::vector<double> default_beta = {0.2};
+    std::vector<double> LEX_beta = {1.0};
+    std::vector<double> recurrent_beta = {0.05};
+    std::vector<double> interarea_beta = {0.5};
+
+    std::vector<std::pair<std::string, std::vector<double>*>> axes() {
+        return {{"p", &p}, {"LEX_k", &LEX_k}, {"project_rounds", &project_rounds},
+                {"non_LEX_n", &non_LEX_n}, {"non_LEX_k", &non_LEX_k},
+                {"default_beta", &default_beta}, {"LEX_beta", &LEX_beta},
+                {"recurrent_beta", &recurrent_beta}, {"interarea_beta", &interarea_beta}};
+    }
+
+    // 第 index 个网格点（按 axes 的顺序，最后一维变化最快）
+    ParserOptions At(size_t index) {
+        std::vector<double> values;
+        auto all = axes();
+        for (auto it = all.rbegin(); it != all.rend(); ++it) {
+            const auto& axis = *it->second;
+            values.push_back(axis[index % axis.size()]);
+            index /= axis.size();
+        }
+        std::reverse(values.begin(), values.end());
+        ParserOptions options;
+        options.p = values[0];
+        options.LEX_k = values[1];
+        options.project_rounds = values[2];
+        options.non_LEX_n = values[3];
+        options.non_LEX_k = values[4];
+        options.default_beta = values[5];
+        options.LEX_beta = values[6];
+        options.recurrent_beta = values[7];
+        options.interarea_beta = values[8];
+        return options;
+    }
+
+    size_t size() {
+        size_t n = 1;
+        for (auto& axis : axes()) n *= axis.second->size();
+        return n;
+    }
+};
+
+// 一个配置在一个种子上解析整个语料的结果
+struct RunResult {
+    int sentences_correct = 0;
+    int dependencies_found = 0;
+    int dependencies_expected = 0;
+    int errors = 0;                     // 抛出异常的句子
+    std::vector<double> us_per_word;    // 每个句子的平均每词耗时（微秒）
+    size_t peak_synapse_bytes = 0;
+};
+
+RunResult RunCorpus(const ParserOptions& options, const std::vector<std::string>& corpus) {
+    RunResult result;
+    for (size_t i = 0; i < corpus.size(); ++i) {
+        const auto& expected = expected_dependency[i];
+        result.dependencies_expected += expected.size();
+        std::vector<std::string_view> words;
+        Tokenize(corpus[i], words);
+        try {
+            auto start = std::chrono::steady_clock::now();
+            IncrementalParser parser(options);
+            for (std::string_view word : words) parser.feed(word);
+            auto dependencies = parser.finish();
+            auto end = std::chrono::steady_clock::now();
+            result.us_per_word.push_back(
+                std::chrono::duration<double, std::micro>(end - start).count() / words.size());
+            result.peak_synapse_bytes = std::max(result.peak_synapse_bytes,
+                                                 parser.brain().SynapseBytes());
+            result.sentences_correct += CompareDependency(dependencies, expected);
+            for (const auto& dependency : dependencies) {
+                result.dependencies_found += expected.count(dependency);
+            }
+        } catch (const std::exception&) {
+            ++result.errors;
+        }
+    }
+    return result;
+}
+
+std::vector<double> ParseList(const std::string& text) {
+    std::vector<double> values;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) values.push_back(atof(item.c_str()));
+    }
+    return values;
+}
+
+void Usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [--<param>=v1,v2,...] [--seeds=N] [--first_seed=S] [--samples=N]\n"
+            "          [--threads=N] [--corpus=sentences.txt] [--out=result.csv]\n"
+            "  param: p LEX_k project_rounds non_LEX_n non_LEX_k default_beta\n"
+            "         LEX_beta recurrent_beta interarea_beta\n"
+            "  --samples=N  evaluate N random grid points instead of the full grid\n",
+            name);
+}
+
+} // namespace nemo
+
+// 在 test/dependency.h 的语料上对超参数做网格或随机搜索，每个配置使用多个种子，
+// 所有 (配置, 种子) 在全部核上并行运行，每个配置输出一行 CSV
+int main(int argc, char** argv) {
+    using namespace nemo;
+    SweepGrid grid;
+    int num_seeds = 4;
+    uint32_t first_seed = 42;
+    size_t samples = 0;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string corpus_path = std::string(NEMO_WORDS_DIR) + "/sentences.txt";
+    std::string out_path;
+
+    const bool parsed = ParseOptions(argc, argv, 1, [&](const std::string& key,
+                                                        const std::string& value) {
+        if (key == "seeds") num_seeds = atoi(value.c_str());
+        else if (key == "first_seed") first_seed = atoi(value.c_str());
+        else if (key == "samples") samples = atoi(value.c_str());
+        else if (key == "threads") threads = std::max(1, atoi(value.c_str()));
+        else if (key == "corpus") corpus_path = value;
+        else if (key == "out") out_path = value;
+        else {
+            bool known = false;
+            for (auto& [name, axis] : grid.axes()) {
+                if (name == key) {
+                    *axis = ParseList(value);
+                    known = !axis->empty();
+                }
+            }
+            return known;
+        }
+        return true;
+    });
+    if (!parsed) {
+        Usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<std::string> corpus;
+    {
+        std::ifstream in(corpus_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) corpus.push_back(line);
+        }
+    }
+    if (corpus.size() != expected_dependency.size()) {
+        fprintf(stderr, "Corpus %s has %zu sentences, expected %zu\n",
+                corpus_path.c_str(), corpus.size(), expected_dependency.size());
+        return 1;
+    }
+
+    // 要评估的网格点
+    std::vector<size_t> points;
+    if (samples == 0 || samples >= grid.size()) {
+        for (size_t i = 0; i < grid.size(); ++i) points.push_back(i);
+    } else {
+        std::mt19937 rng(first_seed);
+        std::uniform_int_distribution<size_t> u(0, grid.size() - 1);
+        while (points.size() < samples) {
+            size_t point = u(rng);
+            if (std::find(points.begin(), points.end(), point) == points.end()) {
+                points.push_back(point);
+            }
+        }
+        std::sort(points.begin(), points.end());
+    }
+
+    const size_t num_jobs = points.size() * num_seeds;
+    std::vector<RunResult> results(num_jobs);
+    size_t done = 0;
+    std::mutex progress_mutex;
+    try {
+        ParallelFor(num_jobs, threads, [&](size_t job) {
+            ParserOptions options = grid.At(points[job / num_seeds]);
+            options.seed = first_seed + job % num_seeds;
+            results[job] = RunCorpus(options, corpus);
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            fprintf(stderr, "\r%zu / %zu runs", ++done, num_jobs);
+        });
+    } catch (const std::exception& e) {
+        fprintf(stderr, "\nRun failed: %s\n", e.what());
+        return 1;
+    }
+    fprintf(stderr, "\n");
+
+    std::ofstream file;
+    if (!out_path.empty()) file.open(out_path);
+    std::ostream& out = out_path.empty() ? std::cout : file;
+    out << "p,LEX_k,project_rounds,non_LEX_n,non_LEX_k,default_beta,LEX_beta,"
+           "recurrent_beta,interarea_beta,seeds,sentence_accuracy,dependency_recall,"
+           "errors,mean_us_per_word,p95_us_per_word,peak_synapse_bytes\n";
+    for (size_t i = 0; i < points.size(); ++i) {
+        const ParserOptions options = grid.At(points[i]);
+        RunResult total;
+        for (int s = 0; s < num_seeds; ++s) {
+            const RunResult& r = results[i * num_seeds + s];
+            total.sentences_correct += r.sentences_correct;
+            total.dependencies_found += r.dependencies_found;
+            total.dependencies_expected += r.dependencies_expected;
+            total.errors += r.errors;
+            total.us_per_word.insert(total.us_per_word.end(), r.us_per_word.begin(),
+                                     r.us_per_word.end());
+            total.peak_synapse_bytes = std::max(total.peak_synapse_bytes, r.peak_synapse_bytes);
+        }
+        auto& latency = total.us_per_word;
+        std::sort(latency.begin(), latency.end());
+        double mean = 0;
+        for (double us : latency) mean += us;
+        if (!latency.empty()) mean /= latency.size();
+        const double p95 = latency.empty() ? 0 : latency[(latency.size() - 1) * 95 / 100];
+        out << options.p << ',' << options.LEX_k << ',' << options.project_rounds << ','
+            << options.non_LEX_n << ',' << options.non_LEX_k << ',' << options.default_beta << ','
+            << options.LEX_beta << ',' << options.recurrent_beta << ',' << options.interarea_beta << ','
+            << num_seeds << ','
+            << std::fixed << std::setprecision(4)
+            << double(total.sentences_correct) / (num_seeds * corpus.size()) << ','
+            << double(total.dependencies_found) / std::max(1, total.dependencies_expected) << ','
+            << total.errors << ','
+            << std::setprecision(1) << mean << ',' << p95 << ','
+            << total.peak_synapse_bytes << '\n';
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+    return 0;
+}
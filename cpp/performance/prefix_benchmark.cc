@@ -0,0 +1,124 @@
+#include "../src/batch_parser.h"
+#include "../src/prefix_cache.h"
+#include "../src/tool_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 生成 "det [adj] noun [adverb] verb ..." 形式的句子。主语从 num_subjects 个
+ * 固定的名词短语中选取，模拟真实流量中大量句子共享开头几个单词的情况。
+ */
+std::vector<std::string> GenerateSentences(uint32_t count, uint32_t num_subjects, uint32_t seed) {
+  const Lexicon& lexicon = *DefaultLexicon();
+  std::map<std::string, std::vector<std::string>> by_pos;
+  for (uint32_t id = 0; id < lexicon.size(); ++id) {
+    by_pos[lexicon.pos_names()[lexicon.Pos(id)]].emplace_back(lexicon.Word(id));
+  }
+  std::mt19937 rng(seed);
+  auto pick = [&](const std::string& pos) {
+    const auto& words = by_pos.at(pos);
+    return words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(rng)];
+  };
+  auto chance = [&](double p) { return std::bernoulli_distribution(p)(rng); };
+  auto noun_phrase = [&] {
+    std::string phrase = pick("determinant") + " ";
+    if (chance(0.3)) phrase += pick("adjective") + " ";
+    return phrase + pick("noun");
+  };
+
+  std::vector<std::string> subjects;
+  for (uint32_t i = 0; i < num_subjects; ++i) subjects.push_back(noun_phrase());
+  std::vector<std::string> sentences;
+  for (uint32_t i = 0; i < count; ++i) {
+    std::string sentence = subjects[std::uniform_int_distribution<size_t>(0, num_subjects - 1)(rng)];
+    if (chance(0.2)) sentence += " " + pick("adverb");
+    if (chance(0.5)) {
+      sentence += " " + pick("trans_verb") + " " + noun_phrase();
+    } else {
+      sentence += " " + pick("intrans_verb");
+      if (chance(0.5)) sentence += " " + pick("preposition") + " " + noun_phrase();
+    }
+    sentences.push_back(sentence);
+  }
+  return sentences;
+}
+
+}  // namespace nemo
+
+// 比较 parse()、PrefixStateCache::Parse 和 ParseBatch 解析同一组句子的耗时，并检查结果相同
+int main(int argc, char** argv) {
+  using namespace nemo;
+  uint32_t num_sentences = 200;
+  uint32_t num_subjects = 8;
+  uint32_t max_prefix_words = 6;
+  size_t max_bytes = size_t(256) << 20;
+  uint32_t seed = 0;
+  uint32_t threads = 1;
+  const bool parsed = ParseOptions(argc, argv, 1, [&](const std::string& key,
+                                                      const std::string& text) {
+    const uint32_t value = strtoul(text.c_str(), nullptr, 10);
+    if (key == "sentences") num_sentences = value;
+    else if (key == "subjects") num_subjects = std::max(1u, value);
+    else if (key == "max_prefix_words") max_prefix_words = value;
+    else if (key == "max_mb") max_bytes = size_t(value) << 20;
+    else if (key == "seed") seed = value;
+    else if (key == "threads") threads = value;
+    else return false;
+    return true;
+  });
+  if (!parsed) {
+    fprintf(stderr, "Usage: %s [--sentences=N] [--subjects=N] [--max_prefix_words=N] "
+            "[--max_mb=N] [--seed=S] [--threads=N]\n", argv[0]);
+    return 1;
+  }
+  const std::vector<std::string> sentences = GenerateSentences(num_sentences, num_subjects, seed);
+  const ParserOptions options;
+
+  std::vector<std::set<std::vector<std::string>>> expected;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::string& sentence : sentences) expected.push_back(parse(sentence, options));
+  const double plain_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  PrefixStateCache cache(options, max_bytes, max_prefix_words);
+  uint32_t mismatches = 0;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < sentences.size(); ++i) {
+    mismatches += cache.Parse(sentences[i]) != expected[i];
+  }
+  const double cached_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  BatchParseStats batch_stats;
+  start = std::chrono::steady_clock::now();
+  const std::vector<BatchParseResult> batch =
+      ParseBatch(sentences, options, threads, nullptr, &batch_stats);
+  const double batch_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  for (size_t i = 0; i < sentences.size(); ++i) {
+    mismatches += batch[i].dependencies != expected[i];
+  }
+
+  const PrefixStateCache::Stats& stats = cache.stats();
+  const uint64_t words = stats.words_reused + stats.words_simulated;
+  printf("sentences          %zu (%u subjects)\n", sentences.size(), num_subjects);
+  printf("parse()            %.3f s\n", plain_s);
+  printf("prefix cache       %.3f s (%.2fx)\n", cached_s, plain_s / cached_s);
+  printf("words reused       %llu / %llu (%.1f%%)\n", (unsigned long long)stats.words_reused,
+         (unsigned long long)words, 100.0 * stats.words_reused / std::max<uint64_t>(words, 1));
+  printf("snapshots          %zu kept, %llu stored, %llu evicted\n", stats.entries,
+         (unsigned long long)stats.snapshots, (unsigned long long)stats.evictions);
+  printf("snapshot memory    %.2f MB\n", stats.bytes / 1048576.0);
+  printf("ParseBatch         %.3f s (%.2fx, %u threads)\n", batch_s, plain_s / batch_s, threads);
+  printf("batch simulated    %llu / %llu words, %u states at most\n",
+         (unsigned long long)batch_stats.words_simulated, (unsigned long long)batch_stats.words,
+         batch_stats.max_states);
+  printf("mismatches         %u\n", mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+#include "../src/recursive_parser.h"
+#include "../src/tool_util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace nemo {
+
+// 默认词表中按词性分组的单词，用来生成句子
+struct WordLists {
+  std::map<std::string, std::vector<std::string>> by_pos;
+
+  explicit WordLists(const Lexicon& lexicon) {
+    for (uint32_t id = 0; id < lexicon.size(); ++id) {
+      by_pos[lexicon.pos_names()[lexicon.Pos(id)]].emplace_back(lexicon.Word(id));
+    }
+  }
+
+  const std::string& Pick(const std::string& pos, std::mt19937& rng) const {
+    const auto& words = by_pos.at(pos);
+    return words[std::uniform_int_distribution<size_t>(0, words.size() - 1)(rng)];
+  }
+};
+
+/**
+ * @brief 生成带有关系从句的句子：名词短语后面可以跟一个 "that ... ," 从句，
+ * 从句缺少主语（that chases the mouse）或宾语（that the dog saw），其中的名词
+ * 短语又可以带从句，直到嵌套深度达到 max_depth - 1。主句的主语和宾语各自带
+ * 从句，同一层的从句依次重用同一组脑区。
+ */
+class SentenceGenerator {
+ public:
+  SentenceGenerator(const WordLists& words, uint32_t max_depth, uint32_t seed)
+      : words_(words), max_depth_(max_depth), rng_(seed) {}
+
+  std::vector<std::string> Generate() {
+    std::vector<std::string> tokens;
+    NounPhrase(0, tokens);
+    if (Chance(0.5)) tokens.push_back(words_.Pick("adverb", rng_));
+    tokens.push_back(words_.Pick("trans_verb", rng_));
+    NounPhrase(0, tokens);
+    return tokens;
+  }
+
+ private:
+  bool Chance(double p) { return std::bernoulli_distribution(p)(rng_); }
+
+  void NounPhrase(uint32_t depth, std::vector<std::string>& tokens) {
+    tokens.push_back(words_.Pick("determinant", rng_));
+    const int adjectives = std::uniform_int_distribution<int>(0, 3)(rng_);
+    for (int i = 0; i < adjectives; ++i) tokens.push_back(words_.Pick("adjective", rng_));
+    tokens.push_back(words_.Pick("noun", rng_));
+    if (depth + 1 < max_depth_) {
+      tokens.push_back(CLAUSE_START);
+      Clause(depth + 1, tokens);
+      tokens.push_back(CLAUSE_END);
+    }
+  }
+
+  void Clause(uint32_t depth, std::vector<std::string>& tokens) {
+    if (Chance(0.5)) {
+      // 缺少主语
+      tokens.push_back(words_.Pick("trans_verb", rng_));
+      NounPhrase(depth, tokens);
+    } else {
+      // 缺少宾语
+      NounPhrase(depth, tokens);
+      if (Chance(0.5)) tokens.push_back(words_.Pick("adverb", rng_));
+      tokens.push_back(words_.Pick("trans_verb", rng_));
+    }
+  }
+
+  const WordLists& words_;
+  const uint32_t max_depth_;
+  std::mt19937 rng_;
+};
+
+// 计数和耗时之和，用于求平均
+struct Timing {
+  double total_us = 0;
+  size_t count = 0;
+  void Add(double us) { total_us += us; ++count; }
+  double Mean() const { return count ? total_us / count : 0; }
+};
+
+}  // namespace nemo
+
+// 用合成的长句（默认 30-50 个单词、多个嵌套的关系从句）测试 RecursiveParser：
+// 每个单词的耗时按句中位置和从句深度分组，以及每个句子结束时的突触内存。
+// 脑区组的数量固定，因此两者都不应随句子变长而增长。
+int main(int argc, char** argv) {
+  using namespace nemo;
+  uint32_t num_sentences = 20;
+  uint32_t min_words = 30;
+  uint32_t max_words = 50;
+  uint32_t max_depth = 3;
+  uint32_t seed = 0;
+  const bool options_ok = ParseOptions(argc, argv, 1, [&](const std::string& key,
+                                                      const std::string& text) {
+    const uint32_t value = strtoul(text.c_str(), nullptr, 10);
+    if (key == "sentences") num_sentences = value;
+    else if (key == "min_words") min_words = value;
+    else if (key == "max_words") max_words = value;
+    else if (key == "max_depth") max_depth = std::max(1u, value);
+    else if (key == "seed") seed = value;
+    else return false;
+    return true;
+  });
+  if (!options_ok) {
+    fprintf(stderr, "Usage: %s [--sentences=N] [--min_words=N] [--max_words=N] "
+            "[--max_depth=D] [--seed=S]\n", argv[0]);
+    return 1;
+  }
+
+  WordLists words(*DefaultLexicon());
+  SentenceGenerator generator(words, max_depth, seed);
+  ParserOptions options;
+  options.seed = seed;
+
+  const uint32_t kBucket = 10;
+  std::vector<Timing> by_position;
+  std::vector<Timing> by_depth(max_depth);
+  size_t peak_bytes = 0;
+  uint32_t parsed = 0;
+  printf("%8s %8s %12s %14s %12s\n", "sentence", "words", "us/word", "synapse_MB", "dependencies");
+  for (uint32_t tries = 0; parsed < num_sentences && tries < 1000 * num_sentences; ++tries) {
+    std::vector<std::string> tokens = generator.Generate();
+    const uint32_t num_words = std::count_if(tokens.begin(), tokens.end(), [](const std::string& t) {
+      return t != CLAUSE_START && t != CLAUSE_END;
+    });
+    if (num_words < min_words || num_words > max_words) continue;
+
+    RecursiveParser parser(options, max_depth);
+    Timing sentence;
+    uint32_t position = 0;
+    for (const std::string& token : tokens) {
+      const uint32_t depth = parser.depth();
+      auto start = std::chrono::steady_clock::now();
+      parser.feed(token);
+      const double us = std::chrono::duration<double, std::micro>(
+          std::chrono::steady_clock::now() - start).count();
+      if (token == CLAUSE_START || token == CLAUSE_END) continue;
+      sentence.Add(us);
+      by_depth[depth].Add(us);
+      if (by_position.size() <= position / kBucket) by_position.resize(position / kBucket + 1);
+      by_position[position / kBucket].Add(us);
+      ++position;
+    }
+    const size_t num_dependencies = parser.finish().size();
+    const size_t bytes = parser.brain().SynapseBytes();
+    peak_bytes = std::max(peak_bytes, bytes);
+    printf("%8u %8u %12.1f %14.2f %12zu\n", parsed, num_words, sentence.Mean(),
+           bytes / 1048576.0, num_dependencies);
+    ++parsed;
+  }
+  if (parsed == 0) {
+    fprintf(stderr, "No sentence with %u-%u words\n", min_words, max_words);
+    return 1;
+  }
+
+  printf("\nper-word latency by position\n%10s %12s %8s\n", "position", "us/word", "words");
+  for (size_t i = 0; i < by_position.size(); ++i) {
+    printf("%4zu-%-5zu %12.1f %8zu\n", i * kBucket, (i + 1) * kBucket - 1,
+           by_position[i].Mean(), by_position[i].count);
+  }
+  printf("\nper-word latency by clause depth\n%10s %12s %8s\n", "depth", "us/word", "words");
+  for (uint32_t d = 0; d < max_depth; ++d) {
+    printf("%10u %12.1f %8zu\n", d, by_depth[d].Mean(), by_depth[d].count);
+  }
+  printf("\npeak synapse memory: %.2f MB\n", peak_bytes / 1048576.0);
+  return 0;
+}
@@ -0,0 +1,63 @@
+#include "../src/sampling.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace nemo {
+
+// 原来的做法：均匀抽取，遇到已选择的位置就重试，需要大小为 n 的标记数组
+template<typename Trng>
+void RejectionSample(uint32_t n, uint32_t m, Trng& rng,
+                     std::vector<uint32_t>& out) {
+    out.clear();
+    std::vector<uint8_t> selected(n);
+    std::uniform_int_distribution<> u(0, n - 1);
+    for (uint32_t j = 0; j < m; ++j) {
+        uint32_t next;
+        while (selected[next = u(rng)]) {}
+        selected[next] = 1;
+        out.push_back(next);
+    }
+}
+
+} // namespace nemo
+
+// 对不同的总体大小 n 和抽样比例 m / n，比较每次抽样的平均耗时（微秒）
+int main(int argc, char** argv) {
+    const int repeats = argc > 1 ? atoi(argv[1]) : 200;
+    const std::vector<uint32_t> populations = {1000, 10000, 100000};
+    const std::vector<double> ratios = {0.001, 0.01, 0.05, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99, 1.0};
+
+    std::mt19937 rng(42);
+    std::vector<uint32_t> out;
+    auto time = [&](auto&& sample, uint32_t n, uint32_t m) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < repeats; ++i) sample(n, m, rng, out);
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::micro>(end - start).count() / repeats;
+    };
+
+    std::cout << std::setw(8) << "n" << std::setw(8) << "m/n" << std::setw(10) << "m"
+              << std::setw(12) << "rejection" << std::setw(12) << "floyd"
+              << std::setw(12) << "adaptive" << "\n";
+    for (uint32_t n : populations) {
+        for (double ratio : ratios) {
+            const uint32_t m = std::max<uint32_t>(1, n * ratio);
+            auto rejection = [](uint32_t n, uint32_t m, std::mt19937& rng, std::vector<uint32_t>& out) { nemo::RejectionSample(n, m, rng, out); };
+            auto floyd = [](uint32_t n, uint32_t m, std::mt19937& rng, std::vector<uint32_t>& out) { nemo::FloydSample(n, m, rng, out); };
+            auto adaptive = [](uint32_t n, uint32_t m, std::mt19937& rng, std::vector<uint32_t>& out) { nemo::SampleWithoutReplacement(n, m, rng, out); };
+            std::cout << std::fixed << std::setprecision(2)
+                      << std::setw(8) << n << std::setw(8) << ratio << std::setw(10) << m
+                      << std::setw(12) << time(rejection, n, m)
+                      << std::setw(12) << time(floyd, n, m)
+                      << std::setw(12) << time(adaptive, n, m) << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,531 @@
+// CPython 扩展模块 _nemo：把 nemo::Brain 暴露给 python/ 下的实验脚本。
+// 这里只做一层薄封装，brain.py 的接口（每对脑区之间的 fiber、按目标脑区
+// 的默认 beta、saved_w / saved_winners 等）由 python/nemo_brain.py 实现。
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "../src/brain.h"
+
+#include <stdint.h>
+
+#include <limits>
+#include <map>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// ---------------------------------------------------------------------------
+// Winners：某一步之后一个脑区的激活神经元，不可修改，支持 buffer 协议。
+// 它是 Area::activated 的副本（activated 每步都会被替换，不能直接引用），每步在
+// 第一次读取时复制一次；numpy.frombuffer / memoryview 再引用这份副本时不再复制
+
+struct WinnersObject {
+  PyObject_HEAD
+  std::vector<uint32_t>* neurons;
+  Py_ssize_t shape[1];
+  Py_ssize_t strides[1];
+};
+
+void WinnersDealloc(WinnersObject* self) {
+  delete self->neurons;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+Py_ssize_t WinnersLength(WinnersObject* self) {
+  return self->neurons->size();
+}
+
+int WinnersGetBuffer(WinnersObject* self, Py_buffer* view, int flags) {
+  if (flags & PyBUF_WRITABLE) {
+    PyErr_SetString(PyExc_BufferError, "Winners are read-only");
+    view->obj = nullptr;
+    return -1;
+  }
+  static uint32_t empty;
+  std::vector<uint32_t>& neurons = *self->neurons;
+  view->obj = reinterpret_cast<PyObject*>(self);
+  Py_INCREF(view->obj);
+  view->buf = neurons.empty() ? &empty : neurons.data();
+  view->len = neurons.size() * sizeof(uint32_t);
+  view->readonly = 1;
+  view->itemsize = sizeof(uint32_t);
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>("I") : nullptr;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) ? self->shape : nullptr;
+  view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? self->strides : nullptr;
+  view->suboffsets = nullptr;
+  view->internal = nullptr;
+  return 0;
+}
+
+PySequenceMethods winners_as_sequence = {
+  reinterpret_cast<lenfunc>(WinnersLength),
+};
+
+PyBufferProcs winners_as_buffer = {
+  reinterpret_cast<getbufferproc>(WinnersGetBuffer),
+  nullptr,
+};
+
+PyTypeObject WinnersType = {
+  PyVarObject_HEAD_INIT(nullptr, 0)
+  "_nemo.Winners",
+};
+
+PyObject* NewWinners(const std::vector<uint32_t>& neurons) {
+  WinnersObject* self = PyObject_New(WinnersObject, &WinnersType);
+  if (!self) return nullptr;
+  self->neurons = new (std::nothrow) std::vector<uint32_t>(neurons);
+  if (!self->neurons) {
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+    return PyErr_NoMemory();
+  }
+  self->shape[0] = neurons.size();
+  self->strides[0] = sizeof(uint32_t);
+  return reinterpret_cast<PyObject*>(self);
+}
+
+// ---------------------------------------------------------------------------
+// Brain
+
+struct BrainObject {
+  PyObject_HEAD
+  nemo::Brain* brain;
+  // 每个脑区最近一次导出的 Winners，激活神经元改变后失效。同一步内多次读取
+  // winners 只复制一次，之后的读取和 saved_winners 共用同一块数据
+  std::map<std::string, PyObject*>* winners;
+  bool busy;  // project 期间释放了 GIL，其他线程不能使用同一个对象
+};
+
+void ClearWinners(BrainObject* self) {
+  for (auto& [name, winners] : *self->winners) Py_DECREF(winners);
+  self->winners->clear();
+}
+
+void BrainDealloc(BrainObject* self) {
+  if (self->winners) ClearWinners(self);
+  delete self->winners;
+  delete self->brain;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* BrainNew(PyTypeObject* type, PyObject*, PyObject*) {
+  BrainObject* self = reinterpret_cast<BrainObject*>(type->tp_alloc(type, 0));
+  if (!self) return nullptr;
+  self->brain = nullptr;
+  self->winners = new (std::nothrow) std::map<std::string, PyObject*>();
+  self->busy = false;
+  if (!self->winners) {
+    Py_DECREF(self);
+    return PyErr_NoMemory();
+  }
+  return reinterpret_cast<PyObject*>(self);
+}
+
+int BrainInit(BrainObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* kwlist[] = {"p", "beta", "max_weight", "seed", nullptr};
+  float p;
+  float beta = 0.05f;
+  float max_weight = std::numeric_limits<float>::infinity();
+  unsigned long seed = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "f|ffk",
+                                   const_cast<char**>(kwlist),
+                                   &p, &beta, &max_weight, &seed)) {
+    return -1;
+  }
+  if (self->brain) {
+    PyErr_SetString(PyExc_RuntimeError, "Brain is already initialized");
+    return -1;
+  }
+  self->brain = new nemo::Brain(p, beta, max_weight, seed);
+  return 0;
+}
+
+// 对象已初始化且没有在其他线程中 project 时返回 true，否则设置异常
+bool CheckReady(BrainObject* self) {
+  if (!self->brain) {
+    PyErr_SetString(PyExc_RuntimeError, "Brain is not initialized");
+    return false;
+  }
+  if (self->busy) {
+    PyErr_SetString(PyExc_RuntimeError, "Brain is projecting in another thread");
+    return false;
+  }
+  return true;
+}
+
+// 在 CheckReady 的基础上检查脑区存在
+bool CheckArea(BrainObject* self, const char* name) {
+  if (!CheckReady(self)) return false;
+  if (!self->brain->HasArea(name)) {
+    PyErr_Format(PyExc_KeyError, "No area named %s", name);
+    return false;
+  }
+  return true;
+}
+
+// 在 CheckReady 的基础上检查脑区或刺激存在
+bool CheckSource(BrainObject* self, const char* name) {
+  if (!CheckReady(self)) return false;
+  if (!self->brain->HasArea(name) && !self->brain->HasStimulus(name)) {
+    PyErr_Format(PyExc_KeyError, "No area or stimulus named %s", name);
+    return false;
+  }
+  return true;
+}
+
+// 检查名称未被脑区或刺激使用
+bool CheckNewName(BrainObject* self, const char* name) {
+  if (!CheckReady(self)) return false;
+  if (self->brain->HasArea(name) || self->brain->HasStimulus(name)) {
+    PyErr_Format(PyExc_ValueError, "Name %s is already in use", name);
+    return false;
+  }
+  return true;
+}
+
+PyObject* BrainAddArea(BrainObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* kwlist[] = {"name", "n", "k", "recurrent", "explicit", nullptr};
+  const char* name;
+  unsigned int n, k;
+  int recurrent = 1, is_explicit = 0;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "sII|pp",
+                                   const_cast<char**>(kwlist), &name, &n, &k,
+                                   &recurrent, &is_explicit) ||
+      !CheckNewName(self, name)) {
+    return nullptr;
+  }
+  if (k == 0 || k > n) {
+    return PyErr_Format(PyExc_ValueError, "Area %s needs 0 < k <= n", name);
+  }
+  self->brain->AddArea(name, n, k, recurrent, is_explicit);
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainAddStimulus(BrainObject* self, PyObject* args) {
+  const char* name;
+  unsigned int k;
+  if (!PyArg_ParseTuple(args, "sI", &name, &k) || !CheckNewName(self, name)) {
+    return nullptr;
+  }
+  self->brain->AddStimulusInput(name, k);
+  Py_RETURN_NONE;
+}
+
+// from 为刺激时添加刺激 fiber
+PyObject* BrainAddFiber(BrainObject* self, PyObject* args) {
+  const char* from;
+  const char* to;
+  if (!PyArg_ParseTuple(args, "ss", &from, &to) || !CheckSource(self, from) ||
+      !CheckArea(self, to)) {
+    return nullptr;
+  }
+  if (self->brain->HasStimulus(from)) {
+    self->brain->AddStimulusFiber(from, to);
+  } else {
+    self->brain->AddFiber(from, to);
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainSetFiberBeta(BrainObject* self, PyObject* args) {
+  const char* from;
+  const char* to;
+  float beta;
+  if (!PyArg_ParseTuple(args, "ssf", &from, &to, &beta) ||
+      !CheckSource(self, from) || !CheckArea(self, to)) {
+    return nullptr;
+  }
+  if (self->brain->HasStimulus(from)) {
+    self->brain->SetStimulusBeta(from, to, beta);
+  } else {
+    self->brain->SetFiberBeta(from, to, beta);
+  }
+  Py_RETURN_NONE;
+}
+
+// graph: {起始脑区或刺激: [目标脑区, ...]}
+bool ParseProjectMap(BrainObject* self, PyObject* graph, nemo::ProjectMap& out) {
+  if (!PyDict_Check(graph)) {
+    PyErr_SetString(PyExc_TypeError, "graph must be a dict");
+    return false;
+  }
+  PyObject* key;
+  PyObject* value;
+  Py_ssize_t pos = 0;
+  while (PyDict_Next(graph, &pos, &key, &value)) {
+    const char* from = PyUnicode_AsUTF8(key);
+    if (!from || !CheckSource(self, from)) return false;
+    auto& edges = out[from];
+    PyObject* targets = PySequence_Fast(value, "graph values must be sequences");
+    if (!targets) return false;
+    for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(targets); ++i) {
+      const char* to = PyUnicode_AsUTF8(PySequence_Fast_GET_ITEM(targets, i));
+      if (!to || !CheckArea(self, to)) {
+        Py_DECREF(targets);
+        return false;
+      }
+      edges.insert(to);
+    }
+    Py_DECREF(targets);
+  }
+  return true;
+}
+
+PyObject* BrainProject(BrainObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* kwlist[] = {"graph", "num_steps", "update_plasticity", nullptr};
+  PyObject* graph;
+  unsigned int num_steps = 1;
+  int update_plasticity = 1;
+  nemo::ProjectMap project_map;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O|Ip",
+                                   const_cast<char**>(kwlist), &graph,
+                                   &num_steps, &update_plasticity) ||
+      !CheckReady(self) || !ParseProjectMap(self, graph, project_map)) {
+    return nullptr;
+  }
+  ClearWinners(self);
+  // 模拟期间不访问 Python 对象，释放 GIL 以便多个 Brain 在不同线程中并行运行
+  self->busy = true;
+  const char* error = nullptr;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    self->brain->Project(project_map, num_steps, update_plasticity);
+  } catch (const std::bad_alloc&) {
+    error = "out of memory";
+  } catch (const std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  self->busy = false;
+  if (error) {
+    return PyErr_Format(PyExc_RuntimeError, "Project failed: %s", error);
+  }
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainWinners(BrainObject* self, PyObject* args) {
+  const char* name;
+  if (!PyArg_ParseTuple(args, "s", &name) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  PyObject*& winners = (*self->winners)[name];
+  if (!winners) {
+    winners = NewWinners(self->brain->GetArea(name).activated);
+    if (!winners) {
+      self->winners->erase(name);
+      return nullptr;
+    }
+  }
+  Py_INCREF(winners);
+  return winners;
+}
+
+PyObject* BrainSetWinners(BrainObject* self, PyObject* args) {
+  const char* name;
+  PyObject* neurons;
+  if (!PyArg_ParseTuple(args, "sO", &name, &neurons) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  nemo::Area& area = self->brain->GetArea(name);
+  PyObject* seq = PySequence_Fast(neurons, "winners must be a sequence");
+  if (!seq) return nullptr;
+  std::vector<uint32_t> activated;
+  activated.reserve(PySequence_Fast_GET_SIZE(seq));
+  for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(seq); ++i) {
+    PyObject* index = PyNumber_Index(PySequence_Fast_GET_ITEM(seq, i));
+    const unsigned long neuron = index ? PyLong_AsUnsignedLong(index) : 0;
+    Py_XDECREF(index);
+    if (PyErr_Occurred()) {
+      Py_DECREF(seq);
+      return nullptr;
+    }
+    // 只有已经生成突触的神经元才能激活
+    if (neuron >= area.support) {
+      Py_DECREF(seq);
+      return PyErr_Format(PyExc_ValueError,
+                          "Neuron %lu of area %s has never fired (support %u)",
+                          neuron, name, area.support);
+    }
+    activated.push_back(neuron);
+  }
+  Py_DECREF(seq);
+  area.activated = std::move(activated);
+  ClearWinners(self);
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainActivate(BrainObject* self, PyObject* args) {
+  const char* name;
+  unsigned int index;
+  if (!PyArg_ParseTuple(args, "sI", &name, &index) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  const nemo::Area& area = self->brain->GetArea(name);
+  if ((uint64_t(index) + 1) * area.k > area.support) {
+    return PyErr_Format(PyExc_ValueError,
+                        "Area %s has no assembly %u (support %u)", name, index,
+                        area.support);
+  }
+  self->brain->ActivateArea(name, index);
+  ClearWinners(self);
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainSupport(BrainObject* self, PyObject* args) {
+  const char* name;
+  if (!PyArg_ParseTuple(args, "s", &name) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  return PyLong_FromUnsignedLong(self->brain->GetArea(name).support);
+}
+
+PyObject* BrainIsFixed(BrainObject* self, PyObject* args) {
+  const char* name;
+  if (!PyArg_ParseTuple(args, "s", &name) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  return PyBool_FromLong(self->brain->GetArea(name).fixed_assembly);
+}
+
+PyObject* BrainSetFixed(BrainObject* self, PyObject* args) {
+  const char* name;
+  int fixed;
+  if (!PyArg_ParseTuple(args, "sp", &name, &fixed) || !CheckArea(self, name)) {
+    return nullptr;
+  }
+  self->brain->GetArea(name).fixed_assembly = fixed;
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainSetLogLevel(BrainObject* self, PyObject* args) {
+  int log_level;
+  if (!PyArg_ParseTuple(args, "i", &log_level) || !CheckReady(self)) {
+    return nullptr;
+  }
+  self->brain->SetLogLevel(log_level);
+  Py_RETURN_NONE;
+}
+
+PyObject* BrainSynapseBytes(BrainObject* self, PyObject*) {
+  if (!CheckReady(self)) return nullptr;
+  return PyLong_FromSize_t(self->brain->SynapseBytes());
+}
+
+// copy.copy 和 copy.deepcopy 都复制整个 Brain（包括随机数生成器的状态）
+PyObject* BrainCopy(BrainObject* self, PyObject*) {
+  if (!CheckReady(self)) return nullptr;
+  BrainObject* copy = reinterpret_cast<BrainObject*>(
+      BrainNew(Py_TYPE(self), nullptr, nullptr));
+  if (!copy) return nullptr;
+  try {
+    copy->brain = new nemo::Brain(*self->brain);
+  } catch (const std::bad_alloc&) {
+    Py_DECREF(copy);
+    return PyErr_NoMemory();
+  }
+  // Winners 不可修改，两个对象可以共用
+  for (auto& [name, winners] : *self->winners) {
+    Py_INCREF(winners);
+    (*copy->winners)[name] = winners;
+  }
+  return reinterpret_cast<PyObject*>(copy);
+}
+
+PyObject* BrainDeepCopy(BrainObject* self, PyObject*) {
+  return BrainCopy(self, nullptr);
+}
+
+PyMethodDef brain_methods[] = {
+  {"add_area", reinterpret_cast<PyCFunction>(BrainAddArea),
+   METH_VARARGS | METH_KEYWORDS,
+   "add_area(name, n, k, recurrent=True, explicit=False)\n"
+   "Adds an area; a recurrent area gets a fiber to itself."},
+  {"add_stimulus", reinterpret_cast<PyCFunction>(BrainAddStimulus), METH_VARARGS,
+   "add_stimulus(name, k)\nAdds a stimulus of k neurons that fire together whenever it projects."},
+  {"add_fiber", reinterpret_cast<PyCFunction>(BrainAddFiber), METH_VARARGS,
+   "add_fiber(from_area_or_stimulus, to_area)"},
+  {"set_fiber_beta", reinterpret_cast<PyCFunction>(BrainSetFiberBeta), METH_VARARGS,
+   "set_fiber_beta(from_area_or_stimulus, to_area, beta)"},
+  {"project", reinterpret_cast<PyCFunction>(BrainProject),
+   METH_VARARGS | METH_KEYWORDS,
+   "project(graph, num_steps=1, update_plasticity=True)\n"
+   "Runs num_steps steps with only the fibers in graph {from: [to, ...]} active;\n"
+   "`from` is an area or a stimulus.\n"
+   "Releases the GIL while simulating."},
+  {"winners", reinterpret_cast<PyCFunction>(BrainWinners), METH_VARARGS,
+   "winners(area) -> Winners\n"
+   "Read-only uint32 buffer of the area's firing neurons. The engine's winners\n"
+   "are copied once per step, on the first read; later reads return the same\n"
+   "buffer, numpy.frombuffer does not copy it again, and it stays valid after\n"
+   "later projections."},
+  {"set_winners", reinterpret_cast<PyCFunction>(BrainSetWinners), METH_VARARGS,
+   "set_winners(area, neurons)\nNeurons must have fired before (index < support)."},
+  {"activate", reinterpret_cast<PyCFunction>(BrainActivate), METH_VARARGS,
+   "activate(area, index)\nFires and fixes assembly `index` of an explicit area."},
+  {"support", reinterpret_cast<PyCFunction>(BrainSupport), METH_VARARGS,
+   "support(area) -> number of neurons that have ever fired (all n if explicit)"},
+  {"is_fixed", reinterpret_cast<PyCFunction>(BrainIsFixed), METH_VARARGS,
+   "is_fixed(area) -> whether the area's winners are frozen"},
+  {"set_fixed", reinterpret_cast<PyCFunction>(BrainSetFixed), METH_VARARGS,
+   "set_fixed(area, fixed)"},
+  {"set_log_level", reinterpret_cast<PyCFunction>(BrainSetLogLevel), METH_VARARGS,
+   "set_log_level(level)"},
+  {"synapse_bytes", reinterpret_cast<PyCFunction>(BrainSynapseBytes), METH_NOARGS,
+   "synapse_bytes() -> bytes held by synapse rows"},
+  {"__copy__", reinterpret_cast<PyCFunction>(BrainCopy), METH_NOARGS, nullptr},
+  {"__deepcopy__", reinterpret_cast<PyCFunction>(BrainDeepCopy), METH_O, nullptr},
+  {nullptr, nullptr, 0, nullptr},
+};
+
+PyTypeObject BrainType = {
+  PyVarObject_HEAD_INIT(nullptr, 0)
+  "_nemo.Brain",
+};
+
+PyModuleDef nemo_module = {
+  PyModuleDef_HEAD_INIT,
+  "_nemo",
+  "Compiled nemo::Brain; see python/nemo_brain.py for the brain.py interface.",
+  -1,
+};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit__nemo() {
+  WinnersType.tp_basicsize = sizeof(WinnersObject);
+  WinnersType.tp_dealloc = reinterpret_cast<destructor>(WinnersDealloc);
+  WinnersType.tp_flags = Py_TPFLAGS_DEFAULT;
+  WinnersType.tp_doc = "Read-only uint32 buffer holding an area's winners.";
+  WinnersType.tp_as_sequence = &winners_as_sequence;
+  WinnersType.tp_as_buffer = &winners_as_buffer;
+
+  BrainType.tp_basicsize = sizeof(BrainObject);
+  BrainType.tp_dealloc = reinterpret_cast<destructor>(BrainDealloc);
+  BrainType.tp_flags = Py_TPFLAGS_DEFAULT;
+  BrainType.tp_doc =
+      "Brain(p, beta=0.05, max_weight=inf, seed=0)\n"
+      "nemo::Brain with areas, stimuli and fibers addressed by name.";
+  BrainType.tp_methods = brain_methods;
+  BrainType.tp_init = reinterpret_cast<initproc>(BrainInit);
+  BrainType.tp_new = BrainNew;
+
+  if (PyType_Ready(&WinnersType) < 0 || PyType_Ready(&BrainType) < 0) {
+    return nullptr;
+  }
+  PyObject* module = PyModule_Create(&nemo_module);
+  if (!module) return nullptr;
+  Py_INCREF(&WinnersType);
+  Py_INCREF(&BrainType);
+  if (PyModule_AddObject(module, "Winners",
+                         reinterpret_cast<PyObject*>(&WinnersType)) < 0 ||
+      PyModule_AddObject(module, "Brain",
+                         reinterpret_cast<PyObject*>(&BrainType)) < 0) {
+    Py_DECREF(module);
+    return nullptr;
+  }
+  return module;
+}
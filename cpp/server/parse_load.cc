@@ -0,0 +1,221 @@
+#include "../src/tool_util.h"
+#include "protocol.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace nemo {
+
+typedef std::chrono::steady_clock Clock;
+
+struct LoadOptions {
+  std::string socket_path = "/tmp/nemo_parse.sock";
+  uint32_t connections = 4;
+  uint32_t requests = 1000;
+  uint32_t pipeline = 8;          // 每个连接未收到响应的请求数上限
+  protocol::ParseRequest params;  // 请求的解析参数
+  std::string corpus;
+};
+
+// 与 performance_test 相同的句子
+const std::vector<std::string> kDefaultSentences = {
+    "the apple is red", "the cat is very happy", "a dog runs quickly",
+    "a star twinkles in the sky", "a man reads a book", "the bird sings a song",
+    "the children play a game", "the cat chases the mouse",
+    "an algorithm solves a complex problem", "the teacher has an idea",
+    "a student asked a question", "tall trees sway gently in the breeze",
+    "the sun rises over the calm sea", "the cat quickly jumps over the small fence",
+    "a boy writes a letter to a dear friend", "the chef cooks food in the kitchen",
+    "the dog happily runs around the big yard",
+    "the boat sails smoothly across the blue lake", "the old man walks in the park",
+    "the girl saw a cat"};
+
+// 读取语料：句子以 '.' 或换行分隔（例如 words/sentences.txt）
+std::vector<std::string> LoadCorpus(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  std::vector<std::string> sentences;
+  std::string sentence;
+  for (char c : content.str() + "\n") {
+    if (c == '.' || c == '\n') {
+      if (sentence.find_first_not_of(" \t\r") != std::string::npos) sentences.push_back(sentence);
+      sentence.clear();
+    } else {
+      sentence.push_back(c);
+    }
+  }
+  return sentences;
+}
+
+int Connect(const std::string& path) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+    perror(path.c_str());
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool SendAll(int fd, const std::string& data) {
+  for (size_t sent = 0; sent < data.size();) {
+    ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    sent += n;
+  }
+  return true;
+}
+
+// 一个连接的统计
+struct ConnectionResult {
+  std::vector<double> latencies_ms;
+  uint32_t errors = 0;
+  bool failed = false;
+};
+
+/**
+ * @brief 在一个连接上发送 count 个请求：保持最多 pipeline 个未完成的请求，
+ * 每收到一个响应就补发一个。延迟从请求写入 socket 之前算到读出响应为止。
+ */
+ConnectionResult RunConnection(const LoadOptions& options,
+                               const std::vector<std::string>& sentences,
+                               uint32_t first, uint32_t count) {
+  ConnectionResult result;
+  int fd = Connect(options.socket_path);
+  if (fd < 0) {
+    result.failed = true;
+    return result;
+  }
+  std::vector<Clock::time_point> sent_at(count);
+  uint32_t sent = 0, received = 0;
+  std::string input;
+  std::vector<char> buffer(1 << 16);
+  while (received < count) {
+    std::string output;
+    for (; sent < count && sent - received < options.pipeline; ++sent) {
+      protocol::ParseRequest request = options.params;
+      request.id = sent;
+      request.sentence = sentences[(first + sent) % sentences.size()];
+      sent_at[sent] = Clock::now();
+      protocol::AppendRequest(request, output);
+    }
+    if (!output.empty() && !SendAll(fd, output)) {
+      perror("send");
+      result.failed = true;
+      break;
+    }
+    ssize_t n = read(fd, buffer.data(), buffer.size());
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      fprintf(stderr, "Connection closed by server\n");
+      result.failed = true;
+      break;
+    }
+    input.append(buffer.data(), n);
+    size_t consumed = 0;
+    protocol::ParseResponse response;
+    while (size_t size = protocol::ReadResponse(std::string_view(input).substr(consumed), response)) {
+      consumed += size;
+      if (response.id >= count) throw std::runtime_error("Unexpected response id");
+      result.latencies_ms.push_back(
+          std::chrono::duration<double, std::milli>(Clock::now() - sent_at[response.id]).count());
+      if (response.status != protocol::kOk) {
+        if (result.errors++ == 0) fprintf(stderr, "Error: %s\n", response.error.c_str());
+      }
+      ++received;
+    }
+    input.erase(0, consumed);
+  }
+  close(fd);
+  return result;
+}
+
+double Percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0;
+  size_t index = std::min(sorted.size() - 1, size_t(q * sorted.size()));
+  return sorted[index];
+}
+
+}  // namespace nemo
+
+// parse_server 的压测客户端：多个连接并发、每个连接 pipelining 发送请求，
+// 输出吞吐量和延迟分位数
+int main(int argc, char** argv) {
+  using namespace nemo;
+  LoadOptions options;
+  const bool parsed = ParseOptions(argc, argv, 1, [&](const std::string& key,
+                                                      const std::string& value) {
+    const uint32_t number = strtoul(value.c_str(), nullptr, 10);
+    if (key == "socket") options.socket_path = value;
+    else if (key == "connections") options.connections = std::max(1u, number);
+    else if (key == "requests") options.requests = number;
+    else if (key == "pipeline") options.pipeline = std::max(1u, number);
+    else if (key == "corpus") options.corpus = value;
+    else if (key == "p") options.params.p = atof(value.c_str());
+    else if (key == "LEX_k") options.params.LEX_k = number;
+    else if (key == "project_rounds") options.params.project_rounds = number;
+    else if (key == "readout_method") options.params.readout_method = number;
+    else return false;
+    return true;
+  });
+  if (!parsed) {
+    fprintf(stderr, "Usage: %s [--socket=PATH] [--connections=N] [--requests=N]\n"
+            "          [--pipeline=N] [--corpus=FILE] [--p=P] [--LEX_k=K]\n"
+            "          [--project_rounds=N] [--readout_method=N]\n", argv[0]);
+    return 1;
+  }
+  std::vector<std::string> sentences =
+      options.corpus.empty() ? kDefaultSentences : LoadCorpus(options.corpus);
+  if (sentences.empty()) {
+    fprintf(stderr, "No sentences in %s\n", options.corpus.c_str());
+    return 1;
+  }
+
+  std::vector<ConnectionResult> results(options.connections);
+  const auto start = Clock::now();
+  try {
+    ParallelFor(options.connections, options.connections, [&](size_t c) {
+      // 请求平均分给各个连接
+      const uint32_t first = uint64_t(options.requests) * c / options.connections;
+      const uint32_t last = uint64_t(options.requests) * (c + 1) / options.connections;
+      results[c] = RunConnection(options, sentences, first, last - first);
+    });
+  } catch (const std::exception& e) {
+    fprintf(stderr, "Connection failed: %s\n", e.what());
+    return 1;
+  }
+  const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> latencies;
+  uint32_t errors = 0;
+  bool failed = false;
+  for (const ConnectionResult& result : results) {
+    latencies.insert(latencies.end(), result.latencies_ms.begin(), result.latencies_ms.end());
+    errors += result.errors;
+    failed |= result.failed;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf("requests     %zu (%u errors)\n", latencies.size(), errors);
+  printf("connections  %u, pipeline %u\n", options.connections, options.pipeline);
+  printf("throughput   %.1f requests/s\n", latencies.size() / seconds);
+  printf("latency ms   p50 %.2f  p99 %.2f  max %.2f\n", Percentile(latencies, 0.5),
+         Percentile(latencies, 0.99), latencies.empty() ? 0 : latencies.back());
+  return failed ? 1 : 0;
+}
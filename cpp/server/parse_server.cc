@@ -0,0 +1,506 @@
+#include "../src/parse_cache.h"
+#include "../src/parser.h"
+#include "../src/tool_util.h"
+#include "protocol.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace nemo {
+
+volatile sig_atomic_t stop_requested = 0;
+
+void OnStopSignal(int) { stop_requested = 1; }
+
+struct ServerOptions {
+  std::string socket_path = "/tmp/nemo_parse.sock";
+  unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  uint32_t max_inflight = 64;              // 每个连接同时在解析的请求数
+  size_t max_output_bytes = 4 << 20;       // 每个连接未发送的响应字节数
+  uint32_t max_templates = 8;              // 每个 worker 保留的 brain 模板数
+  size_t cache_bytes = 0;                  // 解析结果缓存的内存预算，0 表示不使用缓存
+  std::string cache_file;                  // 启动时加载、退出时保存缓存的文件
+  size_t brain_budget_bytes = 0;           // 每个请求的 brain 的内存预算，0 表示不限制
+};
+
+// 一个待解析的请求，connection 是连接的编号
+struct Job {
+  uint64_t connection;
+  protocol::ParseRequest request;
+};
+
+// 一个已经编码好的响应帧
+struct Completion {
+  uint64_t connection;
+  std::string frame;
+};
+
+/**
+ * @brief 解析线程池。每个 worker 为每组 (p, LEX_k) 保留一个还没有解析过句子的
+ * EnglishParserBrain 作为模板，请求到来时复制模板而不是重新构造 brain；复制出的
+ * brain 与 parse() 构造的完全相同（包括随机数状态），结果也相同。
+ * 有缓存时先查缓存，所有 worker 共用一个缓存。
+ * 完成的响应放入完成队列，并通过 wake_fd（eventfd）通知 I/O 线程。
+ */
+class WorkerPool {
+ public:
+  WorkerPool(const ServerOptions& options, ParseCache* cache, int wake_fd)
+      : max_templates_(options.max_templates),
+        brain_budget_bytes_(options.brain_budget_bytes), cache_(cache), wake_fd_(wake_fd) {
+    for (unsigned i = 0; i < options.threads; ++i) {
+      workers_.emplace_back([this] { Run(); });
+    }
+  }
+
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    jobs_ready_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  void Submit(Job job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    jobs_ready_.notify_one();
+  }
+
+  void TakeCompletions(std::vector<Completion>& completions) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    completions.swap(completions_);
+    completions_.clear();
+  }
+
+ private:
+  typedef std::pair<float, uint32_t> TemplateKey;  // (p, LEX_k)
+
+  struct Templates {
+    std::map<TemplateKey, std::unique_ptr<EnglishParserBrain>> brains;
+    std::deque<TemplateKey> order;  // 创建的顺序，超过 max_templates 时丢弃最早的
+  };
+
+  const EnglishParserBrain& Template(const protocol::ParseRequest& request,
+                                     Templates& templates) {
+    const TemplateKey key(request.p, request.LEX_k);
+    auto it = templates.brains.find(key);
+    if (it != templates.brains.end()) return *it->second;
+    if (templates.order.size() >= max_templates_) {
+      templates.brains.erase(templates.order.front());
+      templates.order.pop_front();
+    }
+    ParserOptions options;
+    options.p = request.p;
+    options.LEX_k = request.LEX_k;
+    auto brain = std::make_unique<EnglishParserBrain>(
+        options.p, options.non_LEX_n, options.non_LEX_k, options.LEX_k,
+        options.default_beta, options.LEX_beta, options.recurrent_beta,
+        options.interarea_beta, options.verbose, nullptr, options.seed);
+    // 复制出的 brain 继承预算，超出时该请求返回错误而不是耗尽 worker 的内存
+    brain->SetMemoryBudget(brain_budget_bytes_);
+    templates.order.push_back(key);
+    return *(templates.brains[key] = std::move(brain));
+  }
+
+  protocol::ParseResponse Parse(const protocol::ParseRequest& request,
+                                Templates& templates) {
+    protocol::ParseResponse response;
+    response.id = request.id;
+    try {
+      if (!(request.p > 0 && request.p <= 1) || request.LEX_k == 0 ||
+          request.LEX_k > 1000 || request.project_rounds > 1000) {
+        throw std::runtime_error("Invalid parse parameters");
+      }
+      ParseCacheKey key;
+      const bool cacheable =
+          cache_ && MakeParseCacheKey(*DefaultLexicon(), request.sentence, request.p,
+                                      request.LEX_k, request.project_rounds,
+                                      request.readout_method, key);
+      if (cacheable && cache_->Get(key, response.dependencies)) return response;
+      IncrementalParser parser(Template(request, templates), request.project_rounds,
+                               /*verbose=*/false, request.readout_method);
+      std::vector<std::string_view> words;
+      Tokenize(request.sentence, words);
+      for (std::string_view word : words) parser.feed(word);
+      response.dependencies = parser.finish();
+      if (cacheable) cache_->Put(key, response.dependencies);
+    } catch (const std::exception& e) {
+      response.status = protocol::kError;
+      response.error = e.what();
+    }
+    return response;
+  }
+
+  void Run() {
+    Templates templates;
+    // 预先构造默认参数的模板
+    Template(protocol::ParseRequest(), templates);
+    for (;;) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        jobs_ready_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+        if (stopping_) return;
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      Completion completion{job.connection, {}};
+      try {
+        protocol::AppendResponse(Parse(job.request, templates), completion.frame);
+      } catch (const std::exception& e) {
+        // 响应无法编码（例如超过 kMaxFrameBytes）时返回简短的错误帧，不能让异常终止 worker
+        protocol::ParseResponse error;
+        error.id = job.request.id;
+        error.status = protocol::kError;
+        error.error = std::string("Failed to encode response: ") + e.what();
+        completion.frame.clear();
+        protocol::AppendResponse(error, completion.frame);
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions_.push_back(std::move(completion));
+      }
+      const uint64_t one = 1;
+      if (write(wake_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) perror("eventfd write");
+    }
+  }
+
+  const uint32_t max_templates_;
+  const size_t brain_budget_bytes_;
+  ParseCache* const cache_;
+  const int wake_fd_;
+  std::mutex mutex_;
+  std::condition_variable jobs_ready_;
+  std::deque<Job> jobs_;
+  std::vector<Completion> completions_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief 单线程的 epoll 事件循环，负责接受连接、读取请求帧和写回响应帧。
+ *
+ * 背压：一个连接正在解析的请求达到 max_inflight，或未发送的响应超过
+ * max_output_bytes 时，暂停读取该连接，已经收到的数据留在输入缓冲区中，
+ * 客户端的写入最终被内核的 socket 缓冲区阻塞；请求完成、响应发送后恢复读取。
+ */
+class Server {
+ public:
+  explicit Server(const ServerOptions& options) : options_(options) {}
+
+  ~Server() {
+    for (auto& [id, connection] : connections_) close(connection.fd);
+    if (listen_fd_ >= 0) {
+      close(listen_fd_);
+      unlink(options_.socket_path.c_str());
+    }
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+  }
+
+  int Run() {
+    if (!Listen()) return 1;
+    std::unique_ptr<ParseCache> cache;
+    if (options_.cache_bytes > 0) {
+      cache = std::make_unique<ParseCache>(options_.cache_bytes);
+      if (!options_.cache_file.empty()) {
+        try {
+          size_t loaded = cache->Load(options_.cache_file, DefaultLexicon()->Fingerprint());
+          fprintf(stderr, "Loaded %zu cached parses from %s\n", loaded, options_.cache_file.c_str());
+        } catch (const std::exception& e) {
+          fprintf(stderr, "Ignoring cache file: %s\n", e.what());
+        }
+      }
+    }
+    WorkerPool pool(options_, cache.get(), wake_fd_);
+    pool_ = &pool;
+    fprintf(stderr, "Listening on %s with %u workers\n", options_.socket_path.c_str(),
+            options_.threads);
+    std::vector<epoll_event> events(64);
+    while (!stop_requested) {
+      int n = epoll_wait(epoll_fd_, events.data(), events.size(), -1);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        perror("epoll_wait");
+        break;
+      }
+      for (int i = 0; i < n; ++i) {
+        const uint64_t id = events[i].data.u64;
+        if (id == kListenId) {
+          Accept();
+        } else if (id == kWakeId) {
+          uint64_t count;
+          if (read(wake_fd_, &count, sizeof(count)) < 0 && errno != EAGAIN) perror("eventfd read");
+          DrainCompletions(pool);
+        } else {
+          auto it = connections_.find(id);
+          if (it == connections_.end()) continue;
+          if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            // 对端已经完全关闭，剩余的响应无法送达
+            Close(id);
+            continue;
+          }
+          if (events[i].events & EPOLLIN) ReadInput(id, it->second);
+          it = connections_.find(id);
+          if (it != connections_.end() && (events[i].events & EPOLLOUT)) Update(id, it->second);
+        }
+      }
+    }
+    fprintf(stderr, "Served %llu requests\n", (unsigned long long)served_);
+    pool_ = nullptr;
+    if (cache) {
+      ParseCache::Stats stats = cache->stats();
+      fprintf(stderr, "Cache: %llu hits, %llu misses, %llu evictions, %zu entries, %zu bytes\n",
+              (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+              (unsigned long long)stats.evictions, stats.entries, stats.bytes);
+      if (!options_.cache_file.empty()) {
+        try {
+          cache->Save(options_.cache_file, DefaultLexicon()->Fingerprint());
+        } catch (const std::exception& e) {
+          fprintf(stderr, "%s\n", e.what());
+        }
+      }
+    }
+    return 0;
+  }
+
+ private:
+  static constexpr uint64_t kListenId = 0;
+  static constexpr uint64_t kWakeId = 1;
+
+  struct Connection {
+    int fd;
+    std::string input;
+    std::string output;
+    size_t output_sent = 0;
+    uint32_t inflight = 0;
+    bool read_closed = false;
+    uint32_t events = 0;     // 当前注册的 epoll 事件
+  };
+
+  bool Listen() {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (options_.socket_path.size() >= sizeof(address.sun_path)) {
+      fprintf(stderr, "Socket path too long: %s\n", options_.socket_path.c_str());
+      return false;
+    }
+    strcpy(address.sun_path, options_.socket_path.c_str());
+    unlink(options_.socket_path.c_str());
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0 || bind(listen_fd_, (sockaddr*)&address, sizeof(address)) < 0 ||
+        listen(listen_fd_, 128) < 0) {
+      perror(options_.socket_path.c_str());
+      return false;
+    }
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (wake_fd_ < 0 || epoll_fd_ < 0) {
+      perror("epoll");
+      return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = kListenId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event);
+    event.data.u64 = kWakeId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+    return true;
+  }
+
+  void Accept() {
+    for (;;) {
+      int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) perror("accept");
+        return;
+      }
+      const uint64_t id = next_id_++;
+      Connection& connection = connections_[id];
+      connection.fd = fd;
+      connection.events = EPOLLIN;
+      epoll_event event{};
+      event.events = connection.events;
+      event.data.u64 = id;
+      epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event);
+    }
+  }
+
+  bool CanRead(const Connection& connection) const {
+    return !connection.read_closed && connection.inflight < options_.max_inflight &&
+           connection.output.size() - connection.output_sent < options_.max_output_bytes;
+  }
+
+  void ReadInput(uint64_t id, Connection& connection) {
+    char buffer[1 << 16];
+    while (CanRead(connection)) {
+      ssize_t n = read(connection.fd, buffer, sizeof(buffer));
+      if (n > 0) {
+        connection.input.append(buffer, n);
+        if (!Dispatch(id, connection)) return;
+        continue;
+      }
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      if (n < 0 && errno == EINTR) continue;
+      // 对端关闭了写端（或出错）：处理完已经收到的请求后关闭连接
+      connection.read_closed = true;
+    }
+    Update(id, connection);
+  }
+
+  // 把输入缓冲区中完整的请求交给线程池，直到 inflight 达到上限；格式错误时关闭连接并返回 false
+  bool Dispatch(uint64_t id, Connection& connection) {
+    size_t consumed = 0;
+    try {
+      while (connection.inflight < options_.max_inflight) {
+        Job job{id, {}};
+        size_t size = protocol::ReadRequest(
+            std::string_view(connection.input).substr(consumed), job.request);
+        if (size == 0) break;
+        consumed += size;
+        ++connection.inflight;
+        pool_->Submit(std::move(job));
+      }
+    } catch (const std::exception& e) {
+      fprintf(stderr, "Closing connection %llu: %s\n", (unsigned long long)id, e.what());
+      Close(id);
+      return false;
+    }
+    connection.input.erase(0, consumed);
+    return true;
+  }
+
+  void DrainCompletions(WorkerPool& pool) {
+    std::vector<Completion> completions;
+    pool.TakeCompletions(completions);
+    for (Completion& completion : completions) {
+      ++served_;
+      auto it = connections_.find(completion.connection);
+      if (it == connections_.end()) continue;  // 连接已经关闭
+      Connection& connection = it->second;
+      --connection.inflight;
+      connection.output.append(completion.frame);
+    }
+    for (Completion& completion : completions) {
+      auto it = connections_.find(completion.connection);
+      if (it == connections_.end()) continue;
+      // 已经缓冲的请求可能因为 inflight 的上限还没有分发
+      if (!Dispatch(it->first, it->second)) continue;
+      Update(it->first, it->second);
+    }
+  }
+
+  // 发送缓冲的响应，并根据连接的状态更新 epoll 的事件或关闭连接
+  void Update(uint64_t id, Connection& connection) {
+    while (connection.output_sent < connection.output.size()) {
+      ssize_t n = send(connection.fd, connection.output.data() + connection.output_sent,
+                       connection.output.size() - connection.output_sent, MSG_NOSIGNAL);
+      if (n > 0) {
+        connection.output_sent += n;
+      } else if (n < 0 && errno == EINTR) {
+        continue;
+      } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        break;
+      } else {
+        Close(id);
+        return;
+      }
+    }
+    if (connection.output_sent == connection.output.size()) {
+      connection.output.clear();
+      connection.output_sent = 0;
+    }
+    const bool pending_output = !connection.output.empty();
+    if (connection.read_closed && connection.inflight == 0 && !pending_output) {
+      Close(id);
+      return;
+    }
+    const uint32_t events = (CanRead(connection) ? uint32_t(EPOLLIN) : 0u) |
+                            (pending_output ? uint32_t(EPOLLOUT) : 0u);
+    if (events != connection.events) {
+      epoll_event event{};
+      event.events = events;
+      event.data.u64 = id;
+      epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection.fd, &event);
+      connection.events = events;
+    }
+  }
+
+  void Close(uint64_t id) {
+    auto it = connections_.find(id);
+    if (it == connections_.end()) return;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, it->second.fd, nullptr);
+    close(it->second.fd);
+    connections_.erase(it);
+  }
+
+  const ServerOptions options_;
+  int listen_fd_ = -1;
+  int wake_fd_ = -1;
+  int epoll_fd_ = -1;
+  WorkerPool* pool_ = nullptr;
+  uint64_t next_id_ = 2;
+  uint64_t served_ = 0;
+  std::unordered_map<uint64_t, Connection> connections_;
+};
+
+}  // namespace nemo
+
+// 常驻的解析服务：在 Unix domain socket 上接收 protocol.h 格式的请求，
+// 由线程池解析后返回依赖集合。SIGINT/SIGTERM 时退出并删除 socket 文件
+int main(int argc, char** argv) {
+  using namespace nemo;
+  ServerOptions options;
+  const bool parsed = ParseOptions(argc, argv, 1, [&](const std::string& key,
+                                                      const std::string& value) {
+    const unsigned long number = strtoul(value.c_str(), nullptr, 10);
+    if (key == "socket") options.socket_path = value;
+    else if (key == "threads") options.threads = std::max(1ul, number);
+    else if (key == "max_inflight") options.max_inflight = std::max(1ul, number);
+    else if (key == "max_output_bytes") options.max_output_bytes = std::max(1ul, number);
+    else if (key == "max_templates") options.max_templates = std::max(1ul, number);
+    else if (key == "cache_bytes") options.cache_bytes = number;
+    else if (key == "cache_file") options.cache_file = value;
+    else if (key == "brain_budget_mb") options.brain_budget_bytes = size_t(number) << 20;
+    else return false;
+    return true;
+  });
+  if (!parsed) {
+    fprintf(stderr, "Usage: %s [--socket=PATH] [--threads=N] [--max_inflight=N]\n"
+            "          [--max_output_bytes=N] [--max_templates=N]\n"
+            "          [--cache_bytes=N] [--cache_file=PATH] [--brain_budget_mb=N]\n",
+            argv[0]);
+    return 1;
+  }
+  struct sigaction action{};
+  action.sa_handler = OnStopSignal;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  Server server(options);
+  return server.Run();
+}
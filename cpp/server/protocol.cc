@@ -0,0 +1,166 @@
+#include "protocol.h"
+
+#include <string.h>
+
+#include <stdexcept>
+
+namespace nemo {
+namespace protocol {
+
+namespace {
+
+template <typename T>
+void Put(T value, std::string& out) {
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    out.push_back(char(uint8_t(value >> (8 * i))));
+  }
+}
+
+void PutFloat(float value, std::string& out) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  Put(bits, out);
+}
+
+// 顺序读取一个帧的内容，越界时抛出异常
+class Reader {
+ public:
+  explicit Reader(std::string_view data) : data_(data) {}
+
+  template <typename T>
+  T Get() {
+    Need(sizeof(T));
+    T value = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      value |= T(uint8_t(data_[pos_ + i])) << (8 * i);
+    }
+    pos_ += sizeof(T);
+    return value;
+  }
+
+  float GetFloat() {
+    uint32_t bits = Get<uint32_t>();
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+  }
+
+  std::string_view GetBytes(size_t size) {
+    Need(size);
+    std::string_view bytes = data_.substr(pos_, size);
+    pos_ += size;
+    return bytes;
+  }
+
+  std::string_view Rest() { return GetBytes(data_.size() - pos_); }
+  bool Done() const { return pos_ == data_.size(); }
+
+ private:
+  void Need(size_t size) const {
+    if (data_.size() - pos_ < size) throw std::runtime_error("Truncated frame");
+  }
+
+  std::string_view data_;
+  size_t pos_ = 0;
+};
+
+// 在 out 中为帧的长度预留位置，写完内容后由 FinishFrame 填写
+size_t StartFrame(std::string& out) {
+  size_t start = out.size();
+  Put(uint32_t(0), out);
+  return start;
+}
+
+void FinishFrame(size_t start, std::string& out) {
+  const size_t size = out.size() - start - sizeof(uint32_t);
+  if (size > kMaxFrameBytes) throw std::runtime_error("Frame too large");
+  for (size_t i = 0; i < sizeof(uint32_t); ++i) {
+    out[start + i] = char(uint8_t(size >> (8 * i)));
+  }
+}
+
+// 读出帧的内容（不含长度），不完整时返回 false
+bool FrameBody(std::string_view buffer, std::string_view& body) {
+  if (buffer.size() < sizeof(uint32_t)) return false;
+  const uint32_t size = Reader(buffer).Get<uint32_t>();
+  if (size > kMaxFrameBytes) throw std::runtime_error("Frame too large");
+  if (buffer.size() - sizeof(uint32_t) < size) return false;
+  body = buffer.substr(sizeof(uint32_t), size);
+  return true;
+}
+
+}  // namespace
+
+void AppendRequest(const ParseRequest& request, std::string& out) {
+  const size_t start = StartFrame(out);
+  Put(request.id, out);
+  PutFloat(request.p, out);
+  Put(request.LEX_k, out);
+  Put(request.project_rounds, out);
+  Put(request.readout_method, out);
+  out.append(request.sentence);
+  FinishFrame(start, out);
+}
+
+void AppendResponse(const ParseResponse& response, std::string& out) {
+  const size_t start = StartFrame(out);
+  Put(response.id, out);
+  Put(response.status, out);
+  if (response.status == kOk) {
+    Put(uint32_t(response.dependencies.size()), out);
+    for (const auto& dependency : response.dependencies) {
+      if (dependency.size() != 3) throw std::runtime_error("Dependency is not a triple");
+      for (const std::string& word : dependency) {
+        if (word.size() > UINT16_MAX) throw std::runtime_error("Word too long");
+        Put(uint16_t(word.size()), out);
+        out.append(word);
+      }
+    }
+  } else if (response.error.size() > kMaxErrorBytes) {
+    out.append(response.error, 0, kMaxErrorBytes - 3);
+    out.append("...");
+  } else {
+    out.append(response.error);
+  }
+  FinishFrame(start, out);
+}
+
+size_t ReadRequest(std::string_view buffer, ParseRequest& request) {
+  std::string_view body;
+  if (!FrameBody(buffer, body)) return 0;
+  Reader reader(body);
+  request.id = reader.Get<uint64_t>();
+  request.p = reader.GetFloat();
+  request.LEX_k = reader.Get<uint32_t>();
+  request.project_rounds = reader.Get<uint32_t>();
+  request.readout_method = reader.Get<uint8_t>();
+  request.sentence = reader.Rest();
+  return sizeof(uint32_t) + body.size();
+}
+
+size_t ReadResponse(std::string_view buffer, ParseResponse& response) {
+  std::string_view body;
+  if (!FrameBody(buffer, body)) return 0;
+  Reader reader(body);
+  response.id = reader.Get<uint64_t>();
+  response.status = reader.Get<uint8_t>();
+  response.dependencies.clear();
+  response.error.clear();
+  if (response.status == kOk) {
+    const uint32_t count = reader.Get<uint32_t>();
+    for (uint32_t i = 0; i < count; ++i) {
+      std::vector<std::string> dependency(3);
+      for (std::string& word : dependency) {
+        word = reader.GetBytes(reader.Get<uint16_t>());
+      }
+      response.dependencies.insert(std::move(dependency));
+    }
+    if (!reader.Done()) throw std::runtime_error("Trailing bytes in response");
+  } else {
+    response.error = reader.Rest();
+  }
+  return sizeof(uint32_t) + body.size();
+}
+
+}  // namespace protocol
+}  // namespace nemo
@@ -0,0 +1,64 @@
+#ifndef NEMO_SERVER_PROTOCOL_H_
+#define NEMO_SERVER_PROTOCOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nemo {
+namespace protocol {
+
+/*
+parse_server 的帧格式，所有整数为小端：
+
+  请求：u32 长度 | u64 id | f32 p | u32 LEX_k | u32 project_rounds | u8 readout_method | 句子（UTF-8）
+  响应：u32 长度 | u64 id | u8 状态 | 内容
+        状态为 kOk 时内容为 u32 依赖数，每个依赖为 3 个 (u16 长度 | 字节) 字符串；
+        状态为 kError 时内容为错误信息
+
+长度不包括自身的 4 个字节。同一个连接上可以连续发送多个请求而不等待响应（pipelining），
+响应按完成的顺序返回，由 id 对应到请求。
+*/
+constexpr uint32_t kMaxFrameBytes = 1 << 20;
+// 错误信息的最大字节数，更长的截断并以 "..." 结尾。错误信息可能包含请求中的单词，
+// 截断后错误帧总是远小于 kMaxFrameBytes
+constexpr size_t kMaxErrorBytes = 512;
+
+enum Status : uint8_t {
+  kOk = 0,
+  kError = 1,
+};
+
+struct ParseRequest {
+  uint64_t id = 0;
+  float p = 0.1f;
+  uint32_t LEX_k = 20;
+  uint32_t project_rounds = 20;
+  uint8_t readout_method = 2;
+  std::string sentence;
+};
+
+struct ParseResponse {
+  uint64_t id = 0;
+  uint8_t status = kOk;
+  std::set<std::vector<std::string>> dependencies;
+  std::string error;
+};
+
+// 把一个完整的帧追加到 out
+void AppendRequest(const ParseRequest& request, std::string& out);
+void AppendResponse(const ParseResponse& response, std::string& out);
+
+// 从 buffer 开头读出一个帧，返回帧的总字节数；数据还不完整时返回 0。
+// 帧的格式错误或超过 kMaxFrameBytes 时抛出 std::runtime_error
+size_t ReadRequest(std::string_view buffer, ParseRequest& request);
+size_t ReadResponse(std::string_view buffer, ParseResponse& response);
+
+}  // namespace protocol
+}  // namespace nemo
+
+#endif  // NEMO_SERVER_PROTOCOL_H_
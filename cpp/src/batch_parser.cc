@@ -0,0 +1,109 @@
+#include "batch_parser.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <utility>
+
+#include "tool_util.h"
+
+namespace nemo {
+namespace {
+
+// 一组已经处理的前缀相同的句子和它们共用的解析状态
+struct PrefixGroup {
+  std::unique_ptr<IncrementalParser> parser;
+  std::vector<size_t> members;  // 句子下标
+};
+
+}  // namespace
+
+std::vector<BatchParseResult> ParseBatch(const std::vector<std::string>& sentences,
+                                         const ParserOptions& options, unsigned threads,
+                                         std::shared_ptr<const Lexicon> lexicon,
+                                         BatchParseStats* stats) {
+  if (!lexicon) lexicon = DefaultLexicon();
+  if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<BatchParseResult> results(sentences.size());
+  BatchParseStats batch_stats;
+
+  std::vector<std::vector<uint32_t>> word_ids(sentences.size());
+  std::vector<size_t> valid;
+  std::vector<std::string_view> words;
+  for (size_t i = 0; i < sentences.size(); ++i) {
+    Tokenize(sentences[i], words);
+    for (std::string_view word : words) {
+      uint32_t id = lexicon->Find(word);
+      if (id == Lexicon::kNotFound) {
+        results[i].error = "Unknown word: " + std::string(word);
+        break;
+      }
+      word_ids[i].push_back(id);
+    }
+    if (results[i].error.empty()) {
+      valid.push_back(i);
+      batch_stats.words += word_ids[i].size();
+    }
+  }
+
+  std::vector<PrefixGroup> groups;
+  if (!valid.empty()) {
+    groups.push_back({std::make_unique<IncrementalParser>(options, lexicon), std::move(valid)});
+  }
+  for (size_t position = 0; !groups.empty(); ++position) {
+    // 按下一个单词把每组分开；没有下一个单词的句子在这里结束
+    std::vector<PrefixGroup> next_groups;
+    std::vector<std::pair<size_t, uint32_t>> steps;  // (next_groups 下标, 要处理的单词)
+    std::vector<size_t> source;                      // next_groups 中每组从哪一组复制
+    std::vector<std::vector<size_t>> finished(groups.size());
+    for (size_t g = 0; g < groups.size(); ++g) {
+      std::map<uint32_t, std::vector<size_t>> by_word;
+      for (size_t member : groups[g].members) {
+        if (position == word_ids[member].size()) {
+          finished[g].push_back(member);
+        } else {
+          by_word[word_ids[member][position]].push_back(member);
+        }
+      }
+      for (auto& [word_id, members] : by_word) {
+        steps.emplace_back(next_groups.size(), word_id);
+        source.push_back(g);
+        next_groups.push_back({nullptr, std::move(members)});
+      }
+    }
+    // 每组的最后一个分支直接接管原来的状态，其余的分支复制
+    std::vector<size_t> last_branch(groups.size(), SIZE_MAX);
+    for (size_t i = 0; i < source.size(); ++i) last_branch[source[i]] = i;
+    // 相同的句子只 finish 一次；没有分支继续的组直接在原来的状态上 finish
+    ParallelFor(groups.size(), threads, [&](size_t g) {
+      if (finished[g].empty()) return;
+      std::set<std::vector<std::string>> dependencies;
+      if (last_branch[g] == SIZE_MAX) {
+        dependencies = groups[g].parser->finish();
+      } else {
+        dependencies = IncrementalParser(*groups[g].parser).finish();
+      }
+      for (size_t member : finished[g]) results[member].dependencies = dependencies;
+    });
+    ParallelFor(steps.size(), threads, [&](size_t i) {
+      PrefixGroup& group = next_groups[steps[i].first];
+      const size_t g = source[i];
+      if (last_branch[g] != i) {
+        group.parser = std::make_unique<IncrementalParser>(*groups[g].parser);
+      }
+    });
+    for (size_t g = 0; g < groups.size(); ++g) {
+      if (last_branch[g] != SIZE_MAX) next_groups[last_branch[g]].parser = std::move(groups[g].parser);
+    }
+    ParallelFor(steps.size(), threads, [&](size_t i) {
+      next_groups[steps[i].first].parser->feed_id(steps[i].second);
+    });
+    batch_stats.words_simulated += steps.size();
+    batch_stats.max_states = std::max<uint32_t>(batch_stats.max_states, next_groups.size());
+    groups = std::move(next_groups);
+  }
+  if (stats) *stats = batch_stats;
+  return results;
+}
+
+}  // namespace nemo
@@ -0,0 +1,49 @@
+#ifndef NEMO_BATCH_PARSER_H_
+#define NEMO_BATCH_PARSER_H_
+
+#include "parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace nemo {
+
+// 一个句子的解析结果；error 非空时解析失败（例如有未知单词）
+struct BatchParseResult {
+  std::set<std::vector<std::string>> dependencies;
+  std::string error;
+};
+
+// ParseBatch 的统计
+struct BatchParseStats {
+  uint64_t words = 0;            // 所有句子的单词数之和
+  uint64_t words_simulated = 0;  // 实际模拟的单词数：每个不同的前缀只模拟一次
+  uint32_t max_states = 0;       // 同时存在的解析状态数的最大值
+};
+
+/**
+ * @brief 同时解析一批句子。所有句子从同一个初始 brain 出发逐词同步前进：
+ * 开头单词相同的句子共用一个解析状态，每个不同的前缀只模拟一次，单词不同时
+ * 复制状态分开继续。每一步中不同的状态相互独立，由 threads 个线程并行处理。
+ * 结果与逐句调用 parse(sentence, options, lexicon) 相同，顺序与 sentences 相同。
+ *
+ * @param sentences: 句子
+ * @param options: 解析参数
+ * @param threads: 线程数，0 表示使用所有核
+ * @param lexicon: 词表，默认为内置词表
+ * @param stats: 输出统计，可以为 nullptr
+ */
+std::vector<BatchParseResult> ParseBatch(const std::vector<std::string>& sentences,
+                                         const ParserOptions& options = ParserOptions(),
+                                         unsigned threads = 0,
+                                         std::shared_ptr<const Lexicon> lexicon = nullptr,
+                                         BatchParseStats* stats = nullptr);
+
+}  // namespace nemo
+
+#endif  // NEMO_BATCH_PARSER_H_
@@ -10,10 +10,14 @@
 #include <map>
 #include <random>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "sampling.h"
+
 namespace nemo {
 namespace {
 
@@ -39,20 +43,24 @@ float BinomQuantile(uint32_t k, float p, float percent) {
 }
 
 /**
- * @brief 从截断正态分布中采样。
+ * @brief 从截断正态分布 N(0, 1) | x >= a 中一次采样 n 个值。
+ * 分布对象和参数只构造一次，由全部样本共享。
  * 
  * @tparam Trng: 随机数生成器
  * @param a: 截断点
+ * @param n: 样本数量
  * @param rng: 随机数生成器
- * @return float: 采样值
+ * @param samples: 输出，采样值（会先被清空）
  */
 template<typename Trng>
-float TruncatedNorm(float a, Trng& rng) {
+void TruncatedNorm(float a, uint32_t n, Trng& rng, std::vector<float>& samples) {
+  samples.clear();
+  samples.reserve(n);
   if (a <= 0.0f) {
     std::normal_distribution<float> norm(0.0f, 1.0f);
-    for (;;) {
+    while (samples.size() < n) {
       const float x = norm(rng);
-      if (x >= a) return x;
+      if (x >= a) samples.push_back(x);
     }
   } else {
     // Exponential accept-reject algorithm from Robert,
@@ -60,15 +68,54 @@ float TruncatedNorm(float a, Trng& rng) {
     const float alpha = (a + std::sqrt(a * a + 4)) * 0.5f;
     std::exponential_distribution<float> d(alpha);
     std::uniform_real_distribution<float> u(0.0f, 1.0f);
-    for (;;) {
+    while (samples.size() < n) {
       const float z = a + d(rng);
       const float dz = z - alpha;
       const float rho = std::exp(-0.5f * dz * dz);
-      if (u(rng) < rho) return z;
+      if (u(rng) < rho) samples.push_back(z);
     }
   }
 }
 
+// 新候选神经元的突触数近似分布 N(mu, stddev) 在 cutoff 以上的尾部
+struct CandidateParams {
+  float percent;
+  float cutoff;
+  float mu;
+  float stddev;
+  float a;        // 标准化后的截断点 (cutoff - mu) / stddev
+};
+
+/**
+ * @brief 计算（或从缓存中取出）新候选神经元的分布参数。BinomQuantile 的代价与
+ * cutoff 成正比，而同一组 (total_k, remaining_neurons, k, p) 在每个句子的解析中
+ * 都会反复出现，因此按线程缓存，每个线程最多保留 kMaxCachedParams 项。
+ * 
+ * @param total_k: 投射到该脑区的激活神经元总数
+ * @param remaining_neurons: 脑区中尚未使用的神经元数量
+ * @param k: 脑区的激活神经元数量
+ * @param p: 突触连接概率
+ * @return const CandidateParams&: 分布参数
+ */
+const CandidateParams& GetCandidateParams(uint32_t total_k,
+                                          uint32_t remaining_neurons,
+                                          uint32_t k, float p) {
+  constexpr size_t kMaxCachedParams = 1 << 16;
+  typedef std::tuple<uint32_t, uint32_t, uint32_t, float> Key;
+  thread_local std::map<Key, CandidateParams> cache;
+  const Key key(total_k, remaining_neurons, k, p);
+  auto it = cache.find(key);
+  if (it != cache.end()) return it->second;
+  if (cache.size() >= kMaxCachedParams) cache.clear();
+  CandidateParams params;
+  params.percent = (remaining_neurons - k) * 1.0f / remaining_neurons;
+  params.cutoff = BinomQuantile(total_k, p, params.percent);
+  params.mu = total_k * p;
+  params.stddev = std::sqrt(total_k * p * (1.0f - p));
+  params.a = (params.cutoff - params.mu) / params.stddev;
+  return cache.emplace(key, params).first->second;
+}
+
 /**
  * @brief 生成神经元的突触。
  * 
@@ -89,7 +136,7 @@ std::vector<Synapse> GenerateSynapses(uint32_t support, float p, Trng& rng) {
   // 预留 5% 的空间，避免频繁的重新分配内存
   synapses.reserve(support * p * 1.05);
   while (last < support) {
-    synapses.push_back({last, 1.0f});
+    synapses.push_back({last, kInitialWeight});
     last += 1 + std::floor(std::log(u(rng)) * scale);
   }
   return synapses;
@@ -101,16 +148,74 @@ std::vector<Synapse> GenerateSynapses(uint32_t support, float p, Trng& rng) {
  * @param activations: 激活的神经元
  * @param k: 选择的数量
  */
-void SelectTopK(std::vector<Synapse>& activations, uint32_t k) {
+void SelectTopK(std::vector<Activation>& activations, uint32_t k) {
   std::nth_element(activations.begin(), activations.begin() + k - 1,
                    activations.end(),
-                   [](const Synapse& a, const Synapse& b) {
+                   [](const Activation& a, const Activation& b) {
                      if (a.weight != b.weight) return a.weight > b.weight;
                      return a.neuron < b.neuron;
                    });
   activations.resize(k);
 }
 
+// 在有序的 values 中插入 x（已存在时不变）
+void InsertSorted(std::vector<uint32_t>& values, uint32_t x) {
+  auto it = std::lower_bound(values.begin(), values.end(), x);
+  if (it == values.end() || *it != x) values.insert(it, x);
+}
+
+// 从有序的 values 中删除 x（不存在时不变）
+void EraseSorted(std::vector<uint32_t>& values, uint32_t x) {
+  auto it = std::lower_bound(values.begin(), values.end(), x);
+  if (it != values.end() && *it == x) values.erase(it);
+}
+
+// 突触是否从未增强（仍为初始权重）
+bool IsInitialWeight(const Synapse& s) {
+#ifdef NEMO_QUANTIZED_WEIGHTS
+  return s.level == kInitialWeight;
+#else
+  return s.weight == kInitialWeight;
+#endif
+}
+
+/**
+ * @brief 稠密 fiber 的输入累加：inputs[i] += rows[r][i]，r 按顺序。每次处理 4 行，
+ * inputs 只读写一次；每个元素的加法顺序与逐行累加相同，结果与稀疏的累加完全一致。
+ *
+ * @param rows: 激活的起始神经元的权重行
+ * @param n: 每行累加的元素数
+ * @param inputs: 输入，目标脑区每个神经元的突触输入
+ */
+void AccumulateDenseRows(const std::vector<const float*>& rows, uint32_t n,
+                         float* __restrict inputs) {
+  size_t r = 0;
+  for (; r + 4 <= rows.size(); r += 4) {
+    const float* __restrict a = rows[r];
+    const float* __restrict b = rows[r + 1];
+    const float* __restrict c = rows[r + 2];
+    const float* __restrict d = rows[r + 3];
+    for (uint32_t i = 0; i < n; ++i) {
+      inputs[i] = (((inputs[i] + a[i]) + b[i]) + c[i]) + d[i];
+    }
+  }
+  for (; r < rows.size(); ++r) {
+    const float* __restrict a = rows[r];
+    for (uint32_t i = 0; i < n; ++i) inputs[i] += a[i];
+  }
+}
+
+/**
+ * @brief 稠密 fiber 的赫布可塑性，对一行做秩 1 更新：row[i] = min(row[i] * scale[i], max_weight)，
+ * scale[i] 为 1 + beta（目标神经元 i 新激活）或 1。没有突触的位置为 0，保持不变。
+ */
+void PotentiateDenseRow(float* __restrict row, const float* __restrict scale,
+                        uint32_t n, float max_weight) {
+  for (uint32_t i = 0; i < n; ++i) {
+    row[i] = std::min(row[i] * scale[i], max_weight);
+  }
+}
+
 }  // namespace
 
 void Area::Print(std::string name) {
@@ -136,10 +241,14 @@ void Area::Print(std::string name) {
  * @param seed: 随机数种子
  */
 Brain::Brain(float p, float beta, float max_weight, uint32_t seed)
-    : rng_(seed), p_(p), beta_(beta), learn_rate_(1.0f + beta_),
+    : rng_(seed), seed_(seed), p_(p), beta_(beta),
       max_weight_(max_weight), areas_(1, Area(0, 0, 0)),
       fibers_(1, Fiber(0, 0)), incoming_fibers_(1), outgoing_fibers_(1),
-      area_name_(1, "INVALID") {}
+      area_name_(1, "INVALID"), incoming_stimulus_fibers_(1),
+      active_incoming_fibers_(1), active_incoming_stimulus_fibers_(1) {
+  SetLearnRate(fibers_[0], beta_);
+  fibers_[0].is_active = false;
+}
 
 /**
  * @brief 添加一个脑区。
@@ -167,6 +276,9 @@ Area& Brain::AddArea(const std::string& name, uint32_t n, uint32_t k,
   area_name_.push_back(name);
   incoming_fibers_.push_back({});
   outgoing_fibers_.push_back({});
+  incoming_stimulus_fibers_.push_back({});
+  active_incoming_fibers_.push_back({});
+  active_incoming_stimulus_fibers_.push_back({});
   if (recurrent) {
     // 添加一个从该脑区到自身的 fiber。
     AddFiber(name, name);
@@ -179,9 +291,17 @@ Area& Brain::AddArea(const std::string& name, uint32_t n, uint32_t k,
  * 
  * @param name: 脑区名称
  * @param k: 激活的神经元数量
+ * @param lazy: 是否按需生成 assembly，适用于很大的显式脑区（例如大词表的 LEX）
  */
-void Brain::AddStimulus(const std::string& name, uint32_t n, uint32_t k) {
-  AddArea(name, n, k, /*recurrent=*/false, /*is_explicit=*/true);
+void Brain::AddStimulus(const std::string& name, uint32_t n, uint32_t k,
+                        bool lazy) {
+  Area& area = AddArea(name, n, k, /*recurrent=*/false, /*is_explicit=*/true);
+  if (lazy) {
+    area.support = 0;
+    area.lazy = true;
+    area.slot_of_assembly.assign(n / k, UINT32_MAX);
+    memory_bytes_ += area.slot_of_assembly.size() * sizeof(uint32_t);
+  }
   ActivateArea(name, 0);
 }
 
@@ -198,20 +318,64 @@ void Brain::AddFiber(const std::string& from, const std::string& to,
   const Area& area_to = GetArea(to);
   uint32_t fiber_i = fibers_.size();
   Fiber fiber(area_from.index, area_to.index);
+  SetLearnRate(fiber, beta_);
   incoming_fibers_[area_to.index].push_back(fiber_i);
   outgoing_fibers_[area_from.index].push_back(fiber_i);
   for (uint32_t i = 0; i < area_from.support; ++i) {
     // 为每个激活的神经元生成到目标脑区的突触
-    std::vector<Synapse> synapses =
-        GenerateSynapses(area_to.support, p_, rng_);
-    fiber.outgoing_synapses.emplace_back(std::move(synapses));
+    AppendRow(fiber, GenerateSynapses(area_to.support, p_, rng_));
   }
+  // 新的 fiber 默认是激活的
+  fiber.is_active = false;
   fibers_.emplace_back(std::move(fiber));
+  SetFiberActive(fiber_i, true);
   if (bidirectional) {
     AddFiber(to, from);
   }
 }
 
+/**
+ * @brief 添加一个刺激：k 个总是同时激活的输入神经元。与 AddStimulus 不同，
+ * 刺激不是显式脑区，到目标脑区的突触只以每个目标神经元的权重之和存储。
+ * 
+ * @param name: 刺激名称，不能与脑区重名
+ * @param k: 激活的神经元数量
+ */
+void Brain::AddStimulusInput(const std::string& name, uint32_t k) {
+  if (area_by_name_.count(name) || stimulus_by_name_.count(name)) {
+    fprintf(stderr, "Name %s is already in use\n", name.c_str());
+    return;
+  }
+  stimulus_by_name_[name] = stimuli_.size();
+  stimuli_.emplace_back(stimuli_.size(), k);
+  stimulus_name_.push_back(name);
+}
+
+/**
+ * @brief 添加一个刺激到脑区的 fiber。目标脑区已有的每个神经元与刺激的 k 个
+ * 神经元各以概率 p 连接，权重之和即连接数。
+ * 
+ * @param stimulus: 刺激名称
+ * @param to: 目标脑区名称
+ */
+void Brain::AddStimulusFiber(const std::string& stimulus, const std::string& to) {
+  auto it = stimulus_by_name_.find(stimulus);
+  if (it == stimulus_by_name_.end()) {
+    fprintf(stderr, "Invalid stimulus name %s\n", stimulus.c_str());
+    return;
+  }
+  const Area& area_to = GetArea(to);
+  StimulusFiber fiber(it->second, area_to.index);
+  fiber.beta = beta_;
+  fiber.learn_rate = 1.0f + beta_;
+  std::binomial_distribution<> binom(stimuli_[it->second].k, p_);
+  fiber.weights.resize(area_to.support);
+  for (float& w : fiber.weights) w = binom(rng_);
+  memory_bytes_ += fiber.weights.size() * sizeof(float);
+  incoming_stimulus_fibers_[area_to.index].push_back(stimulus_fibers_.size());
+  stimulus_fibers_.emplace_back(std::move(fiber));
+}
+
 /**
  * @brief 通过名称获取脑区，可修改。
  * 
@@ -250,16 +414,7 @@ const Area& Brain::GetArea(const std::string& name) const {
  * @return Fiber&: fiber
  */
 Fiber& Brain::GetFiber(const std::string& from, const std::string& to) {
-  const Area& from_area = GetArea(from);
-  const Area& to_area = GetArea(to);
-  for (auto fiber_i : outgoing_fibers_[from_area.index]) {
-    Fiber& fiber = fibers_[fiber_i];
-    if (fiber.to_area == to_area.index) {
-      return fiber;
-    }
-  }
-  fprintf(stderr, "No fiber found from %s to %s\n", from.c_str(), to.c_str());
-  return fibers_[0];
+  return fibers_[FindFiber(from, to)];
 }
 
 /**
@@ -271,26 +426,82 @@ Fiber& Brain::GetFiber(const std::string& from, const std::string& to) {
  */
 const Fiber& Brain::GetFiber(const std::string& from,
                              const std::string& to) const{
+  return fibers_[FindFiber(from, to)];
+}
+
+/**
+ * @brief 通过名称查找 fiber 的下标。
+ * 
+ * @param from: 起始脑区名称
+ * @param to: 目标脑区名称
+ * @return uint32_t: fiber 下标，不存在时为 0（无效 fiber）
+ */
+uint32_t Brain::FindFiber(const std::string& from, const std::string& to) const {
   const Area& from_area = GetArea(from);
   const Area& to_area = GetArea(to);
   for (auto fiber_i : outgoing_fibers_[from_area.index]) {
-    const Fiber& fiber = fibers_[fiber_i];
-    if (fiber.to_area == to_area.index) {
-      return fiber;
+    if (fibers_[fiber_i].to_area == to_area.index) {
+      return fiber_i;
     }
   }
   fprintf(stderr, "No fiber found from %s to %s\n", from.c_str(), to.c_str());
-  return fibers_[0];
+  return 0;
 }
 
 /**
- * @brief 抑制所有脑区之间的连接。
+ * @brief 查找刺激到脑区的 fiber。
+ * 
+ * @param stimulus: 刺激名称
+ * @param to: 目标脑区名称
+ * @return StimulusFiber*: fiber，不存在时为 nullptr
+ */
+StimulusFiber* Brain::FindStimulusFiber(const std::string& stimulus,
+                                        const std::string& to) {
+  auto stimulus_it = stimulus_by_name_.find(stimulus);
+  auto area_it = area_by_name_.find(to);
+  if (stimulus_it == stimulus_by_name_.end() || area_it == area_by_name_.end()) {
+    return nullptr;
+  }
+  for (uint32_t fiber_i : incoming_stimulus_fibers_[area_it->second]) {
+    StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+    if (fiber.stimulus == stimulus_it->second) return &fiber;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief 通过名称获取刺激到脑区的 fiber，不可修改。
+ * 
+ * @param stimulus: 刺激名称
+ * @param to: 目标脑区名称
+ * @return const StimulusFiber&: fiber
+ */
+const StimulusFiber& Brain::GetStimulusFiber(const std::string& stimulus,
+                                             const std::string& to) const {
+  const StimulusFiber* fiber =
+      const_cast<Brain*>(this)->FindStimulusFiber(stimulus, to);
+  if (!fiber) {
+    throw std::out_of_range("No stimulus fiber from " + stimulus + " to " + to);
+  }
+  return *fiber;
+}
+
+/**
+ * @brief 抑制所有脑区之间以及刺激到脑区的连接。只访问激活的连接。
  * 
  */
 void Brain::InhibitAll() {
-  for (Fiber& fiber : fibers_) {
-    fiber.is_active = false;
+  for (uint32_t area_i : active_targets_) {
+    for (uint32_t fiber_i : active_incoming_fibers_[area_i]) {
+      fibers_[fiber_i].is_active = false;
+    }
+    for (uint32_t fiber_i : active_incoming_stimulus_fibers_[area_i]) {
+      stimulus_fibers_[fiber_i].is_active = false;
+    }
+    active_incoming_fibers_[area_i].clear();
+    active_incoming_stimulus_fibers_[area_i].clear();
   }
+  active_targets_.clear();
 }
 
 /**
@@ -300,7 +511,7 @@ void Brain::InhibitAll() {
  * @param to: 目标脑区名称
  */
 void Brain::InhibitFiber(const std::string& from, const std::string& to) {
-  GetFiber(from, to).is_active = false;
+  SetFiberActive(FindFiber(from, to), false);
 }
 
 /**
@@ -310,7 +521,151 @@ void Brain::InhibitFiber(const std::string& from, const std::string& to) {
  * @param to: 目标脑区名称
  */
 void Brain::ActivateFiber(const std::string& from, const std::string& to) {
-  GetFiber(from, to).is_active = true;
+  SetFiberActive(FindFiber(from, to), true);
+}
+
+/**
+ * @brief 修改 fiber 的激活状态，同时更新目标脑区激活的输入 fiber 和有激活输入的脑区。
+ * 
+ * @param fiber_i: fiber 下标，0（无效 fiber）时忽略
+ * @param active: 是否激活
+ */
+void Brain::SetFiberActive(uint32_t fiber_i, bool active) {
+  Fiber& fiber = fibers_[fiber_i];
+  if (fiber_i == 0 || fiber.is_active == active) return;
+  fiber.is_active = active;
+  if (active) {
+    InsertSorted(active_incoming_fibers_[fiber.to_area], fiber_i);
+  } else {
+    EraseSorted(active_incoming_fibers_[fiber.to_area], fiber_i);
+  }
+  UpdateActiveTarget(fiber.to_area);
+}
+
+/**
+ * @brief 修改刺激 fiber 的激活状态，同 SetFiberActive。
+ * 
+ * @param fiber_i: 刺激 fiber 下标
+ * @param active: 是否激活
+ */
+void Brain::SetStimulusFiberActive(uint32_t fiber_i, bool active) {
+  StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+  if (fiber.is_active == active) return;
+  fiber.is_active = active;
+  if (active) {
+    InsertSorted(active_incoming_stimulus_fibers_[fiber.to_area], fiber_i);
+  } else {
+    EraseSorted(active_incoming_stimulus_fibers_[fiber.to_area], fiber_i);
+  }
+  UpdateActiveTarget(fiber.to_area);
+}
+
+// 脑区有激活的输入时加入 active_targets_，否则移除
+void Brain::UpdateActiveTarget(uint32_t area_i) {
+  if (active_incoming_fibers_[area_i].empty() &&
+      active_incoming_stimulus_fibers_[area_i].empty()) {
+    EraseSorted(active_targets_, area_i);
+  } else {
+    InsertSorted(active_targets_, area_i);
+  }
+}
+
+/**
+ * @brief 设置 fiber 的赫布可塑性参数，对应 brain.py 的 update_plasticity。
+ * 
+ * @param from: 起始脑区名称
+ * @param to: 目标脑区名称
+ * @param beta: 新的 beta
+ */
+void Brain::SetFiberBeta(const std::string& from, const std::string& to,
+                         float beta) {
+  SetLearnRate(GetFiber(from, to), beta);
+}
+
+/**
+ * @brief 设置刺激到脑区的 fiber 的赫布可塑性参数。
+ * 
+ * @param stimulus: 刺激名称
+ * @param to: 目标脑区名称
+ * @param beta: 新的 beta
+ */
+void Brain::SetStimulusBeta(const std::string& stimulus, const std::string& to,
+                            float beta) {
+  StimulusFiber* fiber = FindStimulusFiber(stimulus, to);
+  if (!fiber) {
+    fprintf(stderr, "No fiber found from stimulus %s to %s\n",
+            stimulus.c_str(), to.c_str());
+    return;
+  }
+  fiber->beta = beta;
+  fiber->learn_rate = 1.0f + beta;
+}
+
+/**
+ * @brief 批量设置 fiber 的赫布可塑性参数，对应 brain.py 的 update_plasticities。
+ * 
+ * @param area_update_map: 目标脑区 -> [(起始脑区, beta)]
+ * @param stim_update_map: 目标脑区 -> [(刺激, beta)]
+ */
+void Brain::UpdatePlasticities(const PlasticityMap& area_update_map,
+                               const PlasticityMap& stim_update_map) {
+  for (const auto& [to, update_rules] : area_update_map) {
+    for (const auto& [from, beta] : update_rules) {
+      SetFiberBeta(from, to, beta);
+    }
+  }
+  for (const auto& [to, update_rules] : stim_update_map) {
+    for (const auto& [stimulus, beta] : update_rules) {
+      SetStimulusBeta(stimulus, to, beta);
+    }
+  }
+}
+
+/**
+ * @brief 设置 fiber 的 beta 和学习率。量化权重时换用该 beta 的权重表，
+ * 已有的突触按原权重重新量化为新表中不小于它的最近一级。
+ * 
+ * @param fiber: fiber
+ * @param beta: 新的 beta
+ * @throw std::invalid_argument: 量化权重时 beta 太小，权重增长到 max_weight
+ * 需要超过 UINT16_MAX 次，level 无法表示
+ */
+void Brain::SetLearnRate(Fiber& fiber, float beta) {
+  const float learn_rate = 1.0f + beta;
+#ifdef NEMO_QUANTIZED_WEIGHTS
+  auto& table = weight_tables_[beta];
+  if (!table) {
+    // 按与 Potentiate 相同的 float 运算逐项生成，保证与非量化的权重完全一致
+    auto levels = std::make_shared<std::vector<float>>(1, 1.0f);
+    for (;;) {
+      const float next = std::min(levels->back() * learn_rate, max_weight_);
+      if (next == levels->back()) break;
+      // 截断在这里会使权重停在一个与非量化版本不同的值，直接拒绝
+      if (levels->size() > UINT16_MAX) {
+        weight_tables_.erase(beta);
+        throw std::invalid_argument(
+            "beta " + std::to_string(beta) + " needs more than " +
+            std::to_string(UINT16_MAX + 1) + " weight levels to reach max_weight " +
+            std::to_string(max_weight_));
+      }
+      levels->push_back(next);
+    }
+    table = levels;
+  }
+  if (fiber.weight_table && fiber.weight_table != table) {
+    for (auto& synapses : fiber.outgoing_synapses) {
+      for (Synapse& s : synapses) {
+        const float w = (*fiber.weight_table)[s.level];
+        const size_t level =
+            std::lower_bound(table->begin(), table->end(), w) - table->begin();
+        s.level = std::min(level, table->size() - 1);
+      }
+    }
+  }
+  fiber.weight_table = table;
+#endif
+  fiber.beta = beta;
+  fiber.learn_rate = learn_rate;
 }
 
 /**
@@ -324,6 +679,11 @@ void Brain::ActivateArea(const std::string& name, uint32_t assembly_index) {
     printf("Activating %s assembly %u\n", name.c_str(), assembly_index);
   }
   Area& area = GetArea(name);
+  if (area.lazy && assembly_index < area.slot_of_assembly.size()) {
+    const uint32_t support = area.support;
+    assembly_index = MaterializeAssembly(area, assembly_index);
+    if (area.support != support) CheckMemoryBudget();
+  }
   uint32_t offset = assembly_index * area.k;
   if (offset + area.k > area.support) {
     // 激活的神经元数量不足
@@ -337,6 +697,7 @@ void Brain::ActivateArea(const std::string& name, uint32_t assembly_index) {
     area.activated[i] = offset + i;
   }
   area.fixed_assembly = true;
+  MarkFired(area);
 }
 
 /**
@@ -351,36 +712,52 @@ void Brain::SimulateOneStep(bool update_plasticity) {
     }
     printf("Step %u%s\n", step_, update_plasticity ? "" : " (readout)");
   }
-  // 记录每个脑区新的激活神经元
-  std::unordered_set<uint32_t> to_update_areas;
-  std::vector<std::vector<uint32_t>> new_activated(areas_.size());  
-  // 遍历每个脑区
-  for (uint32_t area_i = 0; area_i < areas_.size(); ++area_i) {
+  // 只遍历有激活的输入的脑区，记录每个脑区新的激活神经元（下标与 active_targets_ 相同）
+  const std::vector<uint32_t>& targets = active_targets_;
+  std::vector<uint8_t> has_input(targets.size());
+  std::vector<std::vector<uint32_t>> new_activated(targets.size());
+  for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+    const uint32_t area_i = targets[target_i];
     Area& to_area = areas_[area_i];
     uint32_t total_activated = 0;
-    // 遍历该脑区的每个输入 fiber
-    for (uint32_t fiber_i : incoming_fibers_[to_area.index]) {
+    // 遍历该脑区激活的输入 fiber
+    for (uint32_t fiber_i : active_incoming_fibers_[area_i]) {
         const Fiber& fiber = fibers_[fiber_i];
         const uint32_t num_activated = areas_[fiber.from_area].activated.size();
-        if (!fiber.is_active || num_activated == 0) continue;
+        if (num_activated == 0) continue;
         if (log_level_ > 0) {  
             printf("%s%s", total_activated == 0 ? "Projecting " : ",",
                 area_name_[fiber.from_area].c_str());
         }
         total_activated += num_activated;
     }
-    if(total_activated == 0){
-        to_update_areas.insert(area_i);
-        continue;
+    for (uint32_t fiber_i : active_incoming_stimulus_fibers_[area_i]) {
+        const StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+        if (log_level_ > 0) {
+            printf("%s%s", total_activated == 0 ? "Projecting " : ",",
+                stimulus_name_[fiber.stimulus].c_str());
+        }
+        total_activated += stimuli_[fiber.stimulus].k;
     }
+    if (total_activated == 0) continue;
+    has_input[target_i] = 1;
     if (log_level_ > 0) {
       printf(" into %s\n", area_name_[area_i].c_str());
     }
+    for (uint32_t fiber_i : active_incoming_fibers_[area_i]) {
+      UpdateFiberLayout(fibers_[fiber_i]);
+    }
+    // 非固定的脑区在第一遍中记录可塑性要访问的突触位置
+    FiredPositions fired;
+    bool has_fired_positions = false;
     if (!to_area.fixed_assembly) {
       // 用于记录每个神经元的突触输入
-      std::vector<Synapse> activations; 
+      std::vector<Activation> activations;
       // 1. 计算已知的激活神经元输入，即论文 SI (synaptic input)
-      ComputeKnownActivations(to_area, activations);
+      has_fired_positions =
+          fused_plasticity_ && update_plasticity && !to_area.activated.empty();
+      ComputeKnownActivations(to_area, activations,
+                              has_fired_positions ? &fired : nullptr);
       // 2. 选择前 k 个激活神经元
       SelectTopK(activations, to_area.k);
       if (!to_area.explicit_) {
@@ -393,68 +770,105 @@ void Brain::SimulateOneStep(bool update_plasticity) {
                activations[to_area.k - 1].weight);
       }
       // 重新 resize 为 k
-      new_activated[area_i].resize(to_area.k);
+      new_activated[target_i].resize(to_area.k);
       const uint32_t K = to_area.support;
       uint32_t num_new = 0;
       uint32_t total_from_activated = 0;
       uint32_t total_from_non_activated = 0;
-      // 将 activations（长度为 k）的神经元下标存入 new_activated[area_i] 中
+      // 每个新神经元从激活神经元连接的突触数量
+      std::vector<uint32_t> num_synapses_from_activated;
+      // 将 activations（长度为 k）的神经元下标存入 new_activated[target_i] 中
       for (uint32_t i = 0; i < to_area.k; ++i) {
-        const Synapse& s = activations[i];
+        const Activation& s = activations[i];
         if (s.neuron >= K) {
-          new_activated[area_i][i] = K + num_new;
-          ConnectNewNeuron(to_area, std::round(s.weight),
-                           total_from_non_activated);
+          new_activated[target_i][i] = K + num_new;
+          num_synapses_from_activated.push_back(std::round(s.weight));
           total_from_activated += std::round(s.weight);
           num_new++;
         } else {
-          new_activated[area_i][i] = s.neuron;
+          new_activated[target_i][i] = s.neuron;
         }
       }
+      ConnectNewNeurons(to_area, num_synapses_from_activated,
+                        total_from_non_activated);
       if (log_level_ > 1) {
         printf("[Area %s] Num new activations: %u, "
                "new synapses (from activated / from non-activated): %u / %u\n",
                area_name_[area_i].c_str(), num_new, total_from_activated,
                total_from_non_activated);
       }
-      std::sort(new_activated[area_i].begin(), new_activated[area_i].end());
+      std::sort(new_activated[target_i].begin(), new_activated[target_i].end());
     } else {
       // std::cout << area_name_[area_i] << " is fixed" << std::endl;
-      new_activated[area_i] = to_area.activated;
+      new_activated[target_i] = to_area.activated;
     }
     if (update_plasticity) {
       // 3. 更新突触权重
-      UpdatePlasticity(to_area, new_activated[area_i]);
+      UpdatePlasticity(to_area, new_activated[target_i],
+                       has_fired_positions ? &fired : nullptr);
     }
   }
-  // 更新每个脑区的激活神经元
-  for (uint32_t area_i = 0; area_i < areas_.size(); ++area_i) {
-    Area& area = areas_[area_i];
-    if (!area.fixed_assembly && !to_update_areas.count(area_i)) {
-      // std::cout << new_activated[area_i].size() << std::endl;
-      std::swap(area.activated, new_activated[area_i]);
-    }
+  // 更新有输入的脑区的激活神经元
+  for (size_t target_i = 0; target_i < targets.size(); ++target_i) {
+    Area& area = areas_[targets[target_i]];
+    if (!has_input[target_i]) continue;
+    if (!area.fixed_assembly) std::swap(area.activated, new_activated[target_i]);
+    MarkFired(area);
   }
   if (log_level_ > 2) {
     LogGraphStats();
   }
   if (update_plasticity) {
     ++step_;
+    if (prune_options_.interval > 0 && step_ % prune_options_.interval == 0) {
+      Prune(prune_options_);
+    }
   }
+  CheckMemoryBudget();
 }
 
 /**
- * @brief 根据映射图初始化，激活起点 fiber 到所有终点 fiber。
+ * @brief 根据映射图初始化，激活起点 fiber 到所有终点 fiber，抑制其它所有连接。
+ * 起点可以是脑区或刺激。
  * 
  * @param graph: 映射图
  */
 void Brain::InitProjection(const ProjectMap& graph) {
-  InhibitAll();
+  std::vector<uint32_t> fibers;
+  std::vector<uint32_t> stimulus_fibers;
   for (const auto& [from, edges] : graph) {
+    const bool is_stimulus = stimulus_by_name_.count(from) > 0;
     for (const auto& to : edges) {
-      ActivateFiber(from, to);
+      if (!is_stimulus) {
+        if (uint32_t fiber_i = FindFiber(from, to)) fibers.push_back(fiber_i);
+      } else if (StimulusFiber* fiber = FindStimulusFiber(from, to)) {
+        stimulus_fibers.push_back(fiber - stimulus_fibers_.data());
+      } else {
+        fprintf(stderr, "No fiber found from stimulus %s to %s\n",
+                from.c_str(), to.c_str());
+      }
+    }
+  }
+  std::sort(fibers.begin(), fibers.end());
+  std::sort(stimulus_fibers.begin(), stimulus_fibers.end());
+  // 与 InhibitAll 后逐条激活相同，但只修改状态改变的连接
+  const std::vector<uint32_t> targets = active_targets_;
+  for (uint32_t area_i : targets) {
+    const std::vector<uint32_t> active = active_incoming_fibers_[area_i];
+    for (uint32_t fiber_i : active) {
+      if (!std::binary_search(fibers.begin(), fibers.end(), fiber_i)) {
+        SetFiberActive(fiber_i, false);
+      }
+    }
+    const std::vector<uint32_t> active_stimulus = active_incoming_stimulus_fibers_[area_i];
+    for (uint32_t fiber_i : active_stimulus) {
+      if (!std::binary_search(stimulus_fibers.begin(), stimulus_fibers.end(), fiber_i)) {
+        SetStimulusFiberActive(fiber_i, false);
+      }
     }
   }
+  for (uint32_t fiber_i : fibers) SetFiberActive(fiber_i, true);
+  for (uint32_t fiber_i : stimulus_fibers) SetStimulusFiberActive(fiber_i, true);
 }
 
 /**
@@ -472,30 +886,115 @@ void Brain::Project(const ProjectMap& graph, uint32_t num_steps,
   }
 }
 
+/**
+ * @brief 合并（merge）：a 和 b 同时投影到 to，to 投影回 a、b 和自身，
+ * 形成与两者都关联的 assembly（simulations.merge_sim）。
+ * 
+ * @param a: 第一个源脑区
+ * @param b: 第二个源脑区
+ * @param to: 目标脑区
+ * @param num_steps: 步数
+ * @param inputs: 每一步额外的投影，例如保持 a、b 激活的刺激
+ */
+void Brain::Merge(const std::string& a, const std::string& b,
+                  const std::string& to, uint32_t num_steps,
+                  const ProjectMap& inputs) {
+  ProjectMap graph = inputs;
+  graph[a].insert({a, to});
+  graph[b].insert({b, to});
+  graph[to].insert({to, a, b});
+  Project(graph, num_steps);
+}
+
+/**
+ * @brief 关联（associate）：a 和 b 同时投影到 to 并保持 to 的循环连接，
+ * 使它们在 to 中的投影相互重叠（simulations.associate）。
+ * 
+ * @param a: 第一个源脑区
+ * @param b: 第二个源脑区
+ * @param to: 目标脑区
+ * @param num_steps: 步数
+ * @param inputs: 每一步额外的投影，例如保持 a、b 激活的刺激
+ */
+void Brain::Associate(const std::string& a, const std::string& b,
+                      const std::string& to, uint32_t num_steps,
+                      const ProjectMap& inputs) {
+  ProjectMap graph = inputs;
+  graph[a].insert({a, to});
+  graph[b].insert({b, to});
+  graph[to].insert(to);
+  Project(graph, num_steps);
+}
+
 /**
  * @brief 计算指定脑区原有激活神经元的激活
  * 
  * @param to_area: 目标脑区
  * @param activations: 激活神经元集合
+ * @param fired: 非空时按行记录稀疏 fiber 中指向 to_area 当前激活神经元的突触位置，
+ * 供同一步的 UpdatePlasticity 使用
  */
 void Brain::ComputeKnownActivations(const Area& to_area,
-                                    std::vector<Synapse>& activations) {
-  activations.resize(to_area.support);
-  for (uint32_t i = 0; i < activations.size(); ++i) {
-    activations[i].neuron = i;
-    activations[i].weight = 0;  // 这个 weight 就是 SI_i
+                                    std::vector<Activation>& activations,
+                                    FiredPositions* fired) {
+  std::vector<float> inputs(to_area.support);  // 这就是 SI_i
+  std::vector<const float*> dense_rows;
+  if (fired) {
+    fired->was_activated.assign(to_area.support, 0);
+    for (uint32_t neuron : to_area.activated) fired->was_activated[neuron] = 1;
+    fired->row_end.clear();
   }
-  for (uint32_t fiber_i : incoming_fibers_[to_area.index]) {
+  for (uint32_t fiber_i : active_incoming_fibers_[to_area.index]) {
     const Fiber& fiber = fibers_[fiber_i];
-    if (!fiber.is_active) continue;
     const Area& from_area = areas_[fiber.from_area];
+    if (fiber.dense) {
+      dense_rows.clear();
+      for (uint32_t from_neuron : from_area.activated) {
+        dense_rows.push_back(&fiber.dense_weights[size_t(from_neuron) * fiber.dense_cols]);
+      }
+      AccumulateDenseRows(dense_rows, std::min(fiber.dense_cols, to_area.support),
+                          inputs.data());
+      continue;
+    }
+    if (fired) {
+      // 无分支地写入：每个位置都写，只有指向激活神经元的才前移
+      // positions 可能长于已记录的部分，有效长度为 row_end 的最后一项
+      const uint8_t* was_activated = fired->was_activated.data();
+      std::vector<uint32_t>& positions = fired->positions;
+      for (uint32_t from_neuron : from_area.activated) {
+        const auto& synapses = fiber.outgoing_synapses[from_neuron];
+        size_t count = fired->row_end.empty() ? 0 : fired->row_end.back();
+        if (positions.size() < count + synapses.size()) {
+          positions.resize(std::max(2 * positions.size(), count + synapses.size()));
+        }
+        uint32_t* out = positions.data();
+        for (size_t i = 0; i < synapses.size(); ++i) {
+          inputs[synapses[i].neuron] += fiber.Weight(synapses[i]);
+          out[count] = i;
+          count += was_activated[synapses[i].neuron];
+        }
+        fired->row_end.push_back(count);
+      }
+      continue;
+    }
     for (uint32_t from_neuron : from_area.activated) {
       const auto& synapses = fiber.outgoing_synapses[from_neuron];
       for (size_t i = 0; i < synapses.size(); ++i) {
-        activations[synapses[i].neuron].weight += synapses[i].weight;
+        inputs[synapses[i].neuron] += fiber.Weight(synapses[i]);
       }
     }
   }
+  for (uint32_t fiber_i : active_incoming_stimulus_fibers_[to_area.index]) {
+    const StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+    for (uint32_t i = 0; i < inputs.size(); ++i) {
+      inputs[i] += fiber.weights[i];
+    }
+  }
+  activations.resize(to_area.support);
+  for (uint32_t i = 0; i < activations.size(); ++i) {
+    activations[i].neuron = i;
+    activations[i].weight = inputs[i];
+  }
 }
 
 /**
@@ -506,7 +1005,7 @@ void Brain::ComputeKnownActivations(const Area& to_area,
  * @param activations: 激活神经元集合
  */
 void Brain::GenerateNewCandidates(const Area& to_area, uint32_t total_k,
-                                  std::vector<Synapse>& activations) {
+                                  std::vector<Activation>& activations) {
   // Compute the total number of neurons firing into this area.
   const uint32_t remaining_neurons = to_area.n - to_area.support;
   if (remaining_neurons <= to_area.k) {
@@ -521,22 +1020,20 @@ void Brain::GenerateNewCandidates(const Area& to_area, uint32_t total_k,
     // distribution that approximates the binomial(total_k, p_) distribution.
     // TODO(szabadka): For the normal approximation to work, the mean should be
     // at least 9. Find a better approximation if this does not hold.
-    const float percent =
-        (remaining_neurons - to_area.k) * 1.0f / remaining_neurons;
-    const float cutoff = BinomQuantile(total_k, p_, percent);
-    const float mu = total_k * p_;
-    const float stddev = std::sqrt(total_k * p_ * (1.0f - p_));
-    const float a = (cutoff - mu) / stddev;
+    const CandidateParams& params =
+        GetCandidateParams(total_k, remaining_neurons, to_area.k, p_);
     if (log_level_ > 1) {
       printf("[Area %s] Generating candidates: percent=%f cutoff=%.0f "
              "mu=%f stddev=%f a=%f\n", area_name_[to_area.index].c_str(),
-             percent, cutoff, mu, stddev, a);
+             params.percent, params.cutoff, params.mu, params.stddev, params.a);
     }
+    std::vector<float> samples;
+    TruncatedNorm(params.a, to_area.k, rng_, samples);
     float max_d = 0;
     float min_d = total_k;
     for (uint32_t i = 0; i < to_area.k; ++i) {
-      const float x = TruncatedNorm(a, rng_);
-      const float d = std::min<float>(total_k, std::round(x * stddev + mu));
+      const float d = std::min<float>(
+          total_k, std::round(samples[i] * params.stddev + params.mu));
       max_d = std::max(d, max_d);
       min_d = std::min(d, min_d);
       activations.push_back({to_area.support + i, d});
@@ -549,19 +1046,56 @@ void Brain::GenerateNewCandidates(const Area& to_area, uint32_t total_k,
 }
 
 /**
- * @brief 为新的神经元连接突触
+ * @brief 为本步所有新激活的神经元连接突触。输入 fiber 的偏移量和有序的激活神经元
+ * 只准备一次；来自激活神经元的突触数由候选的输入决定，逐个神经元连接，
+ * 来自未激活神经元的突触对整批新神经元一次联合抽取，按行追加。
  * 
  * @param area: 目标脑区
- * @param num_synapses_from_activated: 从激活神经元连接的突触数量 
+ * @param num_synapses_from_activated: 每个新神经元从激活神经元连接的突触数量
  * @param total_synapses_from_non_activated: 从未激活神经元连接的突触总数 
  */
-void Brain::ConnectNewNeuron(Area& area,
-                             uint32_t num_synapses_from_activated,
-                             uint32_t& total_synapses_from_non_activated) {
-  ChooseSynapsesFromActivated(area, num_synapses_from_activated);
-  ChooseSynapsesFromNonActivated(area, total_synapses_from_non_activated);
-  ChooseOutgoingSynapses(area);
-  ++area.support;
+void Brain::ConnectNewNeurons(
+    Area& area, const std::vector<uint32_t>& num_synapses_from_activated,
+    uint32_t& total_synapses_from_non_activated) {
+  if (num_synapses_from_activated.empty()) return;
+  NewNeuronBatch batch;
+  uint32_t total_k = 0; // 记录到达该脑区的激活神经元的总数
+  const auto& incoming_fibers = incoming_fibers_[area.index];
+  batch.activated.resize(incoming_fibers.size());
+  for (size_t i = 0; i < incoming_fibers.size(); ++i) {
+    const Fiber& fiber = fibers_[incoming_fibers[i]];
+    const Area& from_area = areas_[fiber.from_area];
+    batch.offsets.push_back(total_k);
+    if (fiber.is_active) {
+      total_k += from_area.activated.size();
+      batch.activated[i] = from_area.activated;
+      std::sort(batch.activated[i].begin(), batch.activated[i].end());
+    }
+  }
+  // 激活的刺激排在所有输入 fiber 之后编号
+  for (uint32_t fiber_i : incoming_stimulus_fibers_[area.index]) {
+    const StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+    batch.offsets.push_back(total_k);
+    if (fiber.is_active) total_k += stimuli_[fiber.stimulus].k;
+  }
+  batch.offsets.push_back(total_k);
+  const uint32_t first = area.support;
+  for (uint32_t num_synapses : num_synapses_from_activated) {
+    for (uint32_t fiber_i : incoming_stimulus_fibers_[area.index]) {
+      StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+      // 激活的刺激的连接数由 ChooseSynapsesFromActivated 累加；未激活的刺激的
+      // k 个神经元各以概率 p 连接
+      fiber.weights.push_back(
+          fiber.is_active ? 0.0f : std::binomial_distribution<>(
+                                       stimuli_[fiber.stimulus].k, p_)(rng_));
+      memory_bytes_ += sizeof(float);
+    }
+    ChooseSynapsesFromActivated(area, num_synapses, batch);
+    ChooseOutgoingSynapses(area);
+    ++area.support;
+  }
+  ChooseSynapsesFromNonActivated(area, first, total_synapses_from_non_activated,
+                                 batch);
 }
 
 /**
@@ -569,83 +1103,80 @@ void Brain::ConnectNewNeuron(Area& area,
  * 
  * @param area: 目标脑区
  * @param num_synapses: 新突触数量 
+ * @param batch: 本批新神经元共用的数据
  */
 void Brain::ChooseSynapsesFromActivated(const Area& area,
-                                        uint32_t num_synapses) {
+                                        uint32_t num_synapses,
+                                        NewNeuronBatch& batch) {
   const uint32_t neuron = area.support; // 新神经元（待连接）
-  uint32_t total_k = 0; // 记录到达该脑区的激活神经元的总数
-  std::vector<uint32_t> offsets;
+  const std::vector<uint32_t>& offsets = batch.offsets;
   const auto& incoming_fibers = incoming_fibers_[area.index];
-  for (uint32_t fiber_i : incoming_fibers) {
-    const Fiber& fiber = fibers_[fiber_i];
-    const Area& from_area = areas_[fiber.from_area];
-    const uint32_t from_k = from_area.activated.size();
-    offsets.push_back(total_k);
-    if (fiber.is_active) {
-      total_k += from_k;
-    }
-  }
-  offsets.push_back(total_k);
-  std::uniform_int_distribution<> u(0, total_k - 1);
-  std::vector<uint8_t> selected(total_k); // 记录已选择的神经元，避免重复选择
-  // 为每一个新神经元选择一个激活神经元连接
-  for (uint32_t j = 0; j < num_synapses; ++j) {
-    uint32_t next_i;
-    while (selected[next_i = u(rng_)]) {}
-    selected[next_i] = 1;
+  // 在所有输入 fiber 的激活神经元上统一编号，不放回地选择 num_synapses 个
+  SampleWithoutReplacement(offsets.back(), num_synapses, rng_, batch.sample);
+  for (uint32_t next_i : batch.sample) {
     auto it = std::upper_bound(offsets.begin(), offsets.end(), next_i);
     const uint32_t fiber_i = (it - offsets.begin()) - 1;
+    if (fiber_i >= incoming_fibers.size()) {
+      // 刺激的神经元：只累加权重
+      const auto& stimulus_fibers = incoming_stimulus_fibers_[area.index];
+      stimulus_fibers_[stimulus_fibers[fiber_i - incoming_fibers.size()]]
+          .weights.back() += 1.0f;
+      continue;
+    }
     Fiber& fiber = fibers_[incoming_fibers[fiber_i]];
     const Area& from_area = areas_[fiber.from_area];
     uint32_t from = from_area.activated[next_i - offsets[fiber_i]];
-    fiber.outgoing_synapses[from].push_back({neuron, 1.0f});
+    AddSynapse(fiber, from, neuron);
   }
 }
 
 /**
- * @brief 从到达该脑区的其它脑区中选择未激活神经元连接到该脑区的新神经元
+ * @brief 从到达该脑区的其它脑区中选择未激活神经元连接到本批的新神经元
+ * first .. area.support-1。每个 (未激活神经元, 新神经元) 对以概率 p 连接，
+ * 在按起始神经元排序的所有对上做一次几何分布跳跃采样，每一行的新突触连续追加，
+ * 目标递增，行内仍然有序。自连接 fiber 中本批较早的新神经元也连接到较晚的。
  * 
- * @param area: 目标脑区
+ * @param area: 目标脑区，support 已包含本批的新神经元
+ * @param first: 本批第一个新神经元
  * @param total_synapses: 总新增突触数量
+ * @param batch: 本批新神经元共用的数据
  */
-void Brain::ChooseSynapsesFromNonActivated(const Area& area,
-                                           uint32_t& total_synapses) {
-  const uint32_t neuron = area.support;
-  for (uint32_t fiber_i : incoming_fibers_[area.index]) {
-    Fiber& fiber = fibers_[fiber_i];
-    const Area& from_area = areas_[fiber.from_area];
-    std::vector<uint8_t> selected(from_area.support);
-    size_t num_activated = fiber.is_active ? from_area.activated.size() : 0;
-    if (fiber.is_active) {
-      for (uint32_t i : from_area.activated) {
-        selected[i] = 1;
-      }
+void Brain::ChooseSynapsesFromNonActivated(const Area& area, uint32_t first,
+                                           uint32_t& total_synapses,
+                                           NewNeuronBatch& batch) {
+  const uint32_t m = area.support - first;
+  std::uniform_real_distribution<float> u(0.0, 1.0);
+  const float scale = 1.0f / std::log(1 - p_);
+  // 几何分布的间隔；u 为 0 时为无穷大，截断后仍然越过所有的对
+  auto skip = [&] {
+    const float gap = std::floor(std::log(u(rng_)) * scale);
+    return gap < 1e18f ? uint64_t(gap) : uint64_t(1) << 62;
+  };
+  const auto& incoming_fibers = incoming_fibers_[area.index];
+  for (size_t fiber_j = 0; fiber_j < incoming_fibers.size(); ++fiber_j) {
+    Fiber& fiber = fibers_[incoming_fibers[fiber_j]];
+    const bool self = fiber.from_area == area.index;
+    // 有序的激活神经元（fiber 未激活时为空），需要跳过
+    const std::vector<uint32_t>& excluded = batch.activated[fiber_j];
+    const uint32_t support = self ? first : areas_[fiber.from_area].support;
+    const uint64_t cells = uint64_t(support - excluded.size()) * m;
+    size_t e = 0;
+    for (uint64_t cell = skip(); cell < cells; cell += 1 + skip()) {
+      // 第 r 个未激活神经元：r 递增，excluded 只需顺序扫描一遍
+      const uint32_t r = cell / m;
+      while (e < excluded.size() && excluded[e] - e <= r) ++e;
+      AddSynapse(fiber, r + e, first + cell % m);
+      ++total_synapses;
     }
-    if (from_area.support <= 2 * num_activated) {
-      std::binomial_distribution<> binom(1, p_);
-      for (size_t from = 0; from < from_area.support; ++from) {
-        if (!selected[from] && binom(rng_)) {
-          fiber.outgoing_synapses[from].push_back({neuron, 1.0f});
-          ++total_synapses;
-        }
-      }
-    } else {
-      uint32_t population = from_area.support - num_activated;
-      std::binomial_distribution<> binom(population, p_);
-      std::uniform_int_distribution<> u(0, from_area.support - 1);
-      size_t num_synapses = binom(rng_);
-      for (size_t i = 0; i < num_synapses; ++i) {
-        for (;;) {
-          uint32_t from = u(rng_);
-          if (selected[from]) {
-            continue;
-          }
-          selected[from] = 1;
-          fiber.outgoing_synapses[from].push_back({neuron, 1.0f});
-          ++total_synapses;
-          break;
-        }
-      }
+    if (!self) continue;
+    // 本批内 i < j 的对 (first + i, first + j)，第 i 行有 m - 1 - i 个
+    const uint64_t pairs = uint64_t(m) * (m - 1) / 2;
+    uint64_t row_begin = 0;
+    uint32_t i = 0;
+    for (uint64_t cell = skip(); cell < pairs; cell += 1 + skip()) {
+      while (cell >= row_begin + (m - 1 - i)) row_begin += m - 1 - i++;
+      AddSynapse(fiber, first + i, first + i + 1 + (cell - row_begin));
+      ++total_synapses;
     }
   }
 }
@@ -661,39 +1192,300 @@ void Brain::ChooseOutgoingSynapses(const Area& area) {
     const Area& to_area = areas_[fiber.to_area];
     uint32_t support = to_area.support;
     if (area.index == to_area.index) ++support;
-    std::vector<Synapse> synapses = GenerateSynapses(support, p_, rng_);
-    fiber.outgoing_synapses.emplace_back(std::move(synapses));
+    AppendRow(fiber, GenerateSynapses(support, p_, rng_));
   }
 }
 
+/**
+ * @brief 生成按需脑区的一个 assembly：分配槽位，生成这 k 个新神经元的输出突触，
+ * 以及其它脑区已有神经元到它们的输入突触。随机数流只由种子、脑区和 assembly
+ * 索引决定，不消耗 rng_；但突触的数量和另一端的神经元取决于此时相连脑区的
+ * support 和已分配的槽位，因此连接仍与 assembly 第一次被激活的时机有关。
+ *
+ * @param area: 按需生成的脑区
+ * @param assembly_index: assembly 索引
+ * @return uint32_t: assembly 所在的槽位
+ */
+uint32_t Brain::MaterializeAssembly(Area& area, uint32_t assembly_index) {
+  uint32_t& slot = area.slot_of_assembly[assembly_index];
+  if (slot != UINT32_MAX) return slot;
+  slot = area.assembly_of_slot.size();
+  area.assembly_of_slot.push_back(assembly_index);
+  memory_bytes_ += sizeof(uint32_t);
+  std::seed_seq seq{seed_, area.index, assembly_index};
+  std::mt19937 rng(seq);
+  const uint32_t first = area.support;
+  area.support += area.k;
+  for (uint32_t fiber_i : outgoing_fibers_[area.index]) {
+    Fiber& fiber = fibers_[fiber_i];
+    const uint32_t support = areas_[fiber.to_area].support;
+    for (uint32_t i = 0; i < area.k; ++i) {
+      AppendRow(fiber, GenerateSynapses(support, p_, rng));
+    }
+  }
+  for (uint32_t fiber_i : incoming_fibers_[area.index]) {
+    Fiber& fiber = fibers_[fiber_i];
+    // 自连接 fiber 中新神经元的输出已在上面生成，这里只处理原有的神经元
+    const uint32_t from_support =
+        fiber.from_area == area.index ? first : areas_[fiber.from_area].support;
+    // 在 from_support * k 个 (起始神经元, 新神经元) 对上做几何分布跳跃采样，
+    // 结果按起始神经元排序，追加到每一行末尾后行内仍然有序
+    for (const Synapse& s : GenerateSynapses(from_support * area.k, p_, rng)) {
+      AddSynapse(fiber, s.neuron / area.k, first + s.neuron % area.k);
+    }
+  }
+  for (uint32_t fiber_i : incoming_stimulus_fibers_[area.index]) {
+    StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+    std::binomial_distribution<> binom(stimuli_[fiber.stimulus].k, p_);
+    for (uint32_t i = 0; i < area.k; ++i) fiber.weights.push_back(binom(rng));
+    memory_bytes_ += area.k * sizeof(float);
+  }
+  return slot;
+}
+
 /**
  * @brief 更新突触权重
  * 
  * @param to_area: 目标脑区
- * @param new_activated: 新激活神经元
+ * @param new_activated: 新激活神经元（升序）
+ * @param fired: 同一步 ComputeKnownActivations 记录的突触位置，为空时遍历整行
  */
 void Brain::UpdatePlasticity(Area& to_area,
-                             const std::vector<uint32_t>& new_activated) {
+                             const std::vector<uint32_t>& new_activated,
+                             const FiredPositions* fired) {
   std::vector<uint8_t> is_new_activated(to_area.support);
   for (uint32_t neuron : new_activated) {
     is_new_activated[neuron] = 1;
   }
-  for (uint32_t fiber_i : incoming_fibers_[to_area.index]) {
+  // 上一步没有激活的获胜神经元（包括本步新生成的神经元），其突触不在记录的位置中
+  std::vector<uint32_t> entrants;
+  if (fired) {
+    for (uint32_t neuron : new_activated) {
+      if (neuron >= fired->was_activated.size() || !fired->was_activated[neuron]) {
+        entrants.push_back(neuron);
+      }
+    }
+  }
+  size_t row = 0;
+  // 稠密 fiber 的每列的乘数，不同 fiber 的 1 + beta 不同时只改新激活的列
+  std::vector<float> scale;
+  float scale_rate = 0.0f;
+  for (uint32_t fiber_i : active_incoming_fibers_[to_area.index]) {
     Fiber& fiber = fibers_[fiber_i];
-    if (!fiber.is_active) continue;
     const Area& from_area = areas_[fiber.from_area];
+    if (fiber.dense) {
+      const uint32_t n = std::min(fiber.dense_cols, to_area.support);
+      if (scale.empty()) {
+        scale.resize(to_area.support);
+        for (uint32_t i = 0; i < scale.size(); ++i) {
+          scale[i] = is_new_activated[i] ? fiber.learn_rate : 1.0f;
+        }
+      } else if (fiber.learn_rate != scale_rate) {
+        for (uint32_t neuron : new_activated) scale[neuron] = fiber.learn_rate;
+      }
+      scale_rate = fiber.learn_rate;
+      for (uint32_t from_neuron : from_area.activated) {
+        PotentiateDenseRow(&fiber.dense_weights[size_t(from_neuron) * fiber.dense_cols],
+                           scale.data(), n, max_weight_);
+      }
+      continue;
+    }
     for (uint32_t from_neuron : from_area.activated) {
       auto& synapses = fiber.outgoing_synapses[from_neuron];
-      for (size_t j = 0; j < synapses.size(); ++j) {
-        if (is_new_activated[synapses[j].neuron]) {
-          synapses[j].weight =
-              std::min(synapses[j].weight * learn_rate_, max_weight_);
+      if (fired) {
+        const size_t begin = row == 0 ? 0 : fired->row_end[row - 1];
+        const size_t end = fired->row_end[row++];
+        // 新进入的获胜神经元多到二分查找不如整行遍历时，退回整行遍历
+        if (entrants.size() * 16 + (end - begin) < synapses.size()) {
+          for (size_t j = begin; j < end; ++j) {
+            Synapse& s = synapses[fired->positions[j]];
+            Potentiate(fiber, s, is_new_activated[s.neuron]);
+          }
+          auto it = synapses.begin();
+          for (uint32_t neuron : entrants) {
+            it = std::lower_bound(it, synapses.end(), neuron,
+                                  [](const Synapse& s, uint32_t n) { return s.neuron < n; });
+            if (it == synapses.end()) break;
+            if (it->neuron == neuron) Potentiate(fiber, *it, true);
+          }
+          continue;
         }
       }
+      for (size_t j = 0; j < synapses.size(); ++j) {
+        Potentiate(fiber, synapses[j], is_new_activated[synapses[j].neuron]);
+      }
+    }
+  }
+  for (uint32_t fiber_i : active_incoming_stimulus_fibers_[to_area.index]) {
+    StimulusFiber& fiber = stimulus_fibers_[fiber_i];
+    for (uint32_t neuron : new_activated) {
+      fiber.weights[neuron] =
+          std::min(fiber.weights[neuron] * fiber.learn_rate, max_weight_);
     }
   }
 }
 
+/**
+ * @brief 为 fiber 追加起始脑区一个新神经元的突触行。
+ * 
+ * @param fiber: fiber
+ * @param synapses: 按目标神经元递增的突触
+ */
+void Brain::AppendRow(Fiber& fiber, std::vector<Synapse> synapses) {
+  fiber.num_synapses += synapses.size();
+  if (!fiber.dense) {
+    memory_bytes_ += sizeof(std::vector<Synapse>) + synapses.size() * sizeof(Synapse);
+    fiber.outgoing_synapses.emplace_back(std::move(synapses));
+    return;
+  }
+  if (!synapses.empty()) ReserveDenseColumns(fiber, synapses.back().neuron + 1);
+  const size_t offset = fiber.dense_weights.size();
+  fiber.dense_weights.resize(offset + fiber.dense_cols);
+  memory_bytes_ += fiber.dense_cols * sizeof(float);
+  for (const Synapse& s : synapses) {
+    fiber.dense_weights[offset + s.neuron] = fiber.Weight(s);
+  }
+}
+
+/**
+ * @brief 添加一个初始权重的突触。稀疏时追加到行尾，to 必须大于行中已有的目标神经元。
+ * 
+ * @param fiber: fiber
+ * @param from: 起始神经元
+ * @param to: 目标神经元
+ */
+void Brain::AddSynapse(Fiber& fiber, uint32_t from, uint32_t to) {
+  ++fiber.num_synapses;
+  if (!fiber.dense) {
+    fiber.outgoing_synapses[from].push_back({to, kInitialWeight});
+    memory_bytes_ += sizeof(Synapse);
+    return;
+  }
+  ReserveDenseColumns(fiber, to + 1);
+  fiber.dense_weights[size_t(from) * fiber.dense_cols + to] = fiber.Weight({to, kInitialWeight});
+}
+
+/**
+ * @brief 按密度和大小在稀疏和稠密表示之间切换 fiber，两种表示的计算结果完全相同。
+ * 突触行的间接访问和散列写入在目标脑区较小、突触较密时比逐元素的稠密运算更慢；
+ * 进入和退出稠密的密度不同，避免在阈值附近反复转换。量化权重的突触只占 6 字节，
+ * 始终使用稀疏表示。
+ * 
+ * @param fiber: fiber
+ */
+void Brain::UpdateFiberLayout(Fiber& fiber) {
+#ifndef NEMO_QUANTIZED_WEIGHTS
+  const size_t rows = fiber.NumRows();
+  const uint32_t support = areas_[fiber.to_area].support;
+  const size_t cells = rows * support;
+  if (cells == 0) return;
+  const float density = float(fiber.num_synapses) / cells;
+  if (!fiber.dense) {
+    // 有内存预算时，不让转换本身超出预算：按 ToDense 分配的列数下一次成倍增长后的大小计算
+    const uint32_t cols = std::max(1u, support);
+    const size_t dense_bytes = rows * GrownDenseColumns(fiber, cols, cols + 1) * sizeof(float);
+    if (cells <= dense_options_.max_cells && density >= dense_options_.enter_density &&
+        (memory_budget_ == 0 ||
+         memory_bytes_ - std::min(memory_bytes_, FiberBytes(fiber)) + dense_bytes <= memory_budget_)) {
+      ToDense(fiber);
+    }
+  } else if (rows * fiber.dense_cols > dense_options_.max_cells ||
+             density < dense_options_.exit_density) {
+    // 按实际分配的列数判断大小
+    ToSparse(fiber);
+  }
+#else
+  (void)fiber;
+#endif
+}
+
+/**
+ * @brief 稠密矩阵从 dense_cols 列增长到至少 cols 列时的新列数：成倍增长，不超过
+ * 目标脑区的神经元数，也不让矩阵超过 DenseFiberOptions::max_cells。
+ * 
+ * @param fiber: fiber
+ * @param dense_cols: 当前的列数
+ * @param cols: 需要的列数
+ * @return uint32_t: 新的列数
+ */
+uint32_t Brain::GrownDenseColumns(const Fiber& fiber, uint32_t dense_cols,
+                                  uint32_t cols) const {
+  const size_t rows = std::max<size_t>(1, fiber.NumRows());
+  const size_t limit = std::min<size_t>(
+      {size_t(2) * dense_cols, areas_[fiber.to_area].n, dense_options_.max_cells / rows});
+  return std::max<size_t>(cols, limit);
+}
+
+/**
+ * @brief 保证稠密矩阵至少有 cols 列。列数按 GrownDenseColumns 成倍增长，
+ * 目标脑区每增加一个神经元不需要重排整个矩阵。
+ * 
+ * @param fiber: 稠密的 fiber
+ * @param cols: 需要的列数
+ */
+void Brain::ReserveDenseColumns(Fiber& fiber, uint32_t cols) {
+  if (cols <= fiber.dense_cols) return;
+  const uint32_t new_cols = GrownDenseColumns(fiber, fiber.dense_cols, cols);
+  const uint32_t rows = fiber.NumRows();
+  std::vector<float> weights(size_t(rows) * new_cols);
+  for (uint32_t r = 0; r < rows; ++r) {
+    std::copy_n(&fiber.dense_weights[size_t(r) * fiber.dense_cols], fiber.dense_cols,
+                &weights[size_t(r) * new_cols]);
+  }
+  fiber.dense_weights.swap(weights);
+  memory_bytes_ += size_t(rows) * (new_cols - fiber.dense_cols) * sizeof(float);
+  fiber.dense_cols = new_cols;
+}
+
+/**
+ * @brief 把 fiber 的突触行转为稠密矩阵，列数为目标脑区当前的神经元数。
+ * 
+ * @param fiber: 稀疏的 fiber
+ */
+void Brain::ToDense(Fiber& fiber) {
+  const size_t bytes = FiberBytes(fiber);
+  const uint32_t rows = fiber.outgoing_synapses.size();
+  const uint32_t cols = std::max(1u, areas_[fiber.to_area].support);
+  fiber.dense_weights.assign(size_t(rows) * cols, 0.0f);
+  for (uint32_t r = 0; r < rows; ++r) {
+    for (const Synapse& s : fiber.outgoing_synapses[r]) {
+      fiber.dense_weights[size_t(r) * cols + s.neuron] = fiber.Weight(s);
+    }
+  }
+  std::vector<std::vector<Synapse>>().swap(fiber.outgoing_synapses);
+  fiber.dense_cols = cols;
+  fiber.dense = true;
+  memory_bytes_ = memory_bytes_ - bytes + FiberBytes(fiber);
+}
+
+/**
+ * @brief 把稠密矩阵转回按目标神经元递增的突触行，权重为 0 的位置没有突触。
+ * 
+ * @param fiber: 稠密的 fiber
+ */
+void Brain::ToSparse(Fiber& fiber) {
+  const size_t bytes = FiberBytes(fiber);
+  const uint32_t rows = fiber.NumRows();
+  std::vector<std::vector<Synapse>> synapses(rows);
+  for (uint32_t r = 0; r < rows; ++r) {
+    synapses[r].reserve(fiber.num_synapses / rows + 1);
+    fiber.ForEachSynapse(r, [&](uint32_t neuron, float weight) {
+#ifdef NEMO_QUANTIZED_WEIGHTS
+      const auto& table = *fiber.weight_table;
+      const size_t level = std::lower_bound(table.begin(), table.end(), weight) - table.begin();
+      synapses[r].push_back({neuron, uint16_t(std::min(level, table.size() - 1))});
+#else
+      synapses[r].push_back({neuron, weight});
+#endif
+    });
+  }
+  fiber.outgoing_synapses.swap(synapses);
+  std::vector<float>().swap(fiber.dense_weights);
+  fiber.dense_cols = 0;
+  fiber.dense = false;
+  memory_bytes_ = memory_bytes_ - bytes + FiberBytes(fiber);
+}
+
 /**
  * @brief 获得指定脑区 k 个激活神经元中的最大重叠数量和 assembly 索引。
  * 
@@ -707,12 +1499,48 @@ void Brain::ReadAssembly(const std::string& name,
   const size_t num_assemblies = area.n / area.k;
   std::vector<size_t> overlaps(num_assemblies);
   for (auto neuron : area.activated) {
-    ++overlaps[neuron / area.k];
+    ++overlaps[area.Assembly(neuron)];
   }
   index = std::max_element(overlaps.begin(), overlaps.end()) - overlaps.begin();
   overlap = overlaps[index];
 }
 
+/**
+ * @brief 只读的 readout：只沿 from -> to 这一条 fiber 计算目标脑区的前 k 个
+ * 激活神经元。不执行整脑的 SimulateOneStep，不生成新的候选神经元，也不修改
+ * 任何脑区的 activated 或突触。
+ *
+ * @param from: 起始脑区名称
+ * @param from_activated: 起始脑区的激活神经元（可以不是 from 当前的 activated）
+ * @param to: 目标脑区名称
+ * @param winners: 输出，目标脑区的激活神经元（升序）
+ */
+void Brain::ReadoutTopK(const std::string& from,
+                        const std::vector<uint32_t>& from_activated,
+                        const std::string& to,
+                        std::vector<uint32_t>& winners) const {
+  winners.clear();
+  const Area& to_area = GetArea(to);
+  const Fiber& fiber = GetFiber(from, to);
+  if (from_activated.empty() || to_area.support == 0) return;
+  std::vector<Activation> activations(to_area.support);
+  for (uint32_t i = 0; i < activations.size(); ++i) {
+    activations[i].neuron = i;
+    activations[i].weight = 0;
+  }
+  for (uint32_t from_neuron : from_activated) {
+    fiber.ForEachSynapse(from_neuron, [&](uint32_t neuron, float weight) {
+      activations[neuron].weight += weight;
+    });
+  }
+  SelectTopK(activations, std::min(to_area.k, to_area.support));
+  winners.reserve(activations.size());
+  for (const Activation& s : activations) {
+    winners.push_back(s.neuron);
+  }
+  std::sort(winners.begin(), winners.end());
+}
+
 /**
  * @brief 打印指定脑区的激活神经元
  * 
@@ -725,6 +1553,245 @@ void Brain::LogActivated(const std::string& area_name) {
   printf("\n");
 }
 
+/**
+ * @brief 所有 fiber 的突触（包括稠密的 fiber 和刺激 fiber 的权重）占用的内存，
+ * 按 vector 的容量计算。
+ * 
+ * @return size_t: 字节数
+ */
+size_t Brain::SynapseBytes() const {
+  size_t bytes = 0;
+  for (const Fiber& fiber : fibers_) {
+    bytes += fiber.outgoing_synapses.capacity() * sizeof(std::vector<Synapse>);
+    for (const auto& synapses : fiber.outgoing_synapses) {
+      bytes += synapses.capacity() * sizeof(Synapse);
+    }
+    bytes += fiber.dense_weights.capacity() * sizeof(float);
+  }
+  for (const StimulusFiber& fiber : stimulus_fibers_) {
+    bytes += fiber.weights.capacity() * sizeof(float);
+  }
+  return bytes;
+}
+
+// 脑区的 last_fired 和按需脑区的槽位表占用的字节数。activated 至多 k 个，
+// 调用者也会直接修改它，不计入
+size_t Brain::AreaBytes(const Area& area) const {
+  return (area.last_fired.size() + area.slot_of_assembly.size() +
+          area.assembly_of_slot.size()) * sizeof(uint32_t);
+}
+
+// fiber 按存储的突触数计算的字节数，O(1)
+size_t Brain::FiberBytes(const Fiber& fiber) const {
+  return fiber.outgoing_synapses.size() * sizeof(std::vector<Synapse>) +
+         (fiber.dense ? 0 : fiber.num_synapses * sizeof(Synapse)) +
+         fiber.dense_weights.size() * sizeof(float);
+}
+
+/**
+ * @brief 所有脑区和 fiber 占用的内存，按存储的突触数计算（不含 vector 的空余容量，
+ * 精确的容量见 SynapseBytes）。总量在存储改变的地方（追加突触行和突触、稠密矩阵
+ * 增加列、稀疏和稠密之间的转换、新神经元的刺激权重和 last_fired、生成 assembly）
+ * 增量维护，O(1)。
+ * 
+ * @return size_t: 字节数
+ */
+size_t Brain::MemoryBytes() const {
+  return memory_bytes_;
+}
+
+// 遍历所有脑区和 fiber 重新计算 MemoryBytes()，只在剪枝后使用
+size_t Brain::CountMemoryBytes() const {
+  size_t bytes = 0;
+  for (const Area& area : areas_) bytes += AreaBytes(area);
+  for (const Fiber& fiber : fibers_) bytes += FiberBytes(fiber);
+  for (const StimulusFiber& fiber : stimulus_fibers_) {
+    bytes += fiber.weights.size() * sizeof(float);
+  }
+  return bytes;
+}
+
+/**
+ * @brief 每个脑区和 fiber 的内存、突触数和行数，以及总量、峰值和预算。
+ * 遍历所有脑区和 fiber，代价与它们的数量成正比；bytes 与 MemoryBytes() 相同。
+ * 
+ * @return BrainMemoryStats: 统计
+ */
+BrainMemoryStats Brain::MemoryStats() const {
+  BrainMemoryStats stats;
+  for (size_t area_i = 1; area_i < areas_.size(); ++area_i) {
+    const Area& area = areas_[area_i];
+    stats.areas.push_back({area_name_[area_i], area.support, AreaBytes(area)});
+    stats.bytes += stats.areas.back().bytes;
+  }
+  for (size_t fiber_i = 1; fiber_i < fibers_.size(); ++fiber_i) {
+    const Fiber& fiber = fibers_[fiber_i];
+    stats.fibers.push_back({area_name_[fiber.from_area], area_name_[fiber.to_area],
+                            fiber.NumRows(), fiber.num_synapses, FiberBytes(fiber),
+                            fiber.dense});
+    stats.synapses += fiber.num_synapses;
+    stats.bytes += stats.fibers.back().bytes;
+  }
+  for (const StimulusFiber& fiber : stimulus_fibers_) {
+    stats.fibers.push_back({stimulus_name_[fiber.stimulus], area_name_[fiber.to_area], 0,
+                            fiber.weights.size(), fiber.weights.size() * sizeof(float),
+                            false});
+    stats.bytes += stats.fibers.back().bytes;
+  }
+  stats.peak_bytes = std::max(peak_memory_bytes_, stats.bytes);
+  stats.budget_bytes = memory_budget_;
+  return stats;
+}
+
+/**
+ * @brief 设置内存预算。每步投射和每次生成按需脑区的 assembly 后检查 MemoryBytes()，
+ * 超出时按 action 处理，因此最多超出一步的增长量。
+ * 
+ * @param max_bytes: 预算（字节），0 表示不限制
+ * @param action: 超出预算时抛出 MemoryBudgetExceeded，或者先压缩
+ */
+void Brain::SetMemoryBudget(size_t max_bytes, BudgetAction action) {
+  memory_budget_ = max_bytes;
+  budget_action_ = action;
+}
+
+// 更新峰值，超出预算时压缩或抛出 MemoryBudgetExceeded。只比较增量维护的总量，O(1)
+void Brain::CheckMemoryBudget() {
+  peak_memory_bytes_ = std::max(peak_memory_bytes_, memory_bytes_);
+  if (memory_budget_ == 0 || memory_bytes_ <= memory_budget_) return;
+  if (budget_action_ == BudgetAction::kCompact) {
+    Compact();
+    if (memory_bytes_ <= memory_budget_) return;
+  }
+  throw MemoryBudgetExceeded("Brain memory " + std::to_string(memory_bytes_) +
+                             " bytes exceeds the budget of " +
+                             std::to_string(memory_budget_) + " bytes");
+}
+
+/**
+ * @brief 压缩存储：比稀疏表示更大的稠密 fiber 转回稀疏，释放突触行和权重的空余容量。
+ * 不改变任何突触和计算结果。
+ * 
+ */
+void Brain::Compact() {
+  for (Fiber& fiber : fibers_) {
+    if (fiber.dense && fiber.num_synapses * sizeof(Synapse) +
+                           fiber.NumRows() * sizeof(std::vector<Synapse>) <
+                       fiber.dense_weights.size() * sizeof(float)) {
+      ToSparse(fiber);
+    }
+    for (auto& synapses : fiber.outgoing_synapses) synapses.shrink_to_fit();
+    fiber.outgoing_synapses.shrink_to_fit();
+    fiber.dense_weights.shrink_to_fit();
+  }
+  for (StimulusFiber& fiber : stimulus_fibers_) fiber.weights.shrink_to_fit();
+  for (Area& area : areas_) {
+    area.activated.shrink_to_fit();
+    area.last_fired.shrink_to_fit();
+  }
+}
+
+// 记录脑区当前激活的神经元在这一步激活；还没有记录的神经元从这一步开始计算
+void Brain::MarkFired(Area& area) {
+  if (area.last_fired.size() < area.support) {
+    memory_bytes_ += (area.support - area.last_fired.size()) * sizeof(uint32_t);
+    area.last_fired.resize(area.support, step_);
+  }
+  for (uint32_t neuron : area.activated) area.last_fired[neuron] = step_;
+}
+
+/**
+ * @brief 剪枝：长期运行的 brain 中 support 只增不减，新神经元的随机突触以初始权重
+ * 一直保留。超过 max_idle_steps 步没有激活的神经元为沉默的神经元：
+ * 指向它们的从未增强（仍为初始权重）的突触被删除；recycle_neurons 时非显式脑区的
+ * 沉默神经元连同它们的输入、输出突触和刺激权重一起回收，其余神经元按原来的顺序
+ * 重新编号（突触行仍然有序），support 减少，之后可以重新生成新神经元。
+ * 当前激活的神经元不会被回收。显式脑区的神经元编号表示 assembly，不回收。
+ * 之后压缩存储。
+ *
+ * 回收后非显式脑区的神经元编号改变，在 brain 之外保存的 activated 的副本失效。
+ *
+ * @param options: 参数，interval 不使用
+ * @return PruneStats: 删除的突触数（包括被回收的神经元的突触）和回收的神经元数
+ */
+PruneStats Brain::Prune(const PruneOptions& options) {
+  PruneStats stats;
+  // 每个脑区的沉默神经元，以及回收时每个神经元的新编号（被回收的为 UINT32_MAX）
+  std::vector<std::vector<uint8_t>> silent(areas_.size());
+  std::vector<std::vector<uint32_t>> new_id(areas_.size());
+  for (Area& area : areas_) {
+    MarkFired(area);
+    std::vector<uint8_t>& is_silent = silent[area.index];
+    is_silent.resize(area.support);
+    bool any = false;
+    for (uint32_t i = 0; i < area.support; ++i) {
+      is_silent[i] = step_ - area.last_fired[i] > options.max_idle_steps;
+      any |= is_silent[i];
+    }
+    if (!any) {
+      is_silent.clear();
+      continue;
+    }
+    if (!options.recycle_neurons || area.explicit_) continue;
+    std::vector<uint32_t>& ids = new_id[area.index];
+    ids.resize(area.support, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t i = 0; i < area.support; ++i) {
+      if (is_silent[i]) continue;
+      area.last_fired[next] = area.last_fired[i];
+      ids[i] = next++;
+    }
+    stats.neurons_recycled += area.support - next;
+    area.support = next;
+    area.last_fired.resize(next);
+    for (uint32_t& neuron : area.activated) neuron = ids[neuron];
+  }
+  for (Fiber& fiber : fibers_) {
+    const std::vector<uint8_t>& to_silent = silent[fiber.to_area];
+    const std::vector<uint32_t>& to_ids = new_id[fiber.to_area];
+    const std::vector<uint32_t>& from_ids = new_id[fiber.from_area];
+    if (to_silent.empty() && from_ids.empty()) continue;
+    // 稠密的 fiber 先转为稀疏，之后由 UpdateFiberLayout 按新的密度决定
+    if (fiber.dense) ToSparse(fiber);
+    auto& rows = fiber.outgoing_synapses;
+    uint32_t kept_rows = 0;
+    for (uint32_t r = 0; r < rows.size(); ++r) {
+      std::vector<Synapse>& synapses = rows[r];
+      const size_t before = synapses.size();
+      if (!from_ids.empty() && from_ids[r] == UINT32_MAX) {
+        synapses.clear();
+      } else if (!to_silent.empty()) {
+        size_t kept = 0;
+        for (const Synapse& s : synapses) {
+          if (to_silent[s.neuron] && (!to_ids.empty() || IsInitialWeight(s))) continue;
+          synapses[kept] = s;
+          if (!to_ids.empty()) synapses[kept].neuron = to_ids[s.neuron];
+          ++kept;
+        }
+        synapses.resize(kept);
+      }
+      stats.synapses_removed += before - synapses.size();
+      fiber.num_synapses -= before - synapses.size();
+      if (from_ids.empty() || from_ids[r] != UINT32_MAX) {
+        if (kept_rows != r) rows[kept_rows].swap(synapses);
+        ++kept_rows;
+      }
+    }
+    rows.resize(kept_rows);
+  }
+  for (StimulusFiber& fiber : stimulus_fibers_) {
+    const std::vector<uint32_t>& ids = new_id[fiber.to_area];
+    if (ids.empty()) continue;
+    for (uint32_t i = 0; i < ids.size(); ++i) {
+      if (ids[i] != UINT32_MAX) fiber.weights[ids[i]] = fiber.weights[i];
+    }
+    fiber.weights.resize(areas_[fiber.to_area].support);
+  }
+  Compact();
+  memory_bytes_ = CountMemoryBytes();
+  return stats;
+}
+
 /**
  * @brief 打印图的统计信息。
  * 
@@ -742,29 +1809,37 @@ void Brain::LogGraphStats() {
       printf("\n");
     }
   }
-  const float kThresLow = std::pow(learn_rate_, 10);
   for (const Fiber& fiber : fibers_) {
-    if (fiber.outgoing_synapses.empty()) continue;
-    size_t num_synapses = 0;
+    const float kThresLow = std::pow(fiber.learn_rate, 10);
+    if (fiber.NumRows() == 0) continue;
     size_t num_low_weights = 0;
     size_t num_mid_weights = 0;
     size_t num_sat_weights = 0;   // 饱和权重数量
     float max_w = 0.0;
-    for (uint32_t i = 0; i < fiber.outgoing_synapses.size(); ++i) {
-      const auto& synapses = fiber.outgoing_synapses[i];
-      num_synapses += synapses.size();
-      for (size_t j = 0; j < synapses.size(); ++j) {
-        const float w = synapses[j].weight;
+    for (uint32_t i = 0; i < fiber.NumRows(); ++i) {
+      fiber.ForEachSynapse(i, [&](uint32_t, float w) {
         max_w = std::max(w, max_w);
         if (w < kThresLow) ++num_low_weights;
         else if (w < max_weight_) ++num_mid_weights;
         else ++num_sat_weights;
-      }
+      });
     }
-    printf("Fiber %s -> %s has %zu synapses (low/mid/sat: %zu/%zu/%zu), "
+    printf("Fiber %s -> %s has %zu synapses%s (low/mid/sat: %zu/%zu/%zu), "
            "max w: %f\n", area_name_[fiber.from_area].c_str(),
-           area_name_[fiber.to_area].c_str(), num_synapses, num_low_weights,
-           num_mid_weights, num_sat_weights, max_w);
+           area_name_[fiber.to_area].c_str(), fiber.num_synapses,
+           fiber.dense ? " [dense]" : "", num_low_weights, num_mid_weights,
+           num_sat_weights, max_w);
+  }
+  for (const StimulusFiber& fiber : stimulus_fibers_) {
+    float max_w = 0.0;
+    double total_w = 0.0;
+    for (float w : fiber.weights) {
+      max_w = std::max(w, max_w);
+      total_w += w;
+    }
+    printf("Stimulus fiber %s -> %s has total weight %.1f, max w: %f\n",
+           stimulus_name_[fiber.stimulus].c_str(),
+           area_name_[fiber.to_area].c_str(), total_w, max_w);
   }
 }
 
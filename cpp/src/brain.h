@@ -3,8 +3,11 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <map>
+#include <memory>
 #include <random>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -15,14 +18,37 @@
 
 namespace nemo {
 
+#ifdef NEMO_QUANTIZED_WEIGHTS
+// 权重从 1 开始，每次只会乘以 1 + beta 并在 max_weight 处截断，因此总是
+// (1 + beta)^level，只需存储指数 level，实际权重查 fiber 的权重表（6 字节）
+#pragma pack(push, 1)
+struct Synapse {
+  uint32_t neuron;    // 神经元索引
+  uint16_t level;     // 突触权重的指数
+};
+#pragma pack(pop)
+const uint16_t kInitialWeight = 0;
+#else
 struct Synapse {
   uint32_t neuron;    // 神经元索引
   float weight;       // 突触权重
 };
+const float kInitialWeight = 1.0f;
+#endif
+
+// 神经元收到的突触输入之和
+struct Activation {
+  uint32_t neuron;    // 神经元索引
+  float weight;       // 突触输入
+};
 
 struct Area {
   Area(uint32_t index, uint32_t n, uint32_t k) : index(index), n(n), k(k) {}
   void Print(std::string name);
+  // 神经元所属的 assembly 索引
+  uint32_t Assembly(uint32_t neuron) const {
+    return lazy ? assembly_of_slot[neuron / k] : neuron / k;
+  }
 
   const uint32_t index;               // 脑区索引
   const uint32_t n;                   // 脑区的总神经元数量
@@ -31,18 +57,148 @@ struct Area {
   bool explicit_ = false;             // 是否具有固定数量的激活神经元
   bool fixed_assembly = false;        // ??
   std::vector<uint32_t> activated;    // 激活的神经元索引
+  std::vector<uint32_t> last_fired;   // 每个神经元最后一次激活时的步数，由 Brain 维护，可能短于 support
+  // 按需生成的显式脑区：assembly 第一次被激活时才生成其神经元和突触，
+  // 神经元索引为 槽位 * k + i，support 为已生成的 assembly 数量 * k
+  bool lazy = false;
+  std::vector<uint32_t> slot_of_assembly;   // assembly 索引到槽位的映射，未生成为 UINT32_MAX
+  std::vector<uint32_t> assembly_of_slot;   // 槽位到 assembly 索引的映射
 };
 
 struct Fiber {
   Fiber(uint32_t from, uint32_t to) : from_area(from), to_area(to) {}
+  // 突触的实际权重
+  float Weight(const Synapse& s) const {
+#ifdef NEMO_QUANTIZED_WEIGHTS
+    return (*weight_table)[s.level];
+#else
+    return s.weight;
+#endif
+  }
+
+  // 起始脑区的神经元数量，即突触矩阵的行数
+  uint32_t NumRows() const {
+    return dense ? dense_weights.size() / dense_cols : outgoing_synapses.size();
+  }
+  // 按目标神经元递增的顺序对起始神经元 from 的每个突触调用 fn(目标神经元, 权重)
+  template <typename Fn>
+  void ForEachSynapse(uint32_t from, Fn&& fn) const {
+    if (dense) {
+      const float* row = &dense_weights[size_t(from) * dense_cols];
+      for (uint32_t i = 0; i < dense_cols; ++i) {
+        if (row[i] != 0.0f) fn(i, row[i]);
+      }
+    } else {
+      for (const Synapse& s : outgoing_synapses[from]) fn(s.neuron, Weight(s));
+    }
+  }
 
   const uint32_t from_area; // 起始脑区索引
   const uint32_t to_area;   // 目标脑区索引
-  bool is_active = true;    // 是否激活
+  bool is_active = true;    // 是否激活，只由 Brain::ActivateFiber 等修改
+  float beta = 0.0f;        // 赫布可塑性参数，由 Brain::SetFiberBeta 设置
+  float learn_rate = 1.0f;  // 学习率：1 + beta
+#ifdef NEMO_QUANTIZED_WEIGHTS
+  // 第 level 项为 min((1 + beta)^level, max_weight)，beta 相同的 fiber 共用
+  std::shared_ptr<const std::vector<float>> weight_table;
+#endif
+  size_t num_synapses = 0;  // 突触总数，用于计算密度
+  // 每一行按目标神经元索引递增排序：新神经元的索引总是最大的，只会追加到行尾
   std::vector<std::vector<Synapse>> outgoing_synapses;  // 起始脑区每个神经元到目标脑区每个神经元的突触集合
+  // 稠密表示：NumRows() x dense_cols 的行主序权重矩阵，没有突触的位置为 0。
+  // 稠密时 outgoing_synapses 为空，两种表示由 Brain::UpdateFiberLayout 切换
+  bool dense = false;
+  uint32_t dense_cols = 0;
+  std::vector<float> dense_weights;
+};
+
+// 刺激：k 个总是同时激活的输入神经元，与 brain.py 的 stimulus 相同。刺激不是
+// 脑区，不为其神经元存储突触行
+struct Stimulus {
+  Stimulus(uint32_t index, uint32_t k) : index(index), k(k) {}
+
+  const uint32_t index;     // 刺激索引
+  const uint32_t k;         // 激活的神经元数量
+};
+
+// 刺激到脑区的 fiber。刺激的 k 个神经元总是同时激活，因此只需记录目标脑区每个
+// 神经元收到的突触权重之和（brain.py 的 connectomes_by_stimulus），是一个稠密向量
+struct StimulusFiber {
+  StimulusFiber(uint32_t stimulus, uint32_t to) : stimulus(stimulus), to_area(to) {}
+
+  const uint32_t stimulus;  // 刺激索引
+  const uint32_t to_area;   // 目标脑区索引
+  bool is_active = false;   // 是否激活，只由 Brain::InitProjection 等修改
+  float beta = 0.0f;        // 赫布可塑性参数，由 Brain::SetStimulusBeta 设置
+  float learn_rate = 1.0f;  // 学习率：1 + beta
+  std::vector<float> weights;  // 目标脑区每个神经元（下标小于 support）的输入权重
 };
 
+// 起始脑区或刺激 -> 目标脑区集合
 typedef std::unordered_map<std::string, std::unordered_set<std::string>> ProjectMap;
+// 目标脑区 -> [(起始脑区, beta)]，与 brain.py 的 update_plasticities 相同
+typedef std::unordered_map<std::string, std::vector<std::pair<std::string, float>>> PlasticityMap;
+
+// fiber 在稀疏的突触行和稠密的权重矩阵之间切换的阈值。默认值来自
+// performance/dense_benchmark：目标脑区不超过 512 个神经元时，密度约 0.15 以上
+// 稠密更快，0.1 附近两者相当；更大的矩阵超出缓存，需要很高的密度才划算
+struct DenseFiberOptions {
+  float enter_density = 0.15f;  // 突触密度不低于它时转为稠密
+  float exit_density = 0.1f;    // 稠密的 fiber 的密度低于它时转回稀疏
+  size_t max_cells = 512 * 512; // 稠密矩阵的最大元素数（行数 x 目标脑区的神经元数）
+};
+
+// Brain::Prune 的参数。超过 max_idle_steps 步没有激活的神经元为沉默的神经元
+struct PruneOptions {
+  uint32_t max_idle_steps = 1000;
+  bool recycle_neurons = true;  // 回收非显式脑区的沉默神经元；否则只删除指向它们的未增强突触
+  uint32_t interval = 0;        // SimulateOneStep 每 interval 步自动调用 Prune，0 表示不自动调用
+};
+
+// Brain::Prune 的结果
+struct PruneStats {
+  size_t synapses_removed = 0;
+  uint32_t neurons_recycled = 0;
+};
+
+// 一个脑区占用的内存：每个神经元的 last_fired 和按需脑区的槽位表
+struct AreaMemory {
+  std::string name;
+  uint32_t support = 0;
+  size_t bytes = 0;
+};
+
+// 一个 fiber 或刺激 fiber 占用的内存，按存储的突触数计算，不含 vector 的空余容量
+struct FiberMemory {
+  std::string from;        // 起始脑区或刺激名称
+  std::string to;          // 目标脑区名称
+  uint32_t rows = 0;       // 突触行数，刺激 fiber 为 0
+  size_t synapses = 0;     // 突触数，刺激 fiber 为目标神经元数
+  size_t bytes = 0;
+  bool dense = false;
+};
+
+// Brain::MemoryStats 的结果
+struct BrainMemoryStats {
+  std::vector<AreaMemory> areas;
+  std::vector<FiberMemory> fibers;
+  size_t synapses = 0;     // 所有 fiber 的突触数
+  size_t bytes = 0;        // 所有脑区和 fiber 的字节数
+  size_t peak_bytes = 0;   // bytes 到目前为止的最大值，每步投射和每次生成 assembly 后更新
+  size_t budget_bytes = 0; // 内存预算，0 表示不限制
+};
+
+// 超出 Brain::SetMemoryBudget 设置的内存预算
+class MemoryBudgetExceeded : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// 超出内存预算时的处理方式
+enum class BudgetAction {
+  kThrow,    // 抛出 MemoryBudgetExceeded
+  kCompact,  // 先调用 Brain::Compact，仍然超出时抛出 MemoryBudgetExceeded
+};
 
 class Brain {
  public:
@@ -50,18 +206,34 @@ class Brain {
 
   Area& AddArea(const std::string& name, uint32_t n, uint32_t k,
                 bool recurrent = true, bool is_explicit = false);
-  void AddStimulus(const std::string& name, uint32_t n, uint32_t k);
+  void AddStimulus(const std::string& name, uint32_t n, uint32_t k,
+                   bool lazy = false);
   void AddFiber(const std::string& from, const std::string& to,
                 bool bidirectional = false);
+  void AddStimulusInput(const std::string& name, uint32_t k);
+  void AddStimulusFiber(const std::string& stimulus, const std::string& to);
 
+  bool HasArea(const std::string& name) const {
+    return area_by_name_.count(name) > 0;
+  }
+  bool HasStimulus(const std::string& name) const {
+    return stimulus_by_name_.count(name) > 0;
+  }
   Area& GetArea(const std::string& name);
   const Area& GetArea(const std::string& name) const;
   Fiber& GetFiber(const std::string& from, const std::string& to);
   const Fiber& GetFiber(const std::string& from, const std::string& to) const;
+  const StimulusFiber& GetStimulusFiber(const std::string& stimulus,
+                                        const std::string& to) const;
 
   void InhibitAll();
   void InhibitFiber(const std::string& from, const std::string& to);
   void ActivateFiber(const std::string& from, const std::string& to);
+  void SetFiberBeta(const std::string& from, const std::string& to, float beta);
+  void SetStimulusBeta(const std::string& stimulus, const std::string& to,
+                       float beta);
+  void UpdatePlasticities(const PlasticityMap& area_update_map,
+                          const PlasticityMap& stim_update_map = {});
   void InitProjection(const ProjectMap& graph);
 
   void ActivateArea(const std::string& name, uint32_t assembly_index);
@@ -69,44 +241,135 @@ class Brain {
   void SimulateOneStep(bool update_plasticity = true);
   void Project(const ProjectMap& graph, uint32_t num_steps,
                bool update_plasticity = true);
+  void Merge(const std::string& a, const std::string& b, const std::string& to,
+             uint32_t num_steps, const ProjectMap& inputs = {});
+  void Associate(const std::string& a, const std::string& b,
+                 const std::string& to, uint32_t num_steps,
+                 const ProjectMap& inputs = {});
 
   void ReadAssembly(const std::string& name, size_t& index, size_t& overlap);
+  void ReadoutTopK(const std::string& from,
+                   const std::vector<uint32_t>& from_activated,
+                   const std::string& to,
+                   std::vector<uint32_t>& winners) const;
+
+  size_t SynapseBytes() const;
+  size_t MemoryBytes() const;
+  BrainMemoryStats MemoryStats() const;
+  void SetMemoryBudget(size_t max_bytes, BudgetAction action = BudgetAction::kThrow);
+  void Compact();
+  PruneStats Prune(const PruneOptions& options);
+  void SetPruneOptions(const PruneOptions& options) { prune_options_ = options; }
+  void SetDenseFiberOptions(const DenseFiberOptions& options) {
+    dense_options_ = options;
+  }
+  void SetFusedPlasticity(bool fused) { fused_plasticity_ = fused; }
 
   void SetLogLevel(int log_level) { log_level_ = log_level; }
   void LogGraphStats();
   void LogActivated(const std::string& area_name);
 
  private:
+  // 融合的可塑性：ComputeKnownActivations 在累加输入的同时记录每个稀疏突触行中
+  // 指向上一步激活神经元（最可能再次获胜的候选）的突触位置，UpdatePlasticity
+  // 只访问这些位置，并在有序的行中二分查找新进入的获胜神经元，不再遍历整行
+  struct FiredPositions {
+    std::vector<uint8_t> was_activated;  // 目标脑区每个已有神经元上一步是否激活
+    std::vector<uint32_t> row_end;       // 每个记录的突触行在 positions 中的结束位置
+    std::vector<uint32_t> positions;     // 突触在行中的下标
+  };
+
   void ComputeKnownActivations(const Area& to_area,
-                               std::vector<Synapse>& activations);
+                               std::vector<Activation>& activations,
+                               FiredPositions* fired = nullptr);
   void GenerateNewCandidates(const Area& to_area, uint32_t total_k,
-                             std::vector<Synapse>& activations);
-  void ConnectNewNeuron(Area& area,
-                        uint32_t num_synapses_from_activated,
-                        uint32_t& total_synapses_from_non_activated);
-  void ChooseSynapsesFromActivated(const Area& area,
-                                   uint32_t num_synapses);
-  void ChooseSynapsesFromNonActivated(const Area& area,
-                                      uint32_t& total_synapses);
+                             std::vector<Activation>& activations);
+  // ConnectNewNeurons 在同一批新神经元之间共用的数据
+  struct NewNeuronBatch {
+    std::vector<uint32_t> offsets;                 // 每个输入 fiber 的激活神经元的起始编号
+    std::vector<std::vector<uint32_t>> activated;  // 每个输入 fiber 有序的激活神经元，未激活的 fiber 为空
+    std::vector<uint32_t> sample;                  // 抽样结果
+  };
+
+  void ConnectNewNeurons(Area& area,
+                         const std::vector<uint32_t>& num_synapses_from_activated,
+                         uint32_t& total_synapses_from_non_activated);
+  void ChooseSynapsesFromActivated(const Area& area, uint32_t num_synapses,
+                                   NewNeuronBatch& batch);
+  void ChooseSynapsesFromNonActivated(const Area& area, uint32_t first,
+                                      uint32_t& total_synapses,
+                                      NewNeuronBatch& batch);
   void ChooseOutgoingSynapses(const Area& area);
+  StimulusFiber* FindStimulusFiber(const std::string& stimulus,
+                                   const std::string& to);
+  uint32_t FindFiber(const std::string& from, const std::string& to) const;
+  void SetFiberActive(uint32_t fiber_i, bool active);
+  void SetStimulusFiberActive(uint32_t fiber_i, bool active);
+  void UpdateActiveTarget(uint32_t area_i);
+  size_t AreaBytes(const Area& area) const;
+  size_t FiberBytes(const Fiber& fiber) const;
+  size_t CountMemoryBytes() const;
+  void CheckMemoryBudget();
+  void MarkFired(Area& area);
+  uint32_t MaterializeAssembly(Area& area, uint32_t assembly_index);
   void UpdatePlasticity(Area& to_area,
-                        const std::vector<uint32_t>& new_activated);
+                        const std::vector<uint32_t>& new_activated,
+                        const FiredPositions* fired = nullptr);
+  void AppendRow(Fiber& fiber, std::vector<Synapse> synapses);
+  void AddSynapse(Fiber& fiber, uint32_t from, uint32_t to);
+  void UpdateFiberLayout(Fiber& fiber);
+  uint32_t GrownDenseColumns(const Fiber& fiber, uint32_t dense_cols, uint32_t cols) const;
+  void ReserveDenseColumns(Fiber& fiber, uint32_t cols);
+  void ToDense(Fiber& fiber);
+  void ToSparse(Fiber& fiber);
+  void SetLearnRate(Fiber& fiber, float beta);
+  // 赫布可塑性：fired 时权重乘以 fiber 的 1 + beta，不超过 max_weight。
+  // 写成无分支的形式，约一半的突触指向新激活神经元，分支几乎无法预测
+  void Potentiate(const Fiber& fiber, Synapse& s, bool fired) const {
+#ifdef NEMO_QUANTIZED_WEIGHTS
+    s.level += fired & (s.level + 1u < fiber.weight_table->size());
+#else
+    s.weight = std::min(s.weight * (fired ? fiber.learn_rate : 1.0f), max_weight_);
+#endif
+  }
 
  protected:
   std::mt19937 rng_;
   int log_level_ = 0;
 
+  const uint32_t seed_;                                     // 随机数种子
+
   const float p_;                                           // 神经元激活概率
-  const float beta_;                                        // 更新权重
-  const float learn_rate_;                                  // 学习率：1+beta_
+  const float beta_;                                        // 新 fiber 默认的赫布可塑性参数
   const float max_weight_;                                  // 最大权重
+#ifdef NEMO_QUANTIZED_WEIGHTS
+  // 每种 beta 的权重表，第 level 项为 min((1+beta)^level, max_weight)
+  std::map<float, std::shared_ptr<const std::vector<float>>> weight_tables_;
+#endif
   std::vector<Area> areas_;                                 // 脑区集合，下标为 Area::index
   std::vector<Fiber> fibers_;                               // 纤维束集合，下标从 incoming_fibers_ 和 outgoing_fibers_ 中获取
   std::vector<std::vector<uint32_t>> incoming_fibers_;      // areas_ 的每个脑区的输入纤维束，下标为 Area::index
   std::vector<std::vector<uint32_t>> outgoing_fibers_;      // areas_ 的每个脑区的输出纤维束，下标为 Area::index
   std::map<std::string, uint32_t> area_by_name_;            // 脑区名称到脑区索引的映射
   std::vector<std::string> area_name_;                      // areas_ 每个脑区的名称，下标为 Area::index
+  std::vector<Stimulus> stimuli_;                           // 刺激集合，下标为 Stimulus::index
+  std::vector<StimulusFiber> stimulus_fibers_;              // 刺激 fiber 集合，下标从 incoming_stimulus_fibers_ 中获取
+  std::vector<std::vector<uint32_t>> incoming_stimulus_fibers_;  // areas_ 的每个脑区的输入刺激 fiber，下标为 Area::index
+  // 激活的 fiber 和刺激 fiber 只通过 SetFiberActive / SetStimulusFiberActive 修改，
+  // 同时维护下面三个表，SimulateOneStep 只遍历有激活输入的脑区和它们激活的输入
+  std::vector<std::vector<uint32_t>> active_incoming_fibers_;           // 每个脑区激活的输入 fiber，按下标递增
+  std::vector<std::vector<uint32_t>> active_incoming_stimulus_fibers_;  // 每个脑区激活的输入刺激 fiber，按下标递增
+  std::vector<uint32_t> active_targets_;                    // 有激活的输入的脑区，按下标递增
+  std::map<std::string, uint32_t> stimulus_by_name_;        // 刺激名称到刺激索引的映射
+  std::vector<std::string> stimulus_name_;                  // stimuli_ 每个刺激的名称，下标为 Stimulus::index
   uint32_t step_ = 0;                                       // 当前步数
+  DenseFiberOptions dense_options_;                         // 稠密 fiber 的切换阈值
+  bool fused_plasticity_ = false;                           // 可塑性是否只访问第一遍记录的突触位置
+  PruneOptions prune_options_;                              // 自动剪枝的参数
+  size_t memory_budget_ = 0;                                // 内存预算（字节），0 表示不限制
+  BudgetAction budget_action_ = BudgetAction::kThrow;       // 超出预算时的处理方式
+  size_t memory_bytes_ = 0;                                 // 增量维护的 MemoryBytes()
+  size_t peak_memory_bytes_ = 0;                            // MemoryBytes() 的最大值
 };
 
 }  // namespace nemo
@@ -0,0 +1,343 @@
+#include "learner.h"
+
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace nemo {
+
+using namespace learner;
+
+/**
+ * @brief 构造单词习得模型，对应 learner.LearnBrain.__init__。
+ *
+ * @param options: 模型参数，见 LearnOptions
+ */
+LearnBrain::LearnBrain(const LearnOptions& options)
+    : Brain(options.p, options.beta, std::numeric_limits<float>::infinity(),
+            options.seed),
+      num_nouns_(options.num_nouns), num_verbs_(options.num_verbs),
+      proj_rounds_(options.proj_rounds),
+      extra_context_areas_(options.extra_context_areas),
+      extra_context_model_(options.extra_context_model),
+      extra_context_delay_(options.extra_context_delay),
+      choice_rng_(options.seed ^ 0x9E3779B9u) {
+  AddLearnArea(PHON, lex_size() * options.PHON_k, options.PHON_k, true);
+  AddLearnArea(MOTOR, num_verbs_ * options.CONTEXTUAL_k, options.CONTEXTUAL_k, true);
+  AddLearnArea(VISUAL, num_nouns_ * options.CONTEXTUAL_k, options.CONTEXTUAL_k, true);
+
+  const uint32_t extra_k = options.extra_context_area_k;
+  if (extra_context_model_ == 'C') {
+    // 每个单词有自己的语境脑区，只有一个 assembly
+    extra_context_areas_ = lex_size();
+    for (uint32_t i = 0; i < extra_context_areas_; ++i) {
+      AddLearnArea(ExtraContextAreaName(i), extra_k, extra_k, true);
+      extra_context_map_.push_back(i);
+    }
+  } else if (extra_context_areas_ > 0) {
+    // 模型 A 和 B：每个额外语境脑区为每个单词保留一个 assembly
+    for (uint32_t i = 0; i < extra_context_areas_; ++i) {
+      AddLearnArea(ExtraContextAreaName(i), lex_size() * extra_k, extra_k, true);
+    }
+    std::uniform_int_distribution<uint32_t> area(0, extra_context_areas_ - 1);
+    for (uint32_t word = 0; word < lex_size(); ++word) {
+      extra_context_map_.push_back(area(choice_rng_));
+    }
+  }
+
+  AddLearnArea(NOUN, options.LEX_n, options.LEX_k, false);
+  AddLearnArea(VERB, options.LEX_n, options.LEX_k, false);
+}
+
+// 与 brain.py 相同：新脑区与所有已有脑区（包括自身）双向连接
+void LearnBrain::AddLearnArea(const std::string& name, uint32_t n, uint32_t k,
+                              bool is_explicit) {
+  AddArea(name, n, k, /*recurrent=*/true, is_explicit);
+  for (const auto& other : area_names_) {
+    AddFiber(other, name, /*bidirectional=*/true);
+  }
+  area_names_.push_back(name);
+}
+
+std::string LearnBrain::ExtraContextAreaName(uint32_t index) const {
+  return "CONTEXT_" + std::to_string(index);
+}
+
+void LearnBrain::TutorSingleIndexedWord(uint32_t word_index) {
+  ActivateIndexContext(word_index, false);
+  ActivateArea(PHON, word_index);
+  ProjectStar(/*mutual_inhibition=*/true);
+}
+
+void LearnBrain::TutorRandomWord() {
+  std::uniform_int_distribution<uint32_t> word(0, lex_size() - 1);
+  TutorSingleIndexedWord(word(choice_rng_));
+}
+
+/**
+ * @brief 激活单词的语境 assembly：名词在 VISUAL，动词在 MOTOR。
+ *
+ * @param word_index: 单词下标
+ * @param activate_extra_context: 是否同时激活单词的额外语境
+ */
+void LearnBrain::ActivateIndexContext(uint32_t word_index,
+                                      bool activate_extra_context) {
+  if (activate_extra_context && !extra_context_map_.empty()) {
+    const std::string area = ExtraContextAreaName(extra_context_map_[word_index]);
+    ActivateArea(area, extra_context_model_ == 'C' ? 0 : word_index);
+  }
+  if (word_index < num_nouns_) {
+    ActivateArea(VISUAL, word_index);
+  } else {
+    ActivateArea(MOTOR, word_index - num_nouns_);
+  }
+}
+
+// 投影一步，disable_plasticity_ 时不更新权重
+void LearnBrain::ProjectOnce(const ProjectMap& graph) {
+  Project(graph, 1, !disable_plasticity_);
+}
+
+/**
+ * @brief PHON 和语境投影到 NOUN、VERB，然后加上 NOUN、VERB 的循环和反向投影
+ * 再投影 proj_rounds 步（learner.LearnBrain.project_star）。
+ *
+ * @param mutual_inhibition: 是否只保留输入较大的一个词汇脑区
+ */
+void LearnBrain::ProjectStar(bool mutual_inhibition) {
+  // 第一步：NOUN 和 VERB 还没有激活神经元
+  ProjectMap graph = {{PHON, {NOUN, VERB}}};
+  const bool motor = !GetArea(MOTOR).activated.empty();
+  const bool visual = !GetArea(VISUAL).activated.empty();
+  if (motor) graph[MOTOR] = {VERB};
+  if (visual) graph[VISUAL] = {NOUN};
+  for (uint32_t i = 0; i < extra_context_areas_; ++i) {
+    const std::string area = ExtraContextAreaName(i);
+    if (!GetArea(area).activated.empty()) graph[area] = {NOUN, VERB};
+  }
+  ProjectOnce(graph);
+
+  // 之后的每一步加上 NOUN、VERB 的循环投影和到 PHON、语境的投影
+  graph[NOUN] = {PHON, NOUN};
+  graph[VERB] = {PHON, VERB};
+  if (motor) graph[VERB].insert(MOTOR);
+  if (visual) graph[NOUN].insert(VISUAL);
+
+  if (mutual_inhibition) {
+    const std::string& loser =
+        GetTotalInput(NOUN) > GetTotalInput(VERB) ? VERB : NOUN;
+    graph.erase(loser);
+    graph[PHON].erase(loser);
+  }
+  for (uint32_t i = 0; i < proj_rounds_; ++i) {
+    ProjectOnce(graph);
+  }
+}
+
+/**
+ * @brief 处理一个两词句子（名词 + 不及物动词），对应
+ * learner.LearnBrain.parse_indexed_sentence。
+ *
+ * @param noun_index: 名词下标
+ * @param verb_index: 动词下标（不小于 num_nouns）
+ * @param noun_first: 词序是否为 NV
+ */
+void LearnBrain::ParseIndexedSentence(uint32_t noun_index, uint32_t verb_index,
+                                      bool noun_first) {
+  ActivateArea(VISUAL, noun_index);
+  ActivateArea(MOTOR, verb_index - num_nouns_);
+  if (extra_context_areas_ > 0 && sentences_parsed_ > extra_context_delay_) {
+    std::bernoulli_distribution coin(0.5);
+    if (extra_context_model_ == 'A') {
+      // 每个额外语境脑区随机激活名词或动词的语境
+      for (uint32_t i = 0; i < extra_context_areas_; ++i) {
+        ActivateArea(ExtraContextAreaName(i),
+                     coin(choice_rng_) ? noun_index : verb_index);
+      }
+    } else if (extra_context_model_ == 'B') {
+      const uint32_t noun_area = extra_context_map_[noun_index];
+      const uint32_t verb_area = extra_context_map_[verb_index];
+      if (noun_area == verb_area) {
+        ActivateArea(ExtraContextAreaName(noun_area),
+                     coin(choice_rng_) ? noun_index : verb_index);
+      } else {
+        ActivateArea(ExtraContextAreaName(noun_area), noun_index);
+        ActivateArea(ExtraContextAreaName(verb_area), verb_index);
+      }
+    } else if (extra_context_model_ == 'C') {
+      ActivateArea(ExtraContextAreaName(noun_index), 0);
+      ActivateArea(ExtraContextAreaName(verb_index), 0);
+    }
+  }
+  ActivateArea(PHON, noun_first ? noun_index : verb_index);
+  ProjectStar();
+  ActivateArea(PHON, noun_first ? verb_index : noun_index);
+  ProjectStar();
+  ClearContextWinners();
+  ++sentences_parsed_;
+}
+
+void LearnBrain::ClearContextWinners() {
+  GetArea(VISUAL).activated.clear();
+  GetArea(MOTOR).activated.clear();
+  for (uint32_t i = 0; i < extra_context_areas_; ++i) {
+    GetArea(ExtraContextAreaName(i)).activated.clear();
+  }
+}
+
+void LearnBrain::TrainRandomSentence() {
+  std::uniform_int_distribution<uint32_t> noun(0, num_nouns_ - 1);
+  std::uniform_int_distribution<uint32_t> verb(num_nouns_, lex_size() - 1);
+  const uint32_t noun_index = noun(choice_rng_);
+  ParseIndexedSentence(noun_index, verb(choice_rng_));
+}
+
+void LearnBrain::TrainEachSentence() {
+  for (uint32_t noun = 0; noun < num_nouns_; ++noun) {
+    for (uint32_t verb = num_nouns_; verb < lex_size(); ++verb) {
+      ParseIndexedSentence(noun, verb);
+    }
+  }
+}
+
+/**
+ * @brief 每轮处理所有句子，直到所有单词都能被正确读出。
+ *
+ * @return int: 成功时的轮数，max_rounds 轮内未成功返回 -1
+ */
+int LearnBrain::TrainExperiment(uint32_t max_rounds, bool use_extra_context) {
+  for (uint32_t i = 0; i < max_rounds; ++i) {
+    TrainEachSentence();
+    if (TestAllWords(use_extra_context)) return i;
+  }
+  return -1;
+}
+
+/**
+ * @brief 每次处理一个随机句子，每 increment 句测试一次所有单词
+ * （learner.LearnBrain.train_experiment_randomized）。
+ *
+ * @return int: 成功时的句子编号，max_samples 句内未成功返回 -1
+ */
+int LearnBrain::TrainExperimentRandomized(uint32_t max_samples,
+                                          uint32_t increment,
+                                          uint32_t start_testing,
+                                          bool use_extra_context) {
+  for (uint32_t i = 0; i < max_samples; ++i) {
+    TrainRandomSentence();
+    if (i > start_testing && i % increment == 0 &&
+        TestAllWords(use_extra_context)) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief 与 TrainExperimentRandomized 相同，但每 single_word_frequency 个样本
+ * 中有一个是单独教授的单词。
+ *
+ * @return int: 成功时用过的单词数，max_samples 个样本内未成功返回 -1
+ */
+int LearnBrain::TrainExperimentRandomizedWithTutoring(
+    uint32_t max_samples, uint32_t testing_increment, uint32_t start_testing,
+    uint32_t single_word_frequency) {
+  int num_words = 0;
+  for (uint32_t i = 1; i <= max_samples; ++i) {
+    if (i % single_word_frequency == 0) {
+      TutorRandomWord();
+      num_words += 1;
+    } else {
+      TrainRandomSentence();
+      num_words += 2;
+    }
+    if (i > start_testing && i % testing_increment == 0 && TestAllWords()) {
+      return num_words;
+    }
+  }
+  return -1;
+}
+
+// 性质 P：每个单词的语境都能经由词汇脑区读出它的语音
+bool LearnBrain::TestAllWords(bool use_extra_context) {
+  for (uint32_t word = 0; word < lex_size(); ++word) {
+    if (TestIndexedWord(word, 0.75f, use_extra_context) != int(word)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief 关闭可塑性，激活单词的语境，投影到词汇脑区再投影到 PHON，读出
+ * PHON 中的 assembly。
+ *
+ * @return int: 读出的单词下标，不是任何 assembly 时返回 -1
+ */
+int LearnBrain::TestIndexedWord(uint32_t word_index, float min_overlap,
+                                bool use_extra_context) {
+  disable_plasticity_ = true;
+  GetArea(PHON).fixed_assembly = false;
+  ActivateIndexContext(word_index, use_extra_context);
+  const std::string& context = word_index < num_nouns_ ? VISUAL : MOTOR;
+  const std::string& lexical = word_index < num_nouns_ ? NOUN : VERB;
+  ProjectOnce({{context, {lexical}}});
+  ProjectOnce({{lexical, {PHON}}});
+  disable_plasticity_ = false;
+  const int out = GetExplicitAssembly(PHON, min_overlap);
+  ClearContextWinners();
+  return out;
+}
+
+/**
+ * @brief 显式脑区中与激活神经元重叠至少 min_overlap * k 的 assembly。
+ *
+ * @return int: assembly 索引，没有时返回 -1
+ */
+int LearnBrain::GetExplicitAssembly(const std::string& area_name,
+                                    float min_overlap) const {
+  const Area& area = GetArea(area_name);
+  if (area.activated.empty()) {
+    throw std::runtime_error("Cannot get word because no assembly in " + area_name);
+  }
+  std::vector<uint32_t> overlaps(area.n / area.k);
+  for (uint32_t neuron : area.activated) {
+    if (neuron / area.k < overlaps.size()) ++overlaps[neuron / area.k];
+  }
+  for (uint32_t index = 0; index < overlaps.size(); ++index) {
+    if (overlaps[index] >= min_overlap * area.k) return index;
+  }
+  return -1;
+}
+
+/**
+ * @brief from 的激活神经元到 to 的激活神经元的突触权重之和。
+ */
+float LearnBrain::GetInputFrom(const std::string& from,
+                               const std::string& to) const {
+  const auto& from_winners = GetArea(from).activated;
+  const auto& to_winners = GetArea(to).activated;
+  if (from_winners.empty() || to_winners.empty()) return 0;
+  const std::unordered_set<uint32_t> targets(to_winners.begin(), to_winners.end());
+  const Fiber& fiber = GetFiber(from, to);
+  float total_input = 0;
+  for (uint32_t neuron : from_winners) {
+    fiber.ForEachSynapse(neuron, [&](uint32_t target, float weight) {
+      if (targets.count(target)) total_input += weight;
+    });
+  }
+  return total_input;
+}
+
+// 词汇脑区从 PHON 和对应语境脑区得到的输入
+float LearnBrain::GetTotalInput(const std::string& area) const {
+  float total_input = GetInputFrom(PHON, area);
+  if (area == NOUN) {
+    total_input += GetInputFrom(VISUAL, area);
+  } else if (area == VERB) {
+    total_input += GetInputFrom(MOTOR, area);
+  }
+  return total_input;
+}
+
+}  // namespace nemo
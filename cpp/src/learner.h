@@ -0,0 +1,106 @@
+#ifndef NEMO_LEARNER_H_
+#define NEMO_LEARNER_H_
+
+#include "brain.h"
+
+#include <stdint.h>
+
+#include <random>
+#include <string>
+
+namespace nemo {
+namespace learner {
+
+// 脑区名称，与 python/learner.py 相同
+const std::string PHON = "PHON";
+const std::string MOTOR = "MOTOR";
+const std::string VISUAL = "VISUAL";
+const std::string NOUN = "NOUN";  // LEX_NOUN
+const std::string VERB = "VERB";  // LEX_VERB
+
+}  // namespace learner
+
+// LearnBrain 的参数，名称和默认值与 learner.LearnBrain 的构造参数相同
+struct LearnOptions {
+  float p = 0.05f;
+  uint32_t PHON_k = 100;
+  uint32_t CONTEXTUAL_k = 100;
+  uint32_t LEX_k = 100;
+  uint32_t LEX_n = 10000;
+  float beta = 0.06f;
+  uint32_t proj_rounds = 2;
+  uint32_t num_nouns = 2;
+  uint32_t num_verbs = 2;
+  uint32_t extra_context_areas = 0;
+  uint32_t extra_context_area_k = 10;
+  char extra_context_model = 'B';   // 'A'、'B' 或 'C'
+  uint32_t extra_context_delay = 0;
+  uint32_t seed = 0;
+};
+
+/**
+ * @brief 单词习得模型（learner.LearnBrain）：PHON 中的语音 assembly 与 VISUAL
+ * （名词）或 MOTOR（动词）中的语境 assembly 同时出现，在 NOUN 和 VERB 中形成
+ * 单词的 assembly。单词按下标编号，前 num_nouns 个为名词，其余为动词。
+ *
+ * 与 brain.py 相同，任意两个脑区之间都有 fiber，所有 fiber 使用同一个 beta。
+ * 训练中选择句子和额外语境的随机数与引擎的随机数相互独立。
+ */
+class LearnBrain : public Brain {
+ public:
+  explicit LearnBrain(const LearnOptions& options);
+
+  uint32_t lex_size() const { return num_nouns_ + num_verbs_; }
+  uint32_t sentences_parsed() const { return sentences_parsed_; }
+
+  void TutorSingleIndexedWord(uint32_t word_index);
+  void TutorRandomWord();
+  void ParseIndexedSentence(uint32_t noun_index, uint32_t verb_index,
+                            bool noun_first = true);
+  void TrainRandomSentence();
+  void TrainEachSentence();
+
+  int TrainExperiment(uint32_t max_rounds = 100, bool use_extra_context = false);
+  int TrainExperimentRandomized(uint32_t max_samples = 500,
+                                uint32_t increment = 1,
+                                uint32_t start_testing = 0,
+                                bool use_extra_context = false);
+  int TrainExperimentRandomizedWithTutoring(uint32_t max_samples = 500,
+                                            uint32_t testing_increment = 1,
+                                            uint32_t start_testing = 0,
+                                            uint32_t single_word_frequency = 5);
+
+  bool TestAllWords(bool use_extra_context = false);
+  int TestIndexedWord(uint32_t word_index, float min_overlap = 0.75f,
+                      bool use_extra_context = false);
+  int GetExplicitAssembly(const std::string& area_name,
+                          float min_overlap = 0.75f) const;
+
+  float GetInputFrom(const std::string& from, const std::string& to) const;
+  float GetTotalInput(const std::string& area) const;
+
+ private:
+  void AddLearnArea(const std::string& name, uint32_t n, uint32_t k,
+                    bool is_explicit);
+  std::string ExtraContextAreaName(uint32_t index) const;
+  void ActivateIndexContext(uint32_t word_index, bool activate_extra_context);
+  void ProjectStar(bool mutual_inhibition = false);
+  void ProjectOnce(const ProjectMap& graph);
+  void ClearContextWinners();
+
+  const uint32_t num_nouns_;
+  const uint32_t num_verbs_;
+  const uint32_t proj_rounds_;
+  uint32_t extra_context_areas_;
+  const char extra_context_model_;
+  const uint32_t extra_context_delay_;
+  std::vector<uint32_t> extra_context_map_;   // 每个单词的额外语境脑区
+  std::vector<std::string> area_names_;       // 已添加的脑区，用于全连接
+  uint32_t sentences_parsed_ = 0;
+  bool disable_plasticity_ = false;
+  std::mt19937 choice_rng_;                   // 选择句子和额外语境的随机数
+};
+
+}  // namespace nemo
+
+#endif  // NEMO_LEARNER_H_
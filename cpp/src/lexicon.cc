@@ -0,0 +1,357 @@
+#include "lexicon.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace nemo {
+namespace {
+
+/**
+ * @brief 字符串哈希（FNV-1a 后接一次混合）。
+ *
+ * @param word: 单词
+ * @return uint64_t: 哈希值
+ */
+uint64_t Hash(std::string_view word) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (char c : word) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001b3ULL;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/**
+ * @brief 由单词的哈希值和种子得到新的哈希值，构造时换种子不必重新扫描字符串。
+ *
+ * @param h: Hash(word)
+ * @param seed: 种子
+ * @return uint64_t: 哈希值
+ */
+uint64_t Rehash(uint64_t h, uint32_t seed) {
+  h += seed * 0x9e3779b97f4a7c15ULL;
+  h ^= h >> 31;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 29;
+  return h;
+}
+
+bool IsWordChar(char c) {
+  const unsigned char u = static_cast<unsigned char>(c);
+  // 非 ASCII 字节按单词处理，避免切开 UTF-8 字符
+  return isalnum(u) || c == '\'' || c == '-' || u >= 0x80;
+}
+
+const char kMagic[8] = {'N', 'E', 'M', 'O', 'L', 'E', 'X', '1'};
+
+template<typename T>
+void WriteArray(FILE* f, const std::vector<T>& v) {
+  const uint32_t size = v.size();
+  fwrite(&size, sizeof(size), 1, f);
+  if (size > 0) fwrite(v.data(), sizeof(T), size, f);
+}
+
+template<typename T>
+void ReadArray(const char*& data, const char* end, std::vector<T>& v) {
+  uint32_t size;
+  if (data + sizeof(size) > end) throw std::runtime_error("Truncated lexicon");
+  memcpy(&size, data, sizeof(size));
+  data += sizeof(size);
+  if (data + size * sizeof(T) > end) throw std::runtime_error("Truncated lexicon");
+  v.resize(size);
+  if (size > 0) memcpy(v.data(), data, size * sizeof(T));
+  data += size * sizeof(T);
+}
+
+}  // namespace
+
+void Tokenize(std::string_view sentence, std::vector<std::string_view>& tokens) {
+  tokens.clear();
+  size_t i = 0;
+  while (i < sentence.size()) {
+    while (i < sentence.size() && !IsWordChar(sentence[i])) ++i;
+    const size_t start = i;
+    while (i < sentence.size() && IsWordChar(sentence[i])) ++i;
+    if (i > start) tokens.push_back(sentence.substr(start, i - start));
+  }
+}
+
+Lexicon::Lexicon(const std::vector<std::string>& words,
+                 const std::vector<uint8_t>& pos,
+                 const std::vector<std::string>& pos_names)
+    : pos_(pos), pos_names_(pos_names) {
+  offsets_.reserve(words.size() + 1);
+  offsets_.push_back(0);
+  for (const std::string& word : words) {
+    pool_ += word;
+    offsets_.push_back(pool_.size());
+  }
+  pos_.resize(words.size());
+  Build();
+}
+
+/**
+ * @brief 从词性文件加载词表，与 words/lexemedict.py 的编号方式一致：
+ * 在多个文件中出现的单词只保留第一次出现（按文件名排序）的词性和编号。
+ *
+ * @param dir: 词性文件所在目录
+ * @return Lexicon: 词表
+ */
+Lexicon Lexicon::FromWordLists(const std::string& dir) {
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) throw std::runtime_error("Cannot open word list dir " + dir);
+  std::vector<std::string> files;
+  while (struct dirent* entry = readdir(d)) {
+    std::string name = entry->d_name;
+    if (name.size() <= 4 || name.compare(name.size() - 4, 4, ".txt") != 0) continue;
+    if (name == "sentences.txt" || name == "dependency.txt") continue;
+    files.push_back(name);
+  }
+  closedir(d);
+  std::sort(files.begin(), files.end());
+  if (files.size() > 256) throw std::runtime_error("Too many word lists in " + dir);
+
+  Lexicon lexicon;
+  lexicon.offsets_.push_back(0);
+  std::unordered_set<std::string> seen;
+  std::string line;
+  for (const std::string& name : files) {
+    std::ifstream in(dir + "/" + name);
+    if (!in) throw std::runtime_error("Cannot read word list " + name);
+    const uint8_t pos = lexicon.pos_names_.size();
+    lexicon.pos_names_.push_back(name.substr(0, name.size() - 4));
+    while (std::getline(in, line)) {
+      size_t begin = 0, end = line.size();
+      while (begin < end && isspace(static_cast<unsigned char>(line[begin]))) ++begin;
+      while (end > begin && isspace(static_cast<unsigned char>(line[end - 1]))) --end;
+      if (begin == end || !seen.insert(line.substr(begin, end - begin)).second) continue;
+      lexicon.pool_.append(line, begin, end - begin);
+      lexicon.offsets_.push_back(lexicon.pool_.size());
+      lexicon.pos_.push_back(pos);
+    }
+  }
+  lexicon.Build();
+  return lexicon;
+}
+
+/**
+ * @brief 从 SaveBinary 写出的二进制词表加载。哈希表是直接读入的，不需要重新构造。
+ *
+ * @param path: 文件路径
+ * @return Lexicon: 词表
+ */
+Lexicon Lexicon::FromBinary(const std::string& path) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) throw std::runtime_error("Cannot open lexicon " + path);
+  fseek(f, 0, SEEK_END);
+  const long file_size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  std::vector<char> buffer(std::max<long>(file_size, 0));
+  const size_t num_read = fread(buffer.data(), 1, buffer.size(), f);
+  fclose(f);
+  if (num_read != buffer.size() || buffer.size() < sizeof(kMagic) ||
+      memcmp(buffer.data(), kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Invalid lexicon file " + path);
+  }
+  const char* data = buffer.data() + sizeof(kMagic);
+  const char* end = buffer.data() + buffer.size();
+  Lexicon lexicon;
+  std::vector<char> pool;
+  ReadArray(data, end, pool);
+  lexicon.pool_.assign(pool.begin(), pool.end());
+  ReadArray(data, end, lexicon.offsets_);
+  ReadArray(data, end, lexicon.pos_);
+  ReadArray(data, end, lexicon.displacement_);
+  ReadArray(data, end, lexicon.slot_id_);
+  std::vector<char> names;
+  ReadArray(data, end, names);
+  for (size_t begin = 0, i = 0; i < names.size(); ++i) {
+    if (names[i] == '\n') {
+      lexicon.pos_names_.emplace_back(names.data() + begin, i - begin);
+      begin = i + 1;
+    }
+  }
+  // 查询时直接使用这些下标，损坏的文件不能导致越界访问
+  const size_t num_slots = lexicon.slot_id_.size();
+  bool consistent =
+      !lexicon.offsets_.empty() && lexicon.offsets_.back() == lexicon.pool_.size() &&
+      std::is_sorted(lexicon.offsets_.begin(), lexicon.offsets_.end()) &&
+      lexicon.pos_.size() + 1 == lexicon.offsets_.size() &&
+      lexicon.displacement_.size() == num_slots;
+  for (int32_t d : lexicon.displacement_) {
+    consistent &= d >= 0 || -(int64_t(d) + 1) < int64_t(num_slots);
+  }
+  for (uint32_t id : lexicon.slot_id_) {
+    consistent &= id == kNotFound || size_t(id) + 1 < lexicon.offsets_.size();
+  }
+  // 没有词性名称的词表（只给出单词构造）所有词性都是 0
+  for (uint8_t pos : lexicon.pos_) {
+    consistent &= pos < lexicon.pos_names_.size() || (pos == 0 && lexicon.pos_names_.empty());
+  }
+  if (!consistent) throw std::runtime_error("Inconsistent lexicon file " + path);
+  return lexicon;
+}
+
+Lexicon Lexicon::Load(const std::string& path) {
+  struct stat st;
+  if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    return FromWordLists(path);
+  }
+  return FromBinary(path);
+}
+
+/**
+ * @brief 把词表（包括构造好的完美哈希）写成二进制文件。
+ *
+ * @param path: 文件路径
+ */
+void Lexicon::SaveBinary(const std::string& path) const {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (f == nullptr) throw std::runtime_error("Cannot write lexicon " + path);
+  fwrite(kMagic, 1, sizeof(kMagic), f);
+  WriteArray(f, std::vector<char>(pool_.begin(), pool_.end()));
+  WriteArray(f, offsets_);
+  WriteArray(f, pos_);
+  WriteArray(f, displacement_);
+  WriteArray(f, slot_id_);
+  std::string names;
+  for (const std::string& name : pos_names_) names += name + "\n";
+  WriteArray(f, std::vector<char>(names.begin(), names.end()));
+  if (fclose(f) != 0) throw std::runtime_error("Cannot write lexicon " + path);
+}
+
+uint64_t Lexicon::Fingerprint() const {
+  uint64_t h = Hash(pool_);
+  for (uint32_t id = 0; id < size(); ++id) {
+    h = Rehash(h, offsets_[id + 1]);
+    h = Rehash(h, pos_[id]);
+  }
+  for (const std::string& name : pos_names_) h = Rehash(h ^ Hash(name), 0);
+  return h;
+}
+
+/**
+ * @brief 用 hash-and-displace 构造最小完美哈希：先按 Hash(w) 分桶，
+ * 大桶优先为整个桶寻找一个无冲突的种子，只有一个单词的桶直接分配剩余的空槽位。
+ */
+void Lexicon::Build() {
+  std::vector<uint32_t> ids;
+  std::vector<uint64_t> hashes;
+  for (uint32_t id = 0; id < size(); ++id) {
+    if (Word(id).empty()) continue;
+    ids.push_back(id);
+    hashes.push_back(Hash(Word(id)));
+  }
+  const uint32_t n = ids.size();
+  displacement_.assign(std::max<uint32_t>(n, 1), 0);
+  slot_id_.assign(std::max<uint32_t>(n, 1), kNotFound);
+  if (n == 0) return;
+
+  // 按桶计数排序，bucket_start[b] .. bucket_start[b + 1] 是第 b 个桶的单词
+  std::vector<uint32_t> bucket_start(n + 1);
+  for (uint32_t i = 0; i < n; ++i) ++bucket_start[hashes[i] % n + 1];
+  for (uint32_t b = 0; b < n; ++b) bucket_start[b + 1] += bucket_start[b];
+  std::vector<uint32_t> members(n);
+  std::vector<uint32_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+  for (uint32_t i = 0; i < n; ++i) members[fill[hashes[i] % n]++] = i;
+  auto bucket_size = [&](uint32_t b) {
+    return bucket_start[b + 1] - bucket_start[b];
+  };
+  // 桶按大小降序排列（同样用计数排序）
+  uint32_t max_size = 0;
+  for (uint32_t b = 0; b < n; ++b) max_size = std::max(max_size, bucket_size(b));
+  std::vector<uint32_t> size_start(max_size + 2);
+  for (uint32_t b = 0; b < n; ++b) ++size_start[max_size - bucket_size(b) + 1];
+  for (uint32_t i = 0; i <= max_size; ++i) size_start[i + 1] += size_start[i];
+  std::vector<uint32_t> order(n);
+  for (uint32_t b = 0; b < n; ++b) order[size_start[max_size - bucket_size(b)]++] = b;
+
+  std::vector<uint32_t> slots;
+  size_t next = 0;
+  for (; next < n && bucket_size(order[next]) > 1; ++next) {
+    const uint32_t b = order[next];
+    for (uint32_t seed = 1;; ++seed) {
+      slots.clear();
+      bool ok = true;
+      for (uint32_t j = bucket_start[b]; j < bucket_start[b + 1]; ++j) {
+        const uint32_t i = members[j];
+        // 重复的单词永远冲突，只保留第一个 id
+        bool duplicate = false;
+        for (uint32_t k = bucket_start[b]; k < j; ++k) {
+          duplicate |= Word(ids[members[k]]) == Word(ids[i]);
+        }
+        if (duplicate) {
+          slots.push_back(kNotFound);
+          continue;
+        }
+        const uint32_t slot = Rehash(hashes[i], seed) % n;
+        if (slot_id_[slot] != kNotFound ||
+            std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+          ok = false;
+          break;
+        }
+        slots.push_back(slot);
+      }
+      if (!ok) continue;
+      for (uint32_t j = bucket_start[b]; j < bucket_start[b + 1]; ++j) {
+        const uint32_t slot = slots[j - bucket_start[b]];
+        if (slot != kNotFound) slot_id_[slot] = ids[members[j]];
+      }
+      displacement_[b] = seed;
+      break;
+    }
+  }
+  uint32_t free_slot = 0;
+  for (; next < n && bucket_size(order[next]) == 1; ++next) {
+    while (slot_id_[free_slot] != kNotFound) ++free_slot;
+    slot_id_[free_slot] = ids[members[bucket_start[order[next]]]];
+    displacement_[order[next]] = -static_cast<int32_t>(free_slot) - 1;
+  }
+}
+
+/**
+ * @brief 查询单词的 word id。
+ *
+ * @param word: 单词
+ * @return uint32_t: word id，不在词表中时为 kNotFound
+ */
+uint32_t Lexicon::Find(std::string_view word) const {
+  const uint32_t n = slot_id_.size();
+  if (n == 0) return kNotFound;
+  const uint64_t h = Hash(word);
+  const int32_t d = displacement_[h % n];
+  const uint32_t slot = d < 0 ? -d - 1 : Rehash(h, d) % n;
+  const uint32_t id = slot_id_[slot];
+  if (id == kNotFound || Word(id) != word) return kNotFound;
+  return id;
+}
+
+/**
+ * @brief 根据 word id 取单词。
+ *
+ * @param id: word id
+ * @return std::string_view: 单词，id 无效时为空
+ */
+std::string_view Lexicon::Word(uint32_t id) const {
+  if (id >= size()) return {};
+  return std::string_view(pool_).substr(offsets_[id],
+                                        offsets_[id + 1] - offsets_[id]);
+}
+
+}  // namespace nemo
@@ -0,0 +1,68 @@
+#ifndef NEMO_LEXICON_H_
+#define NEMO_LEXICON_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 分词：把句子切分为指向原句的 string_view，不复制字符。
+ * 连续的空白和标点都视为分隔符（例如 sentences.txt 中句末的 '.'），
+ * 单词内部的 '\'' 和 '-' 保留。
+ *
+ * @param sentence: 句子
+ * @param tokens: 输出，单词列表（会先被清空）
+ */
+void Tokenize(std::string_view sentence, std::vector<std::string_view>& tokens);
+
+/**
+ * @brief 词表：用最小完美哈希把单词映射为整数 word id，并记录每个单词的词性。
+ * 构造之后的查询不分配内存，查询代价为两次哈希加一次字符串比较。
+ * 词表可以在运行时从 words 目录下的词性文件或编译好的二进制词表文件加载。
+ */
+class Lexicon {
+ public:
+  static constexpr uint32_t kNotFound = UINT32_MAX;
+
+  Lexicon() = default;
+  // words[i] 的 word id 为 i，词性为 pos_names[pos[i]]；空字符串表示该 id 不对应任何单词
+  explicit Lexicon(const std::vector<std::string>& words,
+                   const std::vector<uint8_t>& pos = {},
+                   const std::vector<std::string>& pos_names = {});
+
+  // 按文件名排序读取 dir 下的 <词性>.txt，每行一个单词，
+  // sentences.txt 和 dependency.txt 除外
+  static Lexicon FromWordLists(const std::string& dir);
+  static Lexicon FromBinary(const std::string& path);
+  // path 是目录时按词性文件加载，否则按二进制词表加载
+  static Lexicon Load(const std::string& path);
+  void SaveBinary(const std::string& path) const;
+
+  uint32_t Find(std::string_view word) const;
+  std::string_view Word(uint32_t id) const;
+  uint8_t Pos(uint32_t id) const { return pos_[id]; }
+  const std::vector<std::string>& pos_names() const { return pos_names_; }
+  // word id 的上界（包括空位），即 LEX 脑区需要的 assembly 数量
+  size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+  // 单词、word id 和词性的哈希，用于检查持久化的数据是否使用同一个词表
+  uint64_t Fingerprint() const;
+
+ private:
+  void Build();
+
+  std::string pool_;                    // 所有单词首尾相接
+  std::vector<uint32_t> offsets_;       // 第 id 个单词在 pool_ 中的起止位置
+  std::vector<uint8_t> pos_;            // 每个 word id 的词性下标
+  std::vector<std::string> pos_names_;  // 词性名称，例如 "noun"
+  std::vector<int32_t> displacement_;   // 每个桶的哈希种子；负数表示直接指定的槽位
+  std::vector<uint32_t> slot_id_;       // 槽位到 word id 的映射
+};
+
+}  // namespace nemo
+
+#endif  // NEMO_LEXICON_H_
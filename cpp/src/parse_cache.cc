@@ -0,0 +1,265 @@
+#include "parse_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nemo {
+namespace {
+
+const char kMagic[8] = {'N', 'E', 'M', 'O', 'P', 'C', 'C', '1'};
+
+// 每个条目除了键和字符串之外的固定开销：链表节点、哈希表节点、set 节点和 vector
+constexpr size_t kEntryOverhead = 160;
+constexpr size_t kDependencyOverhead = 48 + 3 * sizeof(std::string);
+
+template<typename T>
+void Append(const T& value, std::string& out) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+T Read(const char*& data, const char* end) {
+  T value;
+  if (data + sizeof(T) > end) throw std::runtime_error("Truncated parse cache");
+  memcpy(&value, data, sizeof(T));
+  data += sizeof(T);
+  return value;
+}
+
+}  // namespace
+
+size_t ParseCacheKeyHash::operator()(const ParseCacheKey& key) const {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  auto mix = [&h](uint64_t value) {
+    h ^= value;
+    h *= 0x100000001b3ULL;
+  };
+  for (uint32_t id : key.word_ids) mix(id);
+  uint32_t p_bits;
+  memcpy(&p_bits, &key.p, sizeof(p_bits));
+  mix(p_bits);
+  mix(key.LEX_k);
+  mix(key.project_rounds);
+  mix(key.readout_method);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h;
+}
+
+bool MakeParseCacheKey(const Lexicon& lexicon, std::string_view sentence,
+                       float p, uint32_t LEX_k, uint32_t project_rounds,
+                       uint8_t readout_method, ParseCacheKey& key) {
+  std::vector<std::string_view> words;
+  Tokenize(sentence, words);
+  key.word_ids.clear();
+  for (std::string_view word : words) {
+    uint32_t id = lexicon.Find(word);
+    if (id == Lexicon::kNotFound) return false;
+    key.word_ids.push_back(id);
+  }
+  key.p = p;
+  key.LEX_k = LEX_k;
+  key.project_rounds = project_rounds;
+  key.readout_method = readout_method;
+  return true;
+}
+
+ParseCache::ParseCache(size_t max_bytes, uint32_t num_shards)
+    : max_bytes_(max_bytes),
+      shard_bytes_(max_bytes / std::max(1u, num_shards)),
+      shards_(new Shard[std::max(1u, num_shards)]),
+      num_shards_(std::max(1u, num_shards)) {}
+
+size_t ParseCache::EntryBytes(const ParseCacheKey& key, const Dependencies& dependencies) {
+  size_t bytes = kEntryOverhead + key.word_ids.size() * sizeof(uint32_t);
+  for (const auto& dependency : dependencies) {
+    bytes += kDependencyOverhead;
+    for (const std::string& word : dependency) bytes += word.size();
+  }
+  return bytes;
+}
+
+ParseCache::Shard& ParseCache::ShardFor(const ParseCacheKey& key) const {
+  // 高位选 shard，低位留给 shard 内的哈希表
+  return shards_[(ParseCacheKeyHash()(key) >> 32) % num_shards_];
+}
+
+bool ParseCache::Get(const ParseCacheKey& key, Dependencies& dependencies) {
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.index.find(key);
+  if (it == shard.index.end()) {
+    ++shard.misses;
+    return false;
+  }
+  ++shard.hits;
+  shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+  dependencies = it->second->dependencies;
+  return true;
+}
+
+void ParseCache::Put(const ParseCacheKey& key, const Dependencies& dependencies) {
+  const size_t bytes = EntryBytes(key, dependencies);
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (bytes > shard_bytes_) return;
+  auto it = shard.index.find(key);
+  if (it != shard.index.end()) {
+    shard.bytes -= it->second->bytes;
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+  }
+  while (!shard.lru.empty() && shard.bytes + bytes > shard_bytes_) {
+    const Entry& oldest = shard.lru.back();
+    shard.bytes -= oldest.bytes;
+    shard.index.erase(oldest.key);
+    shard.lru.pop_back();
+    ++shard.evictions;
+  }
+  shard.lru.push_front(Entry{key, dependencies, bytes});
+  shard.index.emplace(key, shard.lru.begin());
+  shard.bytes += bytes;
+  ++shard.insertions;
+}
+
+void ParseCache::Clear() {
+  for (uint32_t i = 0; i < num_shards_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    shards_[i].lru.clear();
+    shards_[i].index.clear();
+    shards_[i].bytes = 0;
+  }
+}
+
+ParseCache::Stats ParseCache::stats() const {
+  Stats stats;
+  for (uint32_t i = 0; i < num_shards_; ++i) {
+    const Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    stats.hits += shard.hits;
+    stats.misses += shard.misses;
+    stats.insertions += shard.insertions;
+    stats.evictions += shard.evictions;
+    stats.entries += shard.lru.size();
+    stats.bytes += shard.bytes;
+  }
+  return stats;
+}
+
+/**
+ * @brief 文件格式：magic | u64 词表 fingerprint | 条目...，每个条目为
+ * f32 p | u32 LEX_k | u32 project_rounds | u8 readout_method | u32 单词数 | word id... |
+ * u32 依赖数 | 每个依赖 3 个 (u32 长度 | 字节)。每个 shard 从最久未用的条目开始写，
+ * 加载时依次 Put，LRU 顺序得以保留。
+ */
+void ParseCache::Save(const std::string& path, uint64_t lexicon_fingerprint) const {
+  std::string data(kMagic, sizeof(kMagic));
+  Append(lexicon_fingerprint, data);
+  for (uint32_t i = 0; i < num_shards_; ++i) {
+    const Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto it = shard.lru.rbegin(); it != shard.lru.rend(); ++it) {
+      const ParseCacheKey& key = it->key;
+      Append(key.p, data);
+      Append(key.LEX_k, data);
+      Append(key.project_rounds, data);
+      Append(key.readout_method, data);
+      Append(uint32_t(key.word_ids.size()), data);
+      for (uint32_t id : key.word_ids) Append(id, data);
+      Append(uint32_t(it->dependencies.size()), data);
+      for (const auto& dependency : it->dependencies) {
+        for (const std::string& word : dependency) {
+          Append(uint32_t(word.size()), data);
+          data.append(word);
+        }
+      }
+    }
+  }
+  const std::string temp_path = path + ".tmp";
+  FILE* f = fopen(temp_path.c_str(), "wb");
+  if (f == nullptr) throw std::runtime_error("Cannot write parse cache " + temp_path);
+  const bool written = fwrite(data.data(), 1, data.size(), f) == data.size();
+  if (fclose(f) != 0 || !written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    remove(temp_path.c_str());
+    throw std::runtime_error("Cannot write parse cache " + path);
+  }
+}
+
+size_t ParseCache::Load(const std::string& path, uint64_t lexicon_fingerprint) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (f == nullptr) return 0;
+  fseek(f, 0, SEEK_END);
+  const long file_size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  std::vector<char> buffer(std::max<long>(file_size, 0));
+  const size_t num_read = fread(buffer.data(), 1, buffer.size(), f);
+  fclose(f);
+  if (num_read != buffer.size() || buffer.size() < sizeof(kMagic) ||
+      memcmp(buffer.data(), kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Invalid parse cache file " + path);
+  }
+  const char* data = buffer.data() + sizeof(kMagic);
+  const char* end = buffer.data() + buffer.size();
+  if (Read<uint64_t>(data, end) != lexicon_fingerprint) return 0;
+  size_t loaded = 0;
+  while (data < end) {
+    ParseCacheKey key;
+    key.p = Read<float>(data, end);
+    key.LEX_k = Read<uint32_t>(data, end);
+    key.project_rounds = Read<uint32_t>(data, end);
+    key.readout_method = Read<uint8_t>(data, end);
+    // 按剩余字节数检查长度，损坏的长度不会导致分配大量内存
+    const uint32_t num_words = Read<uint32_t>(data, end);
+    if (num_words > size_t(end - data) / sizeof(uint32_t)) {
+      throw std::runtime_error("Truncated parse cache");
+    }
+    key.word_ids.resize(num_words);
+    for (uint32_t& id : key.word_ids) id = Read<uint32_t>(data, end);
+    Dependencies dependencies;
+    const uint32_t count = Read<uint32_t>(data, end);
+    // 每个依赖至少包含三个长度
+    if (count > size_t(end - data) / (3 * sizeof(uint32_t))) {
+      throw std::runtime_error("Truncated parse cache");
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+      std::vector<std::string> dependency(3);
+      for (std::string& word : dependency) {
+        const uint32_t size = Read<uint32_t>(data, end);
+        if (size > size_t(end - data)) throw std::runtime_error("Truncated parse cache");
+        word.assign(data, size);
+        data += size;
+      }
+      dependencies.insert(std::move(dependency));
+    }
+    Put(key, dependencies);
+    ++loaded;
+  }
+  return loaded;
+}
+
+std::set<std::vector<std::string>> parse(const std::string& sentence, const ParserOptions& options,
+                                         ParseCache& cache,
+                                         std::shared_ptr<const Lexicon> lexicon) {
+  if (!lexicon) lexicon = DefaultLexicon();
+  ParseCacheKey key;
+  // 只有 seed 为 42、其余参数为默认值时键才能唯一确定结果
+  const ParserOptions defaults;
+  const bool cacheable =
+      options.seed == defaults.seed && options.non_LEX_n == defaults.non_LEX_n &&
+      options.non_LEX_k == defaults.non_LEX_k && options.default_beta == defaults.default_beta &&
+      options.LEX_beta == defaults.LEX_beta && options.recurrent_beta == defaults.recurrent_beta &&
+      options.interarea_beta == defaults.interarea_beta && !options.verbose &&
+      MakeParseCacheKey(*lexicon, sentence, options.p, options.LEX_k, options.project_rounds,
+                        options.readout_method, key);
+  std::set<std::vector<std::string>> dependencies;
+  if (cacheable && cache.Get(key, dependencies)) return dependencies;
+  dependencies = parse(sentence, options, lexicon);
+  if (cacheable) cache.Put(key, dependencies);
+  return dependencies;
+}
+
+}  // namespace nemo
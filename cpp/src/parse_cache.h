@@ -0,0 +1,115 @@
+#ifndef NEMO_PARSE_CACHE_H_
+#define NEMO_PARSE_CACHE_H_
+
+#include "parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nemo {
+
+// 决定解析结果的全部输入：句子的 word id 序列和影响结果的参数（seed 固定为 42）
+struct ParseCacheKey {
+  std::vector<uint32_t> word_ids;
+  float p = 0.1f;
+  uint32_t LEX_k = 20;
+  uint32_t project_rounds = 20;
+  uint8_t readout_method = 2;
+
+  bool operator==(const ParseCacheKey& other) const {
+    return word_ids == other.word_ids && p == other.p && LEX_k == other.LEX_k &&
+           project_rounds == other.project_rounds && readout_method == other.readout_method;
+  }
+};
+
+struct ParseCacheKeyHash {
+  size_t operator()(const ParseCacheKey& key) const;
+};
+
+// 按 parse() 的分词生成键，不同的空白和标点得到相同的键；有未知单词时返回 false
+bool MakeParseCacheKey(const Lexicon& lexicon, std::string_view sentence,
+                       float p, uint32_t LEX_k, uint32_t project_rounds,
+                       uint8_t readout_method, ParseCacheKey& key);
+
+/**
+ * @brief parse() 结果的 LRU 缓存，线程安全。键按哈希分到多个 shard，每个 shard
+ * 有自己的锁、LRU 链表和 max_bytes / num_shards 的内存预算，超出时淘汰最久未用
+ * 的条目。内存按键和依赖字符串的大小加上固定的节点开销估计。
+ *
+ * 键中是 word id，一个缓存只用于一个词表。Save 把所有条目写到文件，Load 读回
+ * （文件中记录词表的 Fingerprint，词表不同时不加载），重启的进程可以从已有的结果开始。
+ */
+class ParseCache {
+ public:
+  typedef std::set<std::vector<std::string>> Dependencies;
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+  };
+
+  explicit ParseCache(size_t max_bytes, uint32_t num_shards = 16);
+
+  bool Get(const ParseCacheKey& key, Dependencies& dependencies);
+  void Put(const ParseCacheKey& key, const Dependencies& dependencies);
+  void Clear();
+
+  Stats stats() const;
+  size_t max_bytes() const { return max_bytes_; }
+
+  // 写出时先写到临时文件再改名，写出失败不会破坏已有的文件
+  void Save(const std::string& path, uint64_t lexicon_fingerprint) const;
+  // 返回加载的条目数；文件不存在或词表不同时返回 0，文件损坏时抛出 std::runtime_error
+  size_t Load(const std::string& path, uint64_t lexicon_fingerprint);
+
+ private:
+  struct Entry {
+    ParseCacheKey key;
+    Dependencies dependencies;
+    size_t bytes;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+    std::list<Entry> lru;  // 最近使用的在前面
+    std::unordered_map<ParseCacheKey, std::list<Entry>::iterator, ParseCacheKeyHash> index;
+    size_t bytes = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t insertions = 0;
+    uint64_t evictions = 0;
+  };
+
+  static size_t EntryBytes(const ParseCacheKey& key, const Dependencies& dependencies);
+  Shard& ShardFor(const ParseCacheKey& key) const;
+
+  const size_t max_bytes_;
+  const size_t shard_bytes_;
+  std::unique_ptr<Shard[]> shards_;
+  const uint32_t num_shards_;
+};
+
+/**
+ * @brief 使用缓存的 parse()：命中时直接返回，否则解析后写入缓存。
+ * 有未知单词的句子不缓存，与 parse() 一样抛出异常。
+ */
+std::set<std::vector<std::string>> parse(const std::string& sentence, const ParserOptions& options,
+                                         ParseCache& cache,
+                                         std::shared_ptr<const Lexicon> lexicon = nullptr);
+
+}  // namespace nemo
+
+#endif  // NEMO_PARSE_CACHE_H_
@@ -166,47 +166,52 @@ RuleSet generic_preposition(int index) {
   };
 }
 
-// std::unordered_map<std::string, RuleSet> generateLexemeDict() {
-//   std::unordered_map<std::string, RuleSet> lexemeDict;
-
-//   lexemeDict["the"] = generic_determinant(0);
-//   lexemeDict["a"] = generic_determinant(1);
-//   lexemeDict["dogs"] = generic_noun(2);
-//   lexemeDict["cats"] = generic_noun(3);
-//   lexemeDict["mice"] = generic_noun(4);
-//   lexemeDict["people"] = generic_noun(5);
-//   lexemeDict["chase"] = generic_trans_verb(6);
-//   lexemeDict["love"] = generic_trans_verb(7);
-//   lexemeDict["bite"] = generic_trans_verb(8);
-//   lexemeDict["of"] = generic_preposition(9);
-//   lexemeDict["big"] = generic_adjective(10);
-//   lexemeDict["bad"] = generic_adjective(11);
-//   lexemeDict["run"] = generic_intrans_verb(12);
-//   lexemeDict["fly"] = generic_intrans_verb(13);
-//   lexemeDict["quickly"] = generic_adverb(14);
-//   lexemeDict["in"] = generic_preposition(15);
-//   lexemeDict["are"] = generic_copula(16);
-//   lexemeDict["man"] = generic_noun(17);
-//   lexemeDict["woman"] = generic_noun(18);
-//   lexemeDict["saw"] = generic_trans_verb(19);
-
-//   return lexemeDict;
-// }
+RuleSet generic_rule_set(const std::string& pos, int index) {
+  if (pos == "noun") return generic_noun(index);
+  if (pos == "trans_verb") return generic_trans_verb(index);
+  if (pos == "intrans_verb") return generic_intrans_verb(index);
+  if (pos == "copula") return generic_copula(index);
+  if (pos == "adverb") return generic_adverb(index);
+  if (pos == "determinant") return generic_determinant(index);
+  if (pos == "adjective") return generic_adjective(index);
+  if (pos == "preposition") return generic_preposition(index);
+  throw std::runtime_error("Unknown part of speech: " + pos);
+}
+
+std::shared_ptr<const Lexicon> DefaultLexicon() {
+  static const std::shared_ptr<const Lexicon> lexicon = [] {
+    std::vector<std::string> words;
+    std::vector<uint8_t> pos;
+    std::vector<std::string> pos_names;
+    for (const auto& entry : DEFAULT_LEXICON) {
+      auto it = std::find(pos_names.begin(), pos_names.end(), entry[1]);
+      pos.push_back(it - pos_names.begin());
+      if (it == pos_names.end()) pos_names.push_back(entry[1]);
+      words.push_back(entry[0]);
+    }
+    return std::make_shared<const Lexicon>(words, pos, pos_names);
+  }();
+  return lexicon;
+}
 
 /*=================================TODO: ParserBrain=================================*/
 /*对应 parser.py 的 ParserBrain 和 EnglishParserBrain */
 
 
 ParserBrain::ParserBrain(float p, float beta, float max_weight, uint32_t seed,
-    std::unordered_map<std::string, RuleSet> lexeme_dict, 
+    std::shared_ptr<const Lexicon> lexicon, 
     std::vector<std::string> all_areas, 
     std::vector<std::string> recurrent_areas, 
     std::vector<std::string> initial_areas, 
     ProjectMap readout_rules)
-    : Brain(p, beta, max_weight, seed), lexeme_dict(lexeme_dict), 
+    : Brain(p, beta, max_weight, seed),
+    lexicon(lexicon ? lexicon : std::make_shared<const Lexicon>()), 
     all_areas(all_areas), recurrent_areas(recurrent_areas), 
     initial_areas(initial_areas), readout_rules(readout_rules) {
         initialize_states();
+        for (const auto& pos : this->lexicon->pos_names()) {
+            rules_by_pos.push_back(generic_rule_set(pos, 0));
+        }
 }
 
 // (s)356 add + discard
@@ -266,6 +271,27 @@ void ParserBrain::parse_project() {
 }
 
 
+/*
+parser.py parseHelper：投影之前，LEX 不投影到的脑区固定其 assembly，
+LEX 投影到的脑区清空 assembly，由新的单词重新形成
+*/
+void ParserBrain::prepareProjection(bool verbose) {
+    ProjectMap proj_map = getProjectMap();
+    auto lex_it = proj_map.find(LEX);
+    for(const auto& area : proj_map){
+        if(lex_it == proj_map.end() || !lex_it->second.count(area.first)){
+            GetArea(area.first).fixed_assembly = true;
+            if(verbose) std::cout << "FIXED assembly bc not LEX->this area in: " << area.first << std::endl;
+        }
+        else if(area.first!=LEX){
+            GetArea(area.first).fixed_assembly = false;
+            GetArea(area.first).activated.clear();
+            if(verbose) std::cout << "ERASED assembly because LEX->this area in " << area.first << std::endl;
+        }
+    }
+}
+
+
 /*
 // parser.py 395 update
 用于 readout 部分的纤维束激活，该部分保存所有激活过的纤维束
@@ -322,7 +348,10 @@ void ParserBrain::activateWord(const std::string& area_name, const std::string&
     // size_t assembly_index, overlap;
     // ReadAssembly(area_name, assembly_index, overlap);
 
-    ActivateArea(area_name, lexeme_dict[word].index);
+    uint32_t word_id = lexicon->Find(word);
+    if (word_id == Lexicon::kNotFound)
+        throw std::runtime_error("Unknown word: " + word);
+    ActivateArea(area_name, word_id);
 }
 
 
@@ -338,25 +367,35 @@ std::string ParserBrain::interpretAssemblyAsString(const std::string& area_name)
 
 
 std::string ParserBrain::getWord(const std::string& area_name, double min_overlap) {
-    auto& area = GetArea(area_name);
-    // (s)437 set(self.area_by_name[area_name].winners)
-    const std::vector<uint32_t>& activated = area.activated;
+    return getWord(area_name, GetArea(area_name).activated, min_overlap);
+}
+
+
+/*
+按 assembly 统计 activated 的重叠数。activated 至多 k 个神经元，阈值不低于 k/2 时
+只有重叠最多的 assembly 可能达到阈值，因此不必逐个单词求交集。
+*/
+std::string ParserBrain::getWord(const std::string& area_name,
+                                 const std::vector<uint32_t>& activated,
+                                 double min_overlap) {
     if (activated.empty())
         throw std::runtime_error("Cannot get word because no assembly in " + area_name);
+    const Area& area = GetArea(area_name);
     int area_k = area.k;
     int threshold = min_overlap  * area_k;
-    for (const auto& pair : lexeme_dict) {
-        const std::string word = pair.first;
-        int word_index = pair.second.index;
-        int word_assembly_start = word_index * area_k;
-        int word_assembly_end = word_assembly_start + area_k;
-        std::vector<uint32_t> word_assembly;
-        for (int i = word_assembly_start; i < word_assembly_end; ++i)
-            word_assembly.push_back(i);
-        if (NumCommon(activated, word_assembly) >= threshold ) { // len - 长度是否正确
-            return word;
+    std::unordered_map<uint32_t, int> overlaps;
+    uint32_t best_index = 0;
+    int best_overlap = 0;
+    for (uint32_t neuron : activated) {
+        int overlap = ++overlaps[area.Assembly(neuron)];
+        if (overlap > best_overlap) {
+            best_overlap = overlap;
+            best_index = area.Assembly(neuron);
         }
     }
+    if (best_overlap >= threshold) {
+        return std::string(lexicon->Word(best_index));
+    }
     return ""; // None
 }
 
@@ -377,15 +416,18 @@ std::unordered_map<std::string, std::unordered_set<std::string>> ParserBrain::ge
 EnglishParserBrain::EnglishParserBrain(float p, int non_LEX_n, 
     int non_LEX_k, int LEX_k, double default_beta, 
     double LEX_beta, double recurrent_beta, 
-    double interarea_beta, bool verbose)
-    : ParserBrain(p, default_beta, 10000.0, 42, // (s)max_weight and seed
-    generateLexemeDict(), AREAS, RECURRENT_AREAS, 
+    double interarea_beta, bool verbose,
+    std::shared_ptr<const Lexicon> lexicon, uint32_t seed)
+    : ParserBrain(p, default_beta, 10000.0, seed, // (s)max_weight
+    lexicon ? lexicon : DefaultLexicon(), AREAS, RECURRENT_AREAS, 
     {LEX, SUBJ, VERB}, ENGLISH_READOUT_RULES),
     verbose(verbose) {
-    int LEX_n = LEX_SIZE * LEX_k;
+    // LEX 的大小由词表决定，每个单词一个 assembly
+    int LEX_n = this->lexicon->size() * LEX_k;
     // (s) parser.py 508 add_explicit_area 添加激活的脑区
     // AddArea(LEX, LEX_n, LEX_k, default_beta);
-    AddStimulus(LEX, LEX_n, LEX_k);
+    // 单词的 assembly 在第一次被激活时才生成，内存只随出现过的单词增长
+    AddStimulus(LEX, LEX_n, LEX_k, /*lazy=*/true);
 
     int DET_k = LEX_k;
     AddArea(SUBJ, non_LEX_n, non_LEX_k);
@@ -411,28 +453,19 @@ EnglishParserBrain::EnglishParserBrain(float p, int non_LEX_n,
     brain.py 250 - update_plasticities 的逻辑: (new_beta 是新的更新率)
     custom_plasticities consists of area1: list[ (area2, new_beta) ], 
     represents new plasticity FROM area2 INTO area1.
-
-    Brain 的 UpdatePlasticity() 是 private 成员，与 python 的基本思路不同，
-    而且 const float beta_ 更新率是不可变的，因此我好像不用实现这一部分？
-    因此我按照 python 写法更新 beta
+    每个 fiber 有自己的 beta（Brain::SetFiberBeta），其余 fiber 使用 default_beta
     */
-    // std::unordered_map<std::string, std::vector<std::pair<std::string, double>>> custom_plasticities;
-    // for (const auto& area : RECURRENT_AREAS) { // 525 append
-    //     custom_plasticities[LEX].emplace_back(area, LEX_beta);
-    //     custom_plasticities[area].emplace_back(LEX, LEX_beta);
-    //     custom_plasticities[area].emplace_back(area, recurrent_beta);
-    //     for (const auto& other_area : RECURRENT_AREAS) {
-    //         if (other_area == area) continue;
-    //         custom_plasticities[area].emplace_back(other_area, interarea_beta);
-    //     }
-    // }
-
-    // for (const auto& entry : custom_plasticities) {
-    //     // entry - to_area, update_rules
-    //     for (const auto& subentry : entry.second) {
-    //         // subentry - from_area, new_beta
-    //     }
-    // }
+    PlasticityMap custom_plasticities;
+    for (const auto& area : RECURRENT_AREAS) { // 525 append
+        custom_plasticities[LEX].emplace_back(area, LEX_beta);
+        custom_plasticities[area].emplace_back(LEX, LEX_beta);
+        custom_plasticities[area].emplace_back(area, recurrent_beta);
+        for (const auto& other_area : RECURRENT_AREAS) {
+            if (other_area == area) continue;
+            custom_plasticities[area].emplace_back(other_area, interarea_beta);
+        }
+    }
+    UpdatePlasticities(custom_plasticities);
 }
 
 
@@ -446,13 +479,19 @@ ProjectMap EnglishParserBrain::getProjectMap() {
 
 
 std::string EnglishParserBrain::getWord(const std::string& area_name, double min_overlap) {
-    auto word = ParserBrain::getWord(area_name, min_overlap);
+    return getWord(area_name, GetArea(area_name).activated, min_overlap);
+}
+
+
+std::string EnglishParserBrain::getWord(const std::string& area_name,
+                                        const std::vector<uint32_t>& activated,
+                                        double min_overlap) {
+    auto word = ParserBrain::getWord(area_name, activated, min_overlap);
     if (!word.empty()) {
         return word;
     }
     if (word.empty() && area_name == DET) {
         // (s)parser.py 548 set(self.area_by_name[area_name].winners)
-        const std::vector<uint32_t>& activated = GetArea(area_name).activated;
         auto area_k = GetArea(area_name).k;
         double threshold = min_overlap * area_k;
         int nodet_index = DET_SIZE - 1;
@@ -472,122 +511,170 @@ std::string EnglishParserBrain::getWord(const std::string& area_name, double min
 /*=================================TODO: ParserDebugger=================================*/
 /*对应 parser.py 的 ParserDebugger 和 parser 函数（parserHelp） */
 
-std::vector<std::string> split(std::string sentence){
-    using namespace std;
-    string temp;
-    vector<string> ans;
-    for (int i = 0; i < sentence.size();i++){
-        if(sentence[i]==' '){
-            ans.emplace_back(temp);
-            temp.clear();
-        }
-        else temp += sentence[i];
+/*
+对应 parser.py 的 read_out，但不调用 Brain::Project：每条依赖只沿一条 fiber 计算
+目标脑区的 top-k（Brain::ReadoutTopK），中间结果保存在 state 中而不写回脑区，
+因此 readout 不会改变 brain 的状态。
+*/
+void ParserBrain::readout(const std::string& area, const ProjectMap& mapping,
+                          ReadoutState& state,
+                          std::vector<std::vector<std::string>>& dependencies) {
+    auto it = mapping.find(area);
+    if (it == mapping.end()) return;
+    const auto& to_areas = it->second;
+    for (const auto& to_area : to_areas) {
+        if (!state.count(to_area)) state[to_area] = GetArea(to_area).activated;
+    }
+    if (!state.count(area)) state[area] = GetArea(area).activated;
+    if (!state.count(LEX)) state[LEX] = GetArea(LEX).activated;
+    // 尚未形成 assembly 的脑区（例如句子还没读到动词）没有可读出的依赖
+    if (state[area].empty()) return;
+    // 与 Project(area -> to_areas) 相同，所有目标脑区都由 area 的旧状态同时计算
+    for (const auto& to_area : to_areas) {
+        ReadoutTopK(area, state[area], to_area, state[to_area]);
+    }
+    auto this_word = getWord(LEX, state[LEX]);
+    for (const auto& to_area : to_areas) {
+        if (to_area == LEX || state[to_area].empty()) continue;
+        ReadoutTopK(to_area, state[to_area], LEX, state[LEX]);
+        auto other_word = getWord(LEX, state[LEX]);
+        dependencies.push_back({this_word, other_word, to_area});
     }
-    ans.emplace_back(temp);
-    return ans;
+    for (const auto& to_area : to_areas) {
+        if (to_area != LEX) readout(to_area, mapping, state, dependencies);
+    }
+}
+
+
+std::vector<std::vector<std::string>> ParserBrain::readoutDependencies(
+    const std::string& root, const ProjectMap& mapping) {
+    ReadoutState state;
+    std::vector<std::vector<std::string>> dependencies;
+    readout(root, mapping, state, dependencies);
+    return dependencies;
+}
+
+// parse() 原有参数对应的 ParserOptions，其余参数取默认值
+static ParserOptions MakeOptions(float p, int LEX_k, int project_rounds,
+                                 bool verbose, int readout_method) {
+    ParserOptions options;
+    options.p = p;
+    options.LEX_k = LEX_k;
+    options.project_rounds = project_rounds;
+    options.verbose = verbose;
+    options.readout_method = readout_method;
+    return options;
 }
 
-// python下Area::winners 到 c++下Area::activated 可参考 Brain::ComputeKnownActivations
-void read_out(std::string area, ProjectMap mapping, EnglishParserBrain &b,
-              std::vector<std::vector<std::string>> &dependencies){
+
+IncrementalParser::IncrementalParser(float p, int LEX_k, int project_rounds,
+                                     bool verbose, int readout_method,
+                                     std::shared_ptr<const Lexicon> lexicon)
+    : IncrementalParser(MakeOptions(p, LEX_k, project_rounds, verbose, readout_method),
+                        lexicon) {}
+
+
+IncrementalParser::IncrementalParser(const ParserOptions& options,
+                                     std::shared_ptr<const Lexicon> lexicon)
+    : b_(options.p, options.non_LEX_n, options.non_LEX_k, options.LEX_k,
+         options.default_beta, options.LEX_beta, options.recurrent_beta,
+         options.interarea_beta, options.verbose, lexicon, options.seed),
+      project_rounds_(options.project_rounds), verbose_(options.verbose),
+      readout_method_(options.readout_method) {}
+
+
+IncrementalParser::IncrementalParser(const EnglishParserBrain& brain, int project_rounds,
+                                     bool verbose, int readout_method)
+    : b_(brain), project_rounds_(project_rounds), verbose_(verbose),
+      readout_method_(readout_method) {}
+
+
+void IncrementalParser::feed(std::string_view word) {
+    uint32_t word_id = b_.lexicon->Find(word);
+    if (word_id == Lexicon::kNotFound)
+        throw std::runtime_error("Unknown word: " + std::string(word));
+    feed_id(word_id);
+}
+
+
+// 对应 parser.py parseHelper 中处理单个单词的循环体
+void IncrementalParser::feed_id(uint32_t word_id) {
     using namespace std;
-    auto to_areas = mapping[area];
-    ProjectMap temp1;
-    temp1[area] = to_areas;
-    b.Project(temp1, 1, false);
-    auto this_word = b.getWord(LEX);
-    for(auto to_area : to_areas){
-        if(to_area==LEX) continue;
-        ProjectMap temp2;
-        temp2[to_area] = {LEX};
-        b.Project(temp2, 1, false);
-        auto other_word = b.getWord(LEX);
-        vector<string> temp3 = {this_word, other_word, to_area};
-        dependencies.emplace_back(temp3);
+    if (finished_)
+        throw runtime_error("Cannot feed word after finish: " + string(b_.lexicon->Word(word_id)));
+    if (b_.lexicon->Word(word_id).empty())
+        throw runtime_error("Unknown word id: " + to_string(word_id));
+    const RuleSet& lexeme = b_.lexeme(word_id);
+    b_.activateIndex(LEX, word_id);
+    if(verbose_){
+        cout << "Activated word: " << b_.lexicon->Word(word_id) << endl;
+        auto area = b_.GetArea(LEX);
+        // 打印 area 的 activated
+        area.Print("LEX");
+    }
+
+    for(const Rule& rule : lexeme.pre_rules){
+        b_.applyRule(rule);
     }
-    for(auto to_area : to_areas){
-        if(to_area!=LEX) read_out(to_area, mapping, b, dependencies);
+
+    b_.prepareProjection(verbose_);
+
+    for (int i = 0; i < project_rounds_;i++){
+        b_.parse_project();
+    }
+
+    for(const Rule& rule : lexeme.post_rules){
+        b_.applyRule(rule);
     }
 }
 
-std::set<std::vector<std::string>> parse(std::string sentence, float p, int LEX_k, int project_rounds,
-	                                     bool verbose, bool debug, int readout_method){
-    using namespace std;
-    EnglishParserBrain b(p, 10000, 100, LEX_k, 0.2, 1.0, 0.05, 0.5, verbose);
-    unordered_map<string, RuleSet> lexeme_dict = generateLexemeDict();
-    vector<string> all_areas = AREAS;
-    vector<string> explicit_areas = EXPLICIT_AREAS;
-    ProjectMap readout_rules = ENGLISH_READOUT_RULES;
-    
-    {   //parserHelper
-        vector<string> words = split(sentence);
-        bool extreme_debug = false;
-        for(string word : words){
-            RuleSet lexeme = lexeme_dict[word];
-            b.activateWord(LEX, word);
-            if(verbose){
-                cout << "Activated word: " << word << endl;
-                auto area = b.GetArea(LEX);
-                // 打印 area 的 activated
-                area.Print("LEX");
-            }
-            
-            for(Rule rule : lexeme.pre_rules){
-                b.applyRule(rule);
-            }
 
-            ProjectMap proj_map = b.getProjectMap();
-            for(const auto area : proj_map){
-                if(!proj_map[LEX].count(area.first)){
-                    b.GetArea(area.first).fixed_assembly = true;
-                    if(verbose) cout << "FIXED assembly bc not LEX->this area in: " << area.first << endl;
-                }
-                else if(area.first!=LEX){
-                    b.GetArea(area.first).fixed_assembly = false;
-                    b.GetArea(area.first).activated.clear();
-                    if(verbose) cout << "ERASED assembly because LEX->this area in " << area.first << endl;
+std::set<std::vector<std::string>> IncrementalParser::snapshot_dependencies() {
+    using namespace std;
+    set<vector<string>> dependency_set;
+    if(readout_method_==2){
+        auto activated_fibers = b_.getActivatedFibers();
+        if(verbose_){
+            cout << "Got activated fibers: ";
+            for(auto fiber : activated_fibers){
+                cout << fiber.first << ": ";
+                for(auto to_area : fiber.second){
+                    cout << to_area << ", ";
                 }
+                cout << endl;
             }
+        }
+        auto dependencies = b_.readoutDependencies(VERB, activated_fibers);
+        dependency_set.insert(dependencies.begin(), dependencies.end());
+    }
+    return dependency_set;
+}
 
-            proj_map = b.getProjectMap();
-            if(verbose){}
 
-            for (int i = 0; i < project_rounds;i++){
-                b.parse_project();
-            }
+std::set<std::vector<std::string>> IncrementalParser::finish() {
+    for(const auto& area : b_.all_areas){
+        b_.GetArea(area).fixed_assembly = false;
+    }
+    finished_ = true;
+    return snapshot_dependencies();
+}
 
-            for(auto rule : lexeme.post_rules){
-                b.applyRule(rule);
-            }
 
-            if(debug){}
-        }
+std::set<std::vector<std::string>> parse(std::string sentence, float p, int LEX_k, int project_rounds,
+	                                     bool verbose, bool /*debug*/, int readout_method){
+    return parse(sentence, MakeOptions(p, LEX_k, project_rounds, verbose, readout_method));
+}
 
-        for(auto area : all_areas){
-            b.GetArea(area).fixed_assembly = false;
-        }
 
-        vector<vector<string>> dependencies;
-        if(readout_method==1){}
-        else if(readout_method==2){
-            auto activated_fibers = b.getActivatedFibers();
-            if(verbose){
-                cout << "Got activated fibers: ";
-                for(auto fiber : activated_fibers){
-                    cout << fiber.first << ": ";
-                    for(auto to_area : fiber.second){
-                        cout << to_area << ", ";
-                    }
-                    cout << endl;
-                } 
-            }
-            read_out(VERB, activated_fibers, b, dependencies);
-            
-            set<vector<string>> dependency_set;
-            dependency_set.insert(dependencies.begin(), dependencies.end());
-            return dependency_set;
-        }
+std::set<std::vector<std::string>> parse(const std::string& sentence, const ParserOptions& options,
+                                         std::shared_ptr<const Lexicon> lexicon){
+    IncrementalParser parser(options, lexicon);
+    std::vector<std::string_view> words;
+    Tokenize(sentence, words);
+    for(std::string_view word : words){
+        parser.feed(word);
     }
+    return parser.finish();
 }
 
 }  // namespace nemo
\ No newline at end of file
@@ -15,7 +15,9 @@
 #include <exception>
 #include <stdexcept>
 #include <algorithm>
+#include <memory>
 #include "parser_util.h"
+#include "lexicon.h"
 
 namespace nemo {
 
@@ -86,7 +88,10 @@ RuleSet generic_adverb(int index);
 RuleSet generic_determinant(int index);
 RuleSet generic_adjective(int index);
 RuleSet generic_preposition(int index);
-std::unordered_map<std::string, RuleSet> generateLexemeDict();
+// 根据词性名称（words 目录下的文件名，例如 "noun"）生成对应的 RuleSet
+RuleSet generic_rule_set(const std::string& pos, int index);
+// 内置的默认词表（lexemeDict.h），所有 brain 共享同一份
+std::shared_ptr<const Lexicon> DefaultLexicon();
 
 // ProjectMap
 const ProjectMap ENGLISH_READOUT_RULES = {
@@ -103,7 +108,8 @@ const ProjectMap ENGLISH_READOUT_RULES = {
 
 class ParserBrain : public Brain {
 public:
-  std::unordered_map<std::string, RuleSet> lexeme_dict;
+  std::shared_ptr<const Lexicon> lexicon; // 单词到 word id（即 assembly 索引）和词性的映射
+  std::vector<RuleSet> rules_by_pos;      // 每种词性的 RuleSet，下标为 Lexicon::Pos
   std::vector<std::string> all_areas;
   std::vector<std::string> recurrent_areas;
   std::vector<std::string> initial_areas;
@@ -114,7 +120,7 @@ public:
   std::unordered_map<std::string, std::unordered_set<std::string>> activated_fibers; // ProjectMap
 
   ParserBrain(float p, float beta, float max_weight, uint32_t seed, 
-              std::unordered_map<std::string, RuleSet> lexeme_dict = {}, 
+              std::shared_ptr<const Lexicon> lexicon = nullptr, 
               std::vector<std::string> all_areas = {}, 
               std::vector<std::string> recurrent_areas = {}, 
               std::vector<std::string> initial_areas = {}, 
@@ -122,6 +128,9 @@ public:
 
   void initialize_states();
 
+  // 单词的 RuleSet；规则与 RuleSet::index 无关，单词的 assembly 索引就是 word id
+  const RuleSet& lexeme(uint32_t word_id) const { return rules_by_pos[lexicon->Pos(word_id)]; }
+
   void applyFiberRule(const FiberRule& rule);
 
   void applyAreaRule(const AreaRule& rule);
@@ -129,6 +138,8 @@ public:
   // void -> bool
   bool applyRule(const Rule& rule);
 
+  void prepareProjection(bool verbose = false);
+
   void parse_project();
 
   void remember_fibers(const ProjectMap& project_map); // ProjectMap
@@ -145,7 +156,21 @@ public:
 
   std::string getWord(const std::string& area_name, double min_overlap = 0.7);
 
+  virtual std::string getWord(const std::string& area_name,
+                              const std::vector<uint32_t>& activated,
+                              double min_overlap = 0.7);
+
   std::unordered_map<std::string, std::unordered_set<std::string>> getActivatedFibers();
+
+  std::vector<std::vector<std::string>> readoutDependencies(const std::string& root,
+                                                            const ProjectMap& mapping);
+
+protected:
+  // readout 时各脑区的临时激活神经元，不写回 Area::activated
+  typedef std::unordered_map<std::string, std::vector<uint32_t>> ReadoutState;
+
+  void readout(const std::string& area, const ProjectMap& mapping, ReadoutState& state,
+               std::vector<std::vector<std::string>>& dependencies);
 };
 
 
@@ -156,16 +181,77 @@ public:
   EnglishParserBrain(float p, int non_LEX_n = 10000, 
     int non_LEX_k = 100, int LEX_k = 20, double default_beta = 0.2, 
     double LEX_beta = 1.0, double recurrent_beta = 0.05, 
-    double interarea_beta = 0.5, bool verbose = false);
+    double interarea_beta = 0.5, bool verbose = false,
+    std::shared_ptr<const Lexicon> lexicon = nullptr, uint32_t seed = 42);
 
   ProjectMap getProjectMap();
 
   std::string getWord(const std::string& area_name, double min_overlap = 0.7);
+
+  std::string getWord(const std::string& area_name,
+                      const std::vector<uint32_t>& activated,
+                      double min_overlap = 0.7) override;
+};
+
+// 解析器的全部超参数，默认值与 parse() 的默认参数相同
+struct ParserOptions {
+  float p = 0.1;
+  int non_LEX_n = 10000;
+  int non_LEX_k = 100;
+  int LEX_k = 20;
+  double default_beta = 0.2;
+  double LEX_beta = 1.0;
+  double recurrent_beta = 0.05;
+  double interarea_beta = 0.5;
+  int project_rounds = 20;
+  uint32_t seed = 42;
+  int readout_method = 2;
+  bool verbose = false;
+};
+
+/*
+逐词解析：feed 处理一个单词（feed_id 直接使用 Lexicon 的 word id）（pre_rules、投影、post_rules），
+snapshot_dependencies 随时读出当前已有的依赖而不改变解析状态，
+finish 结束解析并返回最终的依赖集合。parse 即依次 feed 整个句子后 finish。
+*/
+class IncrementalParser {
+public:
+  IncrementalParser(float p = 0.1, int LEX_k = 20, int project_rounds = 20,
+                    bool verbose = false, int readout_method = 2,
+                    std::shared_ptr<const Lexicon> lexicon = nullptr);
+
+  explicit IncrementalParser(const ParserOptions& options,
+                             std::shared_ptr<const Lexicon> lexicon = nullptr);
+  // 从一个还没有解析过句子的 brain 复制而来，省去构造 brain 的开销；结果与使用相同参数构造的相同
+  IncrementalParser(const EnglishParserBrain& brain, int project_rounds = 20,
+                    bool verbose = false, int readout_method = 2);
+
+  void feed(std::string_view word);
+
+  void feed_id(uint32_t word_id);
+
+  std::set<std::vector<std::string>> snapshot_dependencies();
+
+  std::set<std::vector<std::string>> finish();
+
+  bool finished() const { return finished_; }
+
+  EnglishParserBrain& brain() { return b_; }
+
+private:
+  EnglishParserBrain b_;
+  int project_rounds_;
+  bool verbose_;
+  int readout_method_;
+  bool finished_ = false;
 };
 
 std::set<std::vector<std::string>> parse(std::string sentence="a man saw a woman", float p=0.1, int LEX_k=20, 
 	      int project_rounds=20, bool verbose=false, bool debug=false, int readout_method=2);
 
+std::set<std::vector<std::string>> parse(const std::string& sentence, const ParserOptions& options,
+                                         std::shared_ptr<const Lexicon> lexicon = nullptr);
+
 }  // namespace nemo
 
 #endif // NEMO_BRAIN_H_
\ No newline at end of file
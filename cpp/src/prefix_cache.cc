@@ -0,0 +1,133 @@
+#include "prefix_cache.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nemo {
+namespace {
+
+// 快照中突触以外的部分（脑区、激活的神经元、fiber_states 等）的估计大小
+constexpr size_t kStateOverhead = 32 << 10;
+// 每个快照的预算可以容纳的只有出现次数的节点数
+constexpr size_t kNodesPerSnapshot = 64;
+
+}  // namespace
+
+PrefixStateCache::PrefixStateCache(const ParserOptions& options, size_t max_bytes,
+                                   uint32_t max_prefix_words,
+                                   std::shared_ptr<const Lexicon> lexicon)
+    : max_prefix_words_(max_prefix_words), max_bytes_(max_bytes),
+      max_nodes_(std::max<size_t>(1024, max_bytes / kStateOverhead * kNodesPerSnapshot)),
+      lexicon_(lexicon ? lexicon : DefaultLexicon()) {
+  root_.state = std::make_unique<IncrementalParser>(options, lexicon_);
+}
+
+PrefixStateCache::~PrefixStateCache() = default;
+
+size_t PrefixStateCache::StateBytes(IncrementalParser& parser) {
+  return sizeof(IncrementalParser) + kStateOverhead + parser.brain().SynapseBytes();
+}
+
+std::set<std::vector<std::string>> PrefixStateCache::Parse(std::string_view sentence) {
+  std::vector<std::string_view> words;
+  Tokenize(sentence, words);
+  std::vector<uint32_t> word_ids;
+  for (std::string_view word : words) {
+    uint32_t id = lexicon_->Find(word);
+    if (id == Lexicon::kNotFound) throw std::runtime_error("Unknown word: " + std::string(word));
+    word_ids.push_back(id);
+  }
+
+  // 最长的有快照的前缀
+  Node* node = &root_;
+  Node* resume = &root_;
+  size_t resume_length = 0;
+  for (size_t i = 0; i < word_ids.size(); ++i) {
+    auto it = node->children.find(word_ids[i]);
+    if (it == node->children.end()) break;
+    node = it->second.get();
+    if (node->state) {
+      resume = node;
+      resume_length = i + 1;
+    }
+  }
+  if (resume != &root_) lru_.splice(lru_.begin(), lru_, resume->lru);
+  IncrementalParser parser(*resume->state);
+  ++stats_.sentences;
+  stats_.words_reused += resume_length;
+  stats_.words_simulated += word_ids.size() - resume_length;
+
+  node = resume;
+  bool store = true;
+  for (size_t i = resume_length; i < word_ids.size(); ++i) {
+    parser.feed_id(word_ids[i]);
+    // 整个句子的状态只有完全相同的句子才能使用，不保存
+    if (!store || i + 1 > max_prefix_words_ || i + 1 == word_ids.size()) continue;
+    std::unique_ptr<Node>& child = node->children[word_ids[i]];
+    if (!child) {
+      child = std::make_unique<Node>();
+      child->parent = node;
+      child->word_id = word_ids[i];
+      ++num_nodes_;
+    }
+    node = child.get();
+    // 第二次出现的前缀才保存快照，只出现一次的前缀不值得复制整个 brain
+    if (!node->state && ++node->visits >= 2) {
+      // 一个快照就超出了预算时，它和路径上的节点已经被删除
+      store = Store(node, parser);
+    }
+  }
+  // 只记录了出现次数的节点太多时，删除其中不通向快照的节点
+  if (num_nodes_ > max_nodes_) Prune(&root_);
+  return parser.finish();
+}
+
+bool PrefixStateCache::Store(Node* node, const IncrementalParser& parser) {
+  node->state = std::make_unique<IncrementalParser>(parser);
+  node->bytes = StateBytes(*node->state);
+  lru_.push_front(node);
+  node->lru = lru_.begin();
+  stats_.bytes += node->bytes;
+  ++stats_.entries;
+  ++stats_.snapshots;
+  // 刚保存的快照是最近使用的，只有它一个也超出预算时才被淘汰
+  const bool kept = node->bytes <= max_bytes_;
+  while (stats_.bytes > max_bytes_ && !lru_.empty()) {
+    ++stats_.evictions;
+    Evict(lru_.back());
+  }
+  return kept;
+}
+
+void PrefixStateCache::Evict(Node* node) {
+  lru_.erase(node->lru);
+  node->state.reset();
+  stats_.bytes -= node->bytes;
+  node->bytes = 0;
+  --stats_.entries;
+  // 删除不再通向任何快照的节点
+  while (node != &root_ && !node->state && node->children.empty()) {
+    Node* parent = node->parent;
+    parent->children.erase(node->word_id);
+    --num_nodes_;
+    node = parent;
+  }
+}
+
+void PrefixStateCache::Prune(Node* node) {
+  for (auto it = node->children.begin(); it != node->children.end();) {
+    Prune(it->second.get());
+    if (!it->second->state && it->second->children.empty()) {
+      it = node->children.erase(it);
+      --num_nodes_;
+    } else {
+      ++it;
+    }
+  }
+}
+
+void PrefixStateCache::Clear() {
+  while (!lru_.empty()) Evict(lru_.back());
+}
+
+}  // namespace nemo
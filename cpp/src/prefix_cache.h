@@ -0,0 +1,83 @@
+#ifndef NEMO_PREFIX_CACHE_H_
+#define NEMO_PREFIX_CACHE_H_
+
+#include "parser.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 前缀状态缓存：parse() 处理完句子的前几个单词后的解析状态（brain 的
+ * 激活、突触权重、support，以及 fiber_states、area_states、activated_fibers）
+ * 只由这几个单词决定，因此以 word id 前缀为键保存在 trie 中。新句子从最长的
+ * 已缓存前缀复制状态，只模拟剩下的单词，结果与 parse() 相同。
+ *
+ * 只保存长度不超过 max_prefix_words、并且至少出现过两次的前缀（共享的前缀通常
+ * 很短，复制 brain 的代价与模拟一两个单词相当），总内存不超过
+ * max_bytes，超出时按 LRU 淘汰快照；空状态（trie 的根）始终保留，相当于
+ * parse_server 中的 brain 模板。一个缓存对应一组 ParserOptions，不是线程安全的，
+ * 每个线程使用自己的缓存。
+ */
+class PrefixStateCache {
+ public:
+  struct Stats {
+    uint64_t sentences = 0;
+    uint64_t words_reused = 0;     // 从快照恢复、不需要模拟的单词数
+    uint64_t words_simulated = 0;
+    uint64_t snapshots = 0;        // 保存过的快照数
+    uint64_t evictions = 0;
+    size_t entries = 0;            // 当前的快照数（不含根）
+    size_t bytes = 0;
+  };
+
+  PrefixStateCache(const ParserOptions& options, size_t max_bytes,
+                   uint32_t max_prefix_words = 6,
+                   std::shared_ptr<const Lexicon> lexicon = nullptr);
+  ~PrefixStateCache();
+
+  // 与 parse(sentence, options, lexicon) 相同，未知单词抛出 std::runtime_error
+  std::set<std::vector<std::string>> Parse(std::string_view sentence);
+
+  const Stats& stats() const { return stats_; }
+  void Clear();
+
+ private:
+  struct Node {
+    Node* parent = nullptr;
+    uint32_t word_id = 0;
+    uint32_t visits = 0;                       // 经过这个前缀但它没有快照的次数
+    std::unordered_map<uint32_t, std::unique_ptr<Node>> children;
+    std::unique_ptr<IncrementalParser> state;  // 处理完这个前缀后的解析器
+    size_t bytes = 0;
+    std::list<Node*>::iterator lru;            // 在 lru_ 中的位置（有 state 且不是根时有效）
+  };
+
+  static size_t StateBytes(IncrementalParser& parser);
+  // 保存快照并按预算淘汰，返回 node 是否还在 trie 中
+  bool Store(Node* node, const IncrementalParser& parser);
+  void Evict(Node* node);
+  void Prune(Node* node);
+
+  const uint32_t max_prefix_words_;
+  const size_t max_bytes_;
+  const size_t max_nodes_;
+  size_t num_nodes_ = 0;
+  std::shared_ptr<const Lexicon> lexicon_;
+  Node root_;
+  std::list<Node*> lru_;  // 最近使用的在前面
+  Stats stats_;
+};
+
+}  // namespace nemo
+
+#endif  // NEMO_PREFIX_CACHE_H_
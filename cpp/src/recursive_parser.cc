@@ -0,0 +1,292 @@
+#include "recursive_parser.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+namespace nemo {
+
+namespace {
+
+// 每一层都有一组自己的子句级脑区
+const std::vector<std::string> FRAME_AREAS = {SUBJ, OBJ, VERB};
+// 所有层共用的脑区
+const std::vector<std::string> SHARED_AREAS = {LEX, DET, ADJ, PREP, PREP_P, ADVERB};
+
+const std::string& Rename(const std::string& area,
+                          const std::unordered_map<std::string, std::string>& names) {
+  auto it = names.find(area);
+  return it == names.end() ? area : it->second;
+}
+
+Rule RenameRule(const Rule& rule, const std::unordered_map<std::string, std::string>& names) {
+  if (const auto* area_rule = std::get_if<AreaRule>(&rule)) {
+    return AreaRule(area_rule->action, Rename(area_rule->area, names), area_rule->index);
+  }
+  const auto& fiber_rule = std::get<FiberRule>(rule);
+  return FiberRule(fiber_rule.action, Rename(fiber_rule.area1, names),
+                   Rename(fiber_rule.area2, names), fiber_rule.index);
+}
+
+}  // namespace
+
+
+void TokenizeClauses(std::string_view sentence, std::vector<std::string>& tokens) {
+  tokens.clear();
+  std::vector<std::string_view> words;
+  for (size_t start = 0;;) {
+    const size_t comma = sentence.find(',', start);
+    Tokenize(sentence.substr(start, comma == std::string_view::npos ? comma : comma - start), words);
+    tokens.insert(tokens.end(), words.begin(), words.end());
+    if (comma == std::string_view::npos) break;
+    tokens.push_back(CLAUSE_END);
+    start = comma + 1;
+  }
+}
+
+
+RecursiveParserBrain::RecursiveParserBrain(const ParserOptions& options, uint32_t max_depth,
+                                           std::shared_ptr<const Lexicon> lexicon)
+    : EnglishParserBrain(options.p, options.non_LEX_n, options.non_LEX_k, options.LEX_k,
+                         options.default_beta, options.LEX_beta, options.recurrent_beta,
+                         options.interarea_beta, options.verbose, lexicon, options.seed),
+      max_depth_(std::max(1u, max_depth)), options_(options),
+      frame_areas_(max_depth_) {
+    for (const auto& area : all_areas) generic_areas_[area] = area;
+    for (const auto& area : FRAME_AREAS) frame_areas_[0][area] = area;
+
+    auto connect = [this](const std::string& from, const std::string& to) {
+        AddFiber(from, to);
+        SetFiberBeta(from, to, fiberBeta(from, to));
+    };
+    for (uint32_t depth = 1; depth < max_depth_; ++depth) {
+        auto& names = frame_areas_[depth];
+        const std::string suffix = "_" + std::to_string(depth);
+        for (const auto& area : FRAME_AREAS) names[area] = area + suffix;
+        names[DEP_CLAUSE] = DEP_CLAUSE + suffix;
+        for (const auto& [area, name] : names) {
+            AddArea(name, options.non_LEX_n, options.non_LEX_k, /*recurrent=*/false);
+            generic_areas_[name] = area;
+            all_areas.push_back(name);
+            recurrent_areas.push_back(name);
+        }
+
+        // 本层的 SUBJ、OBJ、VERB 之间，以及与共用脑区之间全连接，与 EnglishParserBrain 相同
+        for (const auto& area : FRAME_AREAS) {
+            const std::string& name = names[area];
+            for (const auto& shared : SHARED_AREAS) {
+                connect(name, shared);
+                connect(shared, name);
+            }
+            for (const auto& other : FRAME_AREAS) connect(name, names[other]);
+        }
+        // 上一层的名词 -> DEP_CLAUSE <-> 本层的动词
+        const std::string& dep = names[DEP_CLAUSE];
+        connect(dep, dep);
+        connect(frame_areas_[depth - 1][SUBJ], dep);
+        connect(frame_areas_[depth - 1][OBJ], dep);
+        connect(dep, names[VERB]);
+        connect(names[VERB], dep);
+
+        readout_rules[names[VERB]] = {LEX, names[SUBJ], names[OBJ], PREP_P, ADVERB, ADJ};
+        readout_rules[names[SUBJ]] = {LEX, DET, ADJ, PREP_P};
+        readout_rules[names[OBJ]] = {LEX, DET, ADJ, PREP_P};
+    }
+
+    rules_by_depth_.resize(max_depth_);
+    for (uint32_t depth = 0; depth < max_depth_; ++depth) {
+        for (const RuleSet& rule_set : rules_by_pos) {
+            RuleSet renamed{rule_set.index, {}, {}};
+            for (const Rule& rule : rule_set.pre_rules)
+                renamed.pre_rules.push_back(RenameRule(rule, frame_areas_[depth]));
+            for (const Rule& rule : rule_set.post_rules)
+                renamed.post_rules.push_back(RenameRule(rule, frame_areas_[depth]));
+            rules_by_depth_[depth].push_back(std::move(renamed));
+        }
+    }
+    resetStates(0);
+}
+
+
+// 与 EnglishParserBrain 的 custom_plasticities 相同，DEP_CLAUSE 也按 recurrent 脑区处理
+float RecursiveParserBrain::fiberBeta(const std::string& from, const std::string& to) const {
+    auto is_recurrent = [this](const std::string& area) {
+        return std::find(recurrent_areas.begin(), recurrent_areas.end(), area) != recurrent_areas.end();
+    };
+    if ((from == LEX && is_recurrent(to)) || (to == LEX && is_recurrent(from)))
+        return options_.LEX_beta;
+    if (!is_recurrent(from) || !is_recurrent(to)) return options_.default_beta;
+    return from == to ? options_.recurrent_beta : options_.interarea_beta;
+}
+
+
+const std::string& RecursiveParserBrain::frameArea(const std::string& area, uint32_t depth) const {
+    return Rename(area, frame_areas_.at(depth));
+}
+
+
+const std::string& RecursiveParserBrain::genericArea(const std::string& name) const {
+    return Rename(name, generic_areas_);
+}
+
+
+void RecursiveParserBrain::resetStates(uint32_t depth) {
+    area_states.clear();
+    initialize_states();
+    if (depth == 0) return;
+    for (const auto& area : initial_areas) area_states[area].insert(0);
+    area_states[LEX].erase(0);
+    area_states[frameArea(SUBJ, depth)].erase(0);
+    area_states[frameArea(VERB, depth)].erase(0);
+    area_states[frameArea(DEP_CLAUSE, depth)].erase(0);
+}
+
+
+RecursiveParser::RecursiveParser(const ParserOptions& options, uint32_t max_depth,
+                                 std::shared_ptr<const Lexicon> lexicon)
+    : b_(options, max_depth, lexicon),
+      project_rounds_(options.project_rounds), verbose_(options.verbose) {}
+
+
+void RecursiveParser::feed(std::string_view token) {
+    if (finished_)
+        throw std::runtime_error("Cannot feed word after finish: " + std::string(token));
+    if (token == CLAUSE_START) {
+        openClause();
+        return;
+    }
+    if (token == CLAUSE_END) {
+        closeClause();
+        return;
+    }
+    uint32_t word_id = b_.lexicon->Find(token);
+    if (word_id == Lexicon::kNotFound)
+        throw std::runtime_error("Unknown word: " + std::string(token));
+    feedWord(word_id);
+}
+
+
+// 与 IncrementalParser::feed_id 相同，使用当前层的规则；从句中的动词还从 DEP_CLAUSE 接收输入，
+// 把它的 assembly 与中心名词的链接 assembly 关联起来
+void RecursiveParser::feedWord(uint32_t word_id) {
+    const uint32_t depth = this->depth();
+    const RuleSet& lexeme = b_.lexeme(word_id, depth);
+    b_.activateIndex(LEX, word_id);
+    if (verbose_) std::cout << "Activated word: " << b_.lexicon->Word(word_id) << " (depth " << depth << ")" << std::endl;
+
+    for (const Rule& rule : lexeme.pre_rules) b_.applyRule(rule);
+    const std::string& verb = b_.frameArea(VERB, depth);
+    const bool link_verb = depth > 0 && b_.fiber_states[LEX][verb].empty();
+    if (link_verb) b_.applyFiberRule(FiberRule(DISINHIBIT, verb, b_.frameArea(DEP_CLAUSE, depth), 0));
+
+    b_.prepareProjection(verbose_);
+    for (int i = 0; i < project_rounds_; i++) b_.parse_project();
+
+    for (const Rule& rule : lexeme.post_rules) b_.applyRule(rule);
+    if (link_verb) b_.applyFiberRule(FiberRule(INHIBIT, verb, b_.frameArea(DEP_CLAUSE, depth), 0));
+}
+
+
+void RecursiveParser::openClause() {
+    const uint32_t depth = this->depth();
+    if (depth + 1 >= b_.max_depth())
+        throw std::runtime_error("Clause nesting deeper than " + std::to_string(b_.max_depth() - 1));
+    const std::string& subj = b_.frameArea(SUBJ, depth);
+    OpenClause clause;
+    // 主语还没有出现时从句修饰主语，否则修饰宾语
+    clause.head_area = b_.area_states[subj].empty() ? subj : b_.frameArea(OBJ, depth);
+    if (b_.GetArea(clause.head_area).activated.empty())
+        throw std::runtime_error("Clause does not follow a noun");
+    clause.fiber_states = b_.fiber_states;
+    clause.area_states = b_.area_states;
+
+    // 清除这组脑区上一次使用时留下的 assembly 和 readout 记录
+    const uint32_t inner = depth + 1;
+    for (const std::string& area : {SUBJ, OBJ, VERB, DEP_CLAUSE}) {
+        const std::string& name = b_.frameArea(area, inner);
+        Area& frame_area = b_.GetArea(name);
+        frame_area.activated.clear();
+        frame_area.fixed_assembly = false;
+        b_.activated_fibers.erase(name);
+        for (auto& [from, to_areas] : b_.activated_fibers) to_areas.erase(name);
+    }
+    const std::string& dep = b_.frameArea(DEP_CLAUSE, inner);
+    b_.Project({{clause.head_area, {dep}}, {dep, {dep}}}, project_rounds_);
+    b_.GetArea(dep).fixed_assembly = true;
+
+    b_.resetStates(inner);
+    clauses_.push_back(std::move(clause));
+}
+
+
+void RecursiveParser::closeClause() {
+    if (clauses_.empty()) throw std::runtime_error("Clause end without an open clause");
+    OpenClause& clause = clauses_.back();
+    readoutClause(clause, depth());
+    b_.fiber_states = std::move(clause.fiber_states);
+    b_.area_states = std::move(clause.area_states);
+    clauses_.pop_back();
+}
+
+
+void RecursiveParser::readoutClause(const OpenClause& clause, uint32_t depth) {
+    const std::string& verb = b_.frameArea(VERB, depth);
+    const std::vector<uint32_t>& verb_activated = b_.GetArea(verb).activated;
+    if (verb_activated.empty()) return;
+    const std::string& subj = b_.frameArea(SUBJ, depth);
+    const std::string& obj = b_.frameArea(OBJ, depth);
+    auto mapping = b_.getActivatedFibers();
+
+    // 从句中缺少的成分由中心名词填充：没有主语时是主语，及物动词没有宾语时是宾语
+    const auto& lex_targets = b_.activated_fibers[LEX];
+    std::string gap;
+    if (!lex_targets.count(subj)) gap = SUBJ;
+    else if (b_.area_states[obj].empty() && !lex_targets.count(obj)) gap = OBJ;
+    if (!gap.empty()) mapping[verb].erase(b_.frameArea(gap, depth));
+
+    for (auto dependency : b_.readoutDependencies(verb, mapping)) {
+        dependency[2] = b_.genericArea(dependency[2]);
+        dependencies_.insert(std::move(dependency));
+    }
+
+    // 中心名词 -> DEP_CLAUSE -> 从句动词
+    std::vector<uint32_t> winners;
+    const std::vector<uint32_t>& head = b_.GetArea(clause.head_area).activated;
+    b_.ReadoutTopK(clause.head_area, head, LEX, winners);
+    const std::string head_word = b_.getWord(LEX, winners);
+    b_.ReadoutTopK(verb, verb_activated, LEX, winners);
+    const std::string verb_word = b_.getWord(LEX, winners);
+
+    const std::string& dep = b_.frameArea(DEP_CLAUSE, depth);
+    std::vector<uint32_t> dep_winners, linked_verb;
+    b_.ReadoutTopK(clause.head_area, head, dep, dep_winners);
+    b_.ReadoutTopK(dep, dep_winners, verb, linked_verb);
+    b_.ReadoutTopK(verb, linked_verb, LEX, winners);
+    dependencies_.insert({head_word, b_.getWord(LEX, winners), "DEP-VERB"});
+    if (!gap.empty()) dependencies_.insert({verb_word, head_word, gap});
+}
+
+
+std::set<std::vector<std::string>> RecursiveParser::finish() {
+    while (!clauses_.empty()) closeClause();
+    for (const auto& area : b_.all_areas) b_.GetArea(area).fixed_assembly = false;
+    finished_ = true;
+    std::set<std::vector<std::string>> dependency_set = dependencies_;
+    auto dependencies = b_.readoutDependencies(VERB, b_.getActivatedFibers());
+    dependency_set.insert(dependencies.begin(), dependencies.end());
+    return dependency_set;
+}
+
+
+std::set<std::vector<std::string>> parse_recursive(const std::string& sentence,
+                                                   const ParserOptions& options,
+                                                   uint32_t max_depth,
+                                                   std::shared_ptr<const Lexicon> lexicon) {
+    RecursiveParser parser(options, max_depth, lexicon);
+    std::vector<std::string> tokens;
+    TokenizeClauses(sentence, tokens);
+    for (const std::string& token : tokens) parser.feed(token);
+    return parser.finish();
+}
+
+}  // namespace nemo
@@ -0,0 +1,121 @@
+#ifndef NEMO_RECURSIVE_PARSER_H_
+#define NEMO_RECURSIVE_PARSER_H_
+
+#include "parser.h"
+
+#include <stdint.h>
+
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace nemo {
+
+// 从句与其中心名词之间的链接脑区，对应 recursive_parser.py 的 DEP_CLAUSE
+const std::string DEP_CLAUSE = "DEP_CLAUSE";
+// 从句的开始和结束标记（recursive_parser.py 中的 "that" 和 ","）
+const std::string CLAUSE_START = "that";
+const std::string CLAUSE_END = ",";
+// 分词：与 Tokenize 相同，但 ',' 作为单独的 CLAUSE_END 标记保留
+void TokenizeClauses(std::string_view sentence, std::vector<std::string>& tokens);
+
+/*
+支持嵌套从句的解析脑。每一层从句使用一组自己的子句级脑区（clause frame）：
+第 0 层是主句，使用 EnglishParserBrain 原有的 SUBJ、OBJ、VERB；第 d 层使用
+SUBJ_d、OBJ_d、VERB_d，以及把上一层的名词连接到本层动词的 DEP_CLAUSE_d。
+DET、ADJ、PREP、PREP_P、ADVERB 和 LEX 在所有层之间共用，与单句解析器中
+主语和宾语共用这些脑区相同。
+
+脑区组的数量 max_depth 在构造时确定：从句结束时立即读出它的依赖，之后这组
+脑区可以被下一个同层的从句重用，因此脑区和 fiber 的数量与句子长度无关，
+每个脑区的神经元数量也不超过 n。
+*/
+class RecursiveParserBrain : public EnglishParserBrain {
+public:
+  RecursiveParserBrain(const ParserOptions& options, uint32_t max_depth,
+                       std::shared_ptr<const Lexicon> lexicon = nullptr);
+
+  uint32_t max_depth() const { return max_depth_; }
+
+  // 第 depth 层中与通用名称 area（SUBJ、OBJ、VERB、DEP_CLAUSE）对应的脑区，
+  // 共用脑区返回 area 本身
+  const std::string& frameArea(const std::string& area, uint32_t depth) const;
+
+  // 脑区的通用名称，例如 SUBJ_1 -> SUBJ，用作依赖的标签
+  const std::string& genericArea(const std::string& name) const;
+
+  // 第 depth 层使用的单词规则：规则中的子句级脑区换成该层的脑区
+  const RuleSet& lexeme(uint32_t word_id, uint32_t depth) const {
+    return rules_by_depth_[depth][lexicon->Pos(word_id)];
+  }
+
+  // 只保留第 depth 层的初始脑区（LEX、SUBJ_d、VERB_d 和 DEP_CLAUSE_d）
+  void resetStates(uint32_t depth);
+
+private:
+  float fiberBeta(const std::string& from, const std::string& to) const;
+
+  const uint32_t max_depth_;
+  const ParserOptions options_;
+  std::vector<std::unordered_map<std::string, std::string>> frame_areas_;  // 每层：通用名称 -> 脑区
+  std::unordered_map<std::string, std::string> generic_areas_;            // 脑区 -> 通用名称
+  std::vector<std::vector<RuleSet>> rules_by_depth_;                       // [层][词性]
+};
+
+/*
+逐词的递归解析：feed 依次接收单词、CLAUSE_START 和 CLAUSE_END。遇到 CLAUSE_START
+时，当前层正在处理的名词（SUBJ 或 OBJ）投影到下一层的 DEP_CLAUSE 形成链接
+assembly，解析状态保存后切换到下一层；遇到 CLAUSE_END 时读出该从句的依赖并
+恢复上一层的解析状态。外层的脑区在从句期间不被改写，不需要重新处理外层的单词。
+
+从句缺少主语（或及物动词缺少宾语）时，把中心名词作为缺失的成分，例如
+"the cat that chased the mouse , ran" 得到 {chased, cat, SUBJ}。中心名词和从句
+动词之间的依赖标记为 DEP-VERB。
+*/
+class RecursiveParser {
+public:
+  explicit RecursiveParser(const ParserOptions& options = ParserOptions(),
+                           uint32_t max_depth = 3,
+                           std::shared_ptr<const Lexicon> lexicon = nullptr);
+
+  void feed(std::string_view token);
+
+  std::set<std::vector<std::string>> finish();
+
+  // 当前的从句嵌套深度，主句为 0
+  uint32_t depth() const { return clauses_.size(); }
+
+  RecursiveParserBrain& brain() { return b_; }
+
+private:
+  // 一个未结束的从句：中心名词所在的脑区和进入从句前的解析状态
+  struct OpenClause {
+    std::string head_area;
+    std::unordered_map<std::string, std::unordered_map<std::string, std::unordered_set<int>>> fiber_states;
+    std::unordered_map<std::string, std::unordered_set<int>> area_states;
+  };
+
+  void feedWord(uint32_t word_id);
+  void openClause();
+  void closeClause();
+  void readoutClause(const OpenClause& clause, uint32_t depth);
+
+  RecursiveParserBrain b_;
+  int project_rounds_;
+  bool verbose_;
+  bool finished_ = false;
+  std::vector<OpenClause> clauses_;
+  std::set<std::vector<std::string>> dependencies_;  // 已经结束的从句的依赖
+};
+
+std::set<std::vector<std::string>> parse_recursive(const std::string& sentence,
+                                                   const ParserOptions& options = ParserOptions(),
+                                                   uint32_t max_depth = 3,
+                                                   std::shared_ptr<const Lexicon> lexicon = nullptr);
+
+}  // namespace nemo
+
+#endif // NEMO_RECURSIVE_PARSER_H_
@@ -0,0 +1,80 @@
+#ifndef NEMO_SAMPLING_H_
+#define NEMO_SAMPLING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief Floyd 算法：从 [0, n) 中不放回地抽取 m 个不同的整数。
+ * 每个样本只消耗一个随机数，用开放寻址的哈希表判重，期望代价 O(m)，与 n 无关。
+ *
+ * @tparam Trng: 随机数生成器
+ * @param n: 总体大小
+ * @param m: 样本数量，m <= n
+ * @param rng: 随机数生成器
+ * @param out: 输出，无序的样本（会先被清空）
+ */
+template<typename Trng>
+void FloydSample(uint32_t n, uint32_t m, Trng& rng, std::vector<uint32_t>& out) {
+  out.clear();
+  if (m == 0) return;
+  uint32_t bits = 1;
+  while ((size_t(1) << bits) < 4 * size_t(m)) ++bits;
+  const size_t mask = (size_t(1) << bits) - 1;
+  std::vector<uint32_t> table(mask + 1, UINT32_MAX);
+  // 插入 x，x 已存在时返回 false
+  auto insert = [&](uint32_t x) {
+    size_t h = (x * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+    while (table[h] != UINT32_MAX) {
+      if (table[h] == x) return false;
+      h = (h + 1) & mask;
+    }
+    table[h] = x;
+    return true;
+  };
+  out.reserve(m);
+  for (uint32_t j = n - m; j < n; ++j) {
+    const uint32_t t = std::uniform_int_distribution<uint32_t>(0, j)(rng);
+    const uint32_t x = insert(t) ? t : j;
+    if (x == j) insert(j);
+    out.push_back(x);
+  }
+}
+
+/**
+ * @brief 从 [0, n) 中不放回地均匀抽取 m 个不同的整数，结果的顺序不确定。
+ * m <= n / 2 时直接用 Floyd 算法；否则用 Floyd 算法抽取不被选中的 n - m 个，
+ * 再输出其余的整数，此时 n < 2m，代价仍与 m 成正比。
+ *
+ * @tparam Trng: 随机数生成器
+ * @param n: 总体大小
+ * @param m: 样本数量，m <= n
+ * @param rng: 随机数生成器
+ * @param out: 输出，样本（会先被清空）
+ */
+template<typename Trng>
+void SampleWithoutReplacement(uint32_t n, uint32_t m, Trng& rng,
+                              std::vector<uint32_t>& out) {
+  if (2 * uint64_t(m) <= n) {
+    FloydSample(n, m, rng, out);
+    return;
+  }
+  FloydSample(n, n - m, rng, out);
+  std::vector<uint8_t> rejected(n);
+  for (uint32_t x : out) rejected[x] = 1;
+  out.clear();
+  out.reserve(m);
+  for (uint32_t x = 0; x < n; ++x) {
+    if (!rejected[x]) out.push_back(x);
+  }
+}
+
+}  // namespace nemo
+
+#endif  // NEMO_SAMPLING_H_
@@ -0,0 +1,81 @@
+#ifndef NEMO_TOOL_UTIL_H_
+#define NEMO_TOOL_UTIL_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nemo {
+
+/**
+ * @brief 用 threads 个线程对 [0, count) 中的每个下标调用 fn(i)，下标按顺序动态分配。
+ * fn 抛出异常时不再开始新的下标，所有线程结束后在调用者的线程重新抛出第一个异常，
+ * 不会因为工作线程中未捕获的异常终止进程。
+ *
+ * @param count: 下标数
+ * @param threads: 线程数，不超过 count；不超过 1 时在调用者的线程中执行
+ * @param fn: 对每个下标调用的函数，不同线程可能同时调用
+ */
+template <typename Fn>
+void ParallelFor(size_t count, unsigned threads, const Fn& fn) {
+  threads = std::min<size_t>(threads, count);
+  if (threads <= 1) {
+    for (size_t i = 0; i < count; ++i) fn(i);
+    return;
+  }
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  std::vector<std::thread> pool;
+  for (unsigned t = 0; t < threads; ++t) {
+    pool.emplace_back([&] {
+      for (size_t i; (i = next++) < count;) {
+        try {
+          fn(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error) error = std::current_exception();
+          next = count;
+        }
+      }
+    });
+  }
+  for (auto& thread : pool) thread.join();
+  if (error) std::rethrow_exception(error);
+}
+
+/**
+ * @brief 解析 argv[first] 起的 --key=value 形式的命令行参数，依次调用 handle(key, value)。
+ * 参数格式错误或 handle 返回 false（未知的参数）时打印该参数并返回 false，
+ * 调用者随后打印用法。
+ *
+ * @param argc: 参数个数
+ * @param argv: 参数
+ * @param first: 第一个选项的下标
+ * @param handle: bool(const std::string& key, const std::string& value)
+ * @return bool: 所有参数是否都被接受
+ */
+template <typename Handle>
+bool ParseOptions(int argc, char** argv, int first, const Handle& handle) {
+  for (int i = first; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    if (arg.rfind("--", 0) != 0 || eq == std::string::npos ||
+        !handle(arg.substr(2, eq - 2), arg.substr(eq + 1))) {
+      fprintf(stderr, "Unknown option %s\n", arg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace nemo
+
+#endif  // NEMO_TOOL_UTIL_H_
@@ -1,12 +1,23 @@
+#include "../src/batch_parser.h"
+#include "../src/learner.h"
+#include "../src/parse_cache.h"
 #include "../src/parser.h"
+#include "../src/prefix_cache.h"
+#include "../src/recursive_parser.h"
+#include "../src/sampling.h"
+#include "../server/protocol.h"
 #include "dependency.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <utility>
+#include <sstream>
 
 #include <gtest/gtest.h>
 
@@ -84,4 +95,807 @@ INSTANTIATE_TEST_SUITE_P(
     ::testing::ValuesIn(sentences)
 );
 
+class IncrementalTest: public ::testing::TestWithParam<SentenceArgs> {
+};
+
+// 每个单词后都做一次 snapshot，最终结果应与 parse 一致
+TEST_P(IncrementalTest, SnapshotDoesNotChangeResult) {
+    auto args = GetParam();
+    int index = args.get_index();
+    std::istringstream words(args.get_sentence());
+    IncrementalParser parser;
+    std::string word;
+    while (words >> word) {
+        parser.feed(word);
+        auto partial = parser.snapshot_dependencies();
+        for (const auto& dependency : partial) {
+            EXPECT_EQ(dependency.size(), 3u);
+        }
+    }
+    EXPECT_TRUE(CompareDependency(parser.finish(), expected_dependency[index]));
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    ParserTest,
+    IncrementalTest,
+    ::testing::ValuesIn(sentences)
+);
+
+TEST(LexiconTest, TokenizeSkipsPunctuationAndWhitespaceRuns) {
+    std::vector<std::string_view> tokens;
+    Tokenize("  the cat's  toy,   is red.", tokens);
+    std::vector<std::string_view> expected = {"the", "cat's", "toy", "is", "red"};
+    EXPECT_EQ(tokens, expected);
+    Tokenize(" . ", tokens);
+    EXPECT_TRUE(tokens.empty());
+}
+
+TEST(LexiconTest, FindsEveryWordById) {
+    std::vector<std::string> words;
+    for (int i = 0; i < 5000; ++i) words.push_back("w" + std::to_string(i));
+    words[17] = "";
+    Lexicon lexicon(words);
+    for (uint32_t id = 0; id < words.size(); ++id) {
+        if (words[id].empty()) continue;
+        EXPECT_EQ(lexicon.Find(words[id]), id);
+        EXPECT_EQ(lexicon.Word(id), words[id]);
+    }
+    EXPECT_EQ(lexicon.Find("w17"), Lexicon::kNotFound);
+    EXPECT_EQ(lexicon.Find("missing"), Lexicon::kNotFound);
+}
+
+TEST(LexiconTest, WordListsMatchDefaultLexicon) {
+    Lexicon loaded = Lexicon::FromWordLists(NEMO_WORDS_DIR);
+    auto builtin = DefaultLexicon();
+    ASSERT_EQ(loaded.size(), builtin->size());
+    for (uint32_t id = 0; id < loaded.size(); ++id) {
+        EXPECT_EQ(loaded.Word(id), builtin->Word(id));
+        EXPECT_EQ(loaded.pos_names()[loaded.Pos(id)],
+                  builtin->pos_names()[builtin->Pos(id)]);
+    }
+    std::string path = testing::TempDir() + "nemo_lexicon.bin";
+    loaded.SaveBinary(path);
+    Lexicon binary = Lexicon::Load(path);
+    ASSERT_EQ(binary.size(), loaded.size());
+    for (uint32_t id = 0; id < loaded.size(); ++id) {
+        EXPECT_EQ(binary.Find(loaded.Word(id)), id);
+        EXPECT_EQ(binary.Pos(id), loaded.Pos(id));
+    }
+    EXPECT_EQ(binary.pos_names(), loaded.pos_names());
+
+    // 损坏的下标：越界的槽位、递减的 offsets、不存在的词性、越界的 word id
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto u32_at = [&](size_t pos) {
+        uint32_t v;
+        memcpy(&v, &bytes[pos], sizeof(v));
+        return v;
+    };
+    const size_t offsets_at = 8 + 4 + u32_at(8);
+    const size_t pos_at = offsets_at + 4 + 4 * size_t(u32_at(offsets_at));
+    const size_t displacement_at = pos_at + 4 + u32_at(pos_at);
+    const uint32_t num_slots = u32_at(displacement_at);
+    size_t negative = 0;
+    for (uint32_t i = 0; i < num_slots && negative == 0; ++i) {
+        if (int32_t(u32_at(displacement_at + 4 + 4 * i)) < 0) negative = displacement_at + 4 + 4 * i;
+    }
+    ASSERT_GT(negative, 0u);
+    auto expect_inconsistent = [&](size_t at, uint32_t value, size_t size) {
+        std::string corrupt = bytes;
+        memcpy(&corrupt[at], &value, size);
+        std::ofstream(path, std::ios::binary) << corrupt;
+        EXPECT_THROW(Lexicon::FromBinary(path), std::runtime_error);
+    };
+    expect_inconsistent(negative, uint32_t(-int32_t(num_slots) - 1), 4);
+    expect_inconsistent(offsets_at + 4 + 4, u32_at(8), 4);
+    expect_inconsistent(pos_at + 4, 200, 1);
+    const size_t slot_id_at = displacement_at + 4 + 4 * size_t(num_slots);
+    ASSERT_EQ(u32_at(slot_id_at), num_slots);
+    expect_inconsistent(slot_id_at + 4, u32_at(offsets_at) - 1, 4);
+
+    // 在多个文件中出现的单词只保留第一次出现，与 lexemedict.py 相同
+    const std::string dir = testing::TempDir() + "nemo_word_lists";
+    mkdir(dir.c_str(), 0755);
+    std::ofstream(dir + "/a.txt") << "x\ny\n";
+    std::ofstream(dir + "/b.txt") << "y\n z \n";
+    Lexicon dedup = Lexicon::FromWordLists(dir);
+    ASSERT_EQ(dedup.size(), 3u);
+    EXPECT_EQ(dedup.Find("x"), 0u);
+    EXPECT_EQ(dedup.Find("y"), 1u);
+    EXPECT_EQ(dedup.Find("z"), 2u);
+    EXPECT_EQ(dedup.pos_names()[dedup.Pos(1)], "a");
+    EXPECT_EQ(dedup.pos_names()[dedup.Pos(2)], "b");
+}
+
+// LEX 只为出现过的单词（以及构造时激活的 0 号单词）生成 assembly
+TEST(LazyLexTest, OnlySeenWordsAreMaterialized) {
+    IncrementalParser parser;
+    parser.feed("the");
+    parser.feed("cat");
+    parser.feed("is");
+    parser.feed("happy");
+    parser.feed("happy");
+    EnglishParserBrain& b = parser.brain();
+    const Area& lex = b.GetArea(LEX);
+    EXPECT_EQ(lex.support, 4 * lex.k);
+    EXPECT_EQ(b.getWord(LEX), "happy");
+    size_t index, overlap;
+    b.ReadAssembly(LEX, index, overlap);
+    EXPECT_EQ(index, b.lexicon->Find("happy"));
+    EXPECT_EQ(overlap, lex.k);
+}
+
+// UpdatePlasticity 依赖每一行按目标神经元有序
+TEST(PlasticityTest, SynapseRowsStaySorted) {
+    IncrementalParser parser;
+    DenseFiberOptions sparse_only;
+    sparse_only.enter_density = 2.0f;
+    parser.brain().SetDenseFiberOptions(sparse_only);
+    for (const char* word : {"the", "dog", "happily", "runs", "around", "the", "big", "yard"}) {
+        parser.feed(word);
+    }
+    EnglishParserBrain& b = parser.brain();
+    for (const auto& from : AREAS) {
+        for (const auto& to : AREAS) {
+            const Fiber& fiber = b.GetFiber(from, to);
+            EXPECT_FALSE(fiber.dense) << from << " -> " << to;
+            for (const auto& row : fiber.outgoing_synapses) {
+                EXPECT_TRUE(std::is_sorted(row.begin(), row.end(),
+                    [](const Synapse& a, const Synapse& c) { return a.neuron <= c.neuron; }))
+                    << from << " -> " << to;
+            }
+        }
+    }
+}
+
+// 稠密的 fiber 与稀疏的突触行计算结果完全相同，密度下降后转回稀疏
+TEST(PlasticityTest, DenseFibersMatchSparse) {
+    auto run = [](const DenseFiberOptions& options) {
+        IncrementalParser parser;
+        parser.brain().SetDenseFiberOptions(options);
+        for (const char* word : {"the", "dog", "happily", "runs", "around", "the", "big", "yard"}) {
+            parser.feed(word);
+        }
+        return parser;
+    };
+    DenseFiberOptions sparse_only, dense_only;
+    sparse_only.enter_density = 2.0f;
+    dense_only.enter_density = dense_only.exit_density = 0.0f;
+    dense_only.max_cells = SIZE_MAX;
+    IncrementalParser sparse = run(sparse_only);
+    IncrementalParser dense = run(dense_only);
+    IncrementalParser mixed = run(DenseFiberOptions());
+    for (const auto& from : AREAS) {
+        for (const auto& to : AREAS) {
+            const Fiber& a = sparse.brain().GetFiber(from, to);
+            const Fiber& b = dense.brain().GetFiber(from, to);
+            ASSERT_EQ(a.NumRows(), b.NumRows()) << from << " -> " << to;
+            EXPECT_EQ(a.num_synapses, b.num_synapses) << from << " -> " << to;
+            for (uint32_t i = 0; i < a.NumRows(); ++i) {
+                std::vector<std::pair<uint32_t, float>> row_a, row_b;
+                a.ForEachSynapse(i, [&](uint32_t n, float w) { row_a.emplace_back(n, w); });
+                b.ForEachSynapse(i, [&](uint32_t n, float w) { row_b.emplace_back(n, w); });
+                ASSERT_EQ(row_a, row_b) << from << " -> " << to << " row " << i;
+            }
+        }
+        EXPECT_EQ(sparse.brain().GetArea(from).activated, dense.brain().GetArea(from).activated);
+        EXPECT_EQ(sparse.brain().GetArea(from).activated, mixed.brain().GetArea(from).activated);
+    }
+    EXPECT_EQ(sparse.finish(), dense.finish());
+    // 增量维护的内存总量与逐个统计的相同
+    for (IncrementalParser* parser : {&sparse, &dense, &mixed}) {
+        EXPECT_EQ(parser->brain().MemoryBytes(), parser->brain().MemoryStats().bytes);
+    }
+
+    // 转为稠密再转回稀疏后行内仍然有序
+    Brain b(0.5, 0.1, 10000.0, 3);
+    b.AddArea("A", 200, 20, false, true);
+    b.AddArea("B", 200, 20);
+    b.AddFiber("A", "B");
+    b.ActivateArea("A", 0);
+    b.Project({{"A", {"B"}}, {"B", {"B"}}}, 3);
+#ifdef NEMO_QUANTIZED_WEIGHTS
+    // 量化权重时始终使用稀疏表示
+    EXPECT_FALSE(b.GetFiber("A", "B").dense);
+#else
+    EXPECT_TRUE(b.GetFiber("A", "B").dense);
+#endif
+    DenseFiberOptions exit_dense;
+    exit_dense.exit_density = 2.0f;
+    b.SetDenseFiberOptions(exit_dense);
+    b.Project({{"A", {"B"}}, {"B", {"B"}}}, 1);
+    const Fiber& fiber = b.GetFiber("A", "B");
+    EXPECT_FALSE(fiber.dense);
+    for (const auto& row : fiber.outgoing_synapses) {
+        EXPECT_TRUE(std::is_sorted(row.begin(), row.end(),
+            [](const Synapse& x, const Synapse& y) { return x.neuron < y.neuron; }));
+    }
+
+#ifndef NEMO_QUANTIZED_WEIGHTS
+    // 列数的成倍增长不超过 max_cells，需要的列更多时转回稀疏
+    Brain c(0.5, 0.1, 10000.0, 3);
+    c.AddArea("A", 200, 20, false, true);
+    c.AddArea("B", 2000, 20, /*recurrent=*/false);
+    c.AddFiber("A", "B");
+    DenseFiberOptions capped;
+    capped.max_cells = 200 * 100;
+    c.SetDenseFiberOptions(capped);
+    bool was_dense = false;
+    for (uint32_t i = 0; i < 10; ++i) {
+        c.ActivateArea("A", i);
+        c.Project({{"A", {"B"}}}, 1);
+        const Fiber& grown = c.GetFiber("A", "B");
+        was_dense |= grown.dense;
+        if (grown.dense) {
+            EXPECT_TRUE(size_t(grown.NumRows()) * grown.dense_cols <= capped.max_cells ||
+                        grown.dense_cols == c.GetArea("B").support);
+        }
+    }
+    EXPECT_TRUE(was_dense);
+    EXPECT_GT(c.GetArea("B").support, 100u);
+    c.Project({{"A", {"B"}}}, 1);
+    EXPECT_FALSE(c.GetFiber("A", "B").dense);
+#endif
+}
+
+// 融合的可塑性与逐行遍历的结果完全相同，包括换用刺激后新进入的获胜神经元
+TEST(PlasticityTest, FusedPlasticityMatches) {
+    Brain plain(0.05, 0.1, 10000.0, 7);
+    Brain fused(0.05, 0.1, 10000.0, 7);
+    fused.SetFusedPlasticity(true);
+    for (Brain* b : {&plain, &fused}) {
+        b->AddArea("A", 20000, 50);
+        b->AddArea("B", 20000, 50);
+        b->AddStimulus("S", 50, 50);
+        b->AddStimulus("T", 50, 50);
+        b->AddFiber("S", "A");
+        b->AddFiber("T", "A");
+        b->AddFiber("A", "B");
+        b->Project({{"S", {"A"}}}, 1);
+        b->Project({{"S", {"A"}}, {"A", {"A", "B"}}, {"B", {"B"}}}, 10);
+        b->Project({{"T", {"A"}}, {"A", {"A", "B"}}, {"B", {"B"}}}, 10);
+        b->Project({{"S", {"A"}}, {"A", {"A", "B"}}, {"B", {"B"}}}, 5);
+    }
+    for (const char* area : {"A", "B"}) {
+        EXPECT_EQ(fused.GetArea(area).activated, plain.GetArea(area).activated);
+    }
+    for (auto [from, to] : {std::pair{"A", "A"}, {"A", "B"}, {"B", "B"}, {"S", "A"}}) {
+        const Fiber& x = fused.GetFiber(from, to);
+        const Fiber& y = plain.GetFiber(from, to);
+        ASSERT_EQ(x.NumRows(), y.NumRows());
+        for (uint32_t row = 0; row < x.NumRows(); ++row) {
+            std::vector<std::pair<uint32_t, float>> a, b;
+            x.ForEachSynapse(row, [&](uint32_t n, float w) { a.emplace_back(n, w); });
+            y.ForEachSynapse(row, [&](uint32_t n, float w) { b.emplace_back(n, w); });
+            ASSERT_EQ(a, b) << from << " -> " << to << " row " << row;
+        }
+    }
+}
+
+// 每个 fiber 使用自己的 beta：beta 为 0 的 fiber 权重保持不变
+TEST(PlasticityTest, PerFiberBeta) {
+    Brain b(0.1, 0.0, 10000.0, 42);
+    b.AddStimulus("S", 100, 10);
+    b.AddArea("A", 1000, 10);
+    b.AddFiber("S", "A");
+    b.SetFiberBeta("S", "A", 1.0);
+    b.Project({{"S", {"A"}}, {"A", {"A"}}}, 5);
+    auto max_weight = [&](const std::string& from, const std::string& to) {
+        const Fiber& fiber = b.GetFiber(from, to);
+        float w = 0;
+        for (uint32_t i = 0; i < fiber.NumRows(); ++i) {
+            fiber.ForEachSynapse(i, [&](uint32_t, float weight) { w = std::max(w, weight); });
+        }
+        return w;
+    };
+    EXPECT_GE(max_weight("S", "A"), 8.0f);
+    EXPECT_EQ(max_weight("A", "A"), 1.0f);
+}
+
+// 权重在 max_weight 处饱和，量化与否结果相同；量化时 level 不够用的 beta 被拒绝
+TEST(PlasticityTest, WeightsSaturateAtMaxWeight) {
+    Brain b(0.1, 0.0, 3.0, 42);
+    b.AddStimulus("S", 100, 10);
+    b.AddArea("A", 1000, 10);
+    b.AddFiber("S", "A");
+    b.SetFiberBeta("S", "A", 1.0);
+    b.Project({{"S", {"A"}}}, 10);
+    const Fiber& fiber = b.GetFiber("S", "A");
+    float w = 0;
+    for (uint32_t i = 0; i < fiber.NumRows(); ++i) {
+        fiber.ForEachSynapse(i, [&](uint32_t, float weight) { w = std::max(w, weight); });
+    }
+    EXPECT_EQ(w, 3.0f);
+#ifdef NEMO_QUANTIZED_WEIGHTS
+    EXPECT_THROW(b.SetFiberBeta("S", "A", 1e-5f), std::invalid_argument);
+    EXPECT_EQ(b.GetFiber("S", "A").beta, 1.0f);
+#endif
+}
+
+// 刺激不生成神经元：投射若干步后脑区收敛，刺激 fiber 的权重增长
+TEST(StimulusTest, ProjectionConverges) {
+    Brain b(0.05, 0.1, 10000.0, 7);
+    b.AddStimulusInput("S", 50);
+    b.AddArea("A", 10000, 50);
+    b.AddStimulusFiber("S", "A");
+    b.SetStimulusBeta("S", "A", 0.1);
+    b.Project({{"S", {"A"}}}, 1);
+    b.Project({{"S", {"A"}}, {"A", {"A"}}}, 20);
+    const Area& a = b.GetArea("A");
+    const uint32_t support = a.support;
+    std::vector<uint32_t> before = a.activated;
+    b.Project({{"S", {"A"}}, {"A", {"A"}}}, 5);
+    EXPECT_EQ(a.support, support);
+    std::sort(before.begin(), before.end());
+    std::vector<uint32_t> after = a.activated;
+    std::sort(after.begin(), after.end());
+    EXPECT_EQ(before, after);
+    const StimulusFiber& fiber = b.GetStimulusFiber("S", "A");
+    ASSERT_EQ(fiber.weights.size(), a.support);
+    EXPECT_GT(*std::max_element(fiber.weights.begin(), fiber.weights.end()), 1.5f);
+}
+
+// Merge 在目标脑区形成大小为 k 的 assembly
+TEST(StimulusTest, MergeFormsAssembly) {
+    Brain b(0.05, 0.1, 10000.0, 7);
+    b.AddStimulusInput("SA", 50);
+    b.AddStimulusInput("SB", 50);
+    for (const char* name : {"A", "B", "C"}) b.AddArea(name, 10000, 50);
+    for (const char* stim : {"SA", "SB"}) {
+        for (const char* to : {"A", "B", "C"}) b.AddStimulusFiber(stim, to);
+    }
+    for (const char* from : {"A", "B", "C"}) {
+        for (const char* to : {"A", "B", "C"}) b.AddFiber(from, to);
+    }
+    b.Project({{"SA", {"A"}}, {"SB", {"B"}}}, 1);
+    b.Merge("A", "B", "C", 10, {{"SA", {"A"}}, {"SB", {"B"}}});
+    EXPECT_EQ(b.GetArea("C").activated.size(), 50u);
+    EXPECT_THROW(b.GetStimulusFiber("SA", "missing"), std::out_of_range);
+}
+
+// SimulateOneStep 只更新有激活输入的脑区；InitProjection 只保留图中的连接
+TEST(StimulusTest, OnlyActiveFibersProject) {
+    Brain b(0.05, 0.1, 10000.0, 7);
+    b.AddStimulusInput("S", 50);
+    for (const char* name : {"A", "B", "C"}) b.AddArea(name, 10000, 50, /*recurrent=*/false);
+    b.AddStimulusFiber("S", "A");
+    b.AddFiber("A", "B");
+    b.AddFiber("A", "C");
+    b.AddFiber("B", "C");
+    b.Project({{"S", {"A"}}}, 1);
+    EXPECT_EQ(b.GetArea("A").activated.size(), 50u);
+
+    b.InhibitAll();
+    b.ActivateFiber("A", "B");
+    b.SimulateOneStep();
+    EXPECT_EQ(b.GetArea("B").activated.size(), 50u);
+    EXPECT_TRUE(b.GetArea("C").activated.empty());
+
+    b.InitProjection({{"A", {"C"}}});
+    EXPECT_FALSE(b.GetFiber("A", "B").is_active);
+    EXPECT_TRUE(b.GetFiber("A", "C").is_active);
+    EXPECT_FALSE(b.GetFiber("B", "C").is_active);
+    EXPECT_FALSE(b.GetStimulusFiber("S", "A").is_active);
+    b.InhibitFiber("A", "C");
+    b.SimulateOneStep();
+    EXPECT_TRUE(b.GetArea("C").activated.empty());
+    b.ActivateFiber("B", "C");
+    b.SimulateOneStep();
+    EXPECT_EQ(b.GetArea("C").activated.size(), 50u);
+}
+
+// MemoryStats 的各项之和与总量一致；超出预算时抛出 MemoryBudgetExceeded
+TEST(MemoryStatsTest, TotalsAndBudget) {
+    IncrementalParser parser;
+    for (const char* word : {"the", "dog", "chases", "a", "cat"}) parser.feed(word);
+    const Brain& b = parser.brain();
+    const BrainMemoryStats stats = b.MemoryStats();
+    size_t bytes = 0, synapses = 0;
+    for (const AreaMemory& area : stats.areas) bytes += area.bytes;
+    for (const FiberMemory& fiber : stats.fibers) {
+        bytes += fiber.bytes;
+        if (fiber.rows > 0) synapses += fiber.synapses;
+    }
+    EXPECT_EQ(bytes, stats.bytes);
+    EXPECT_EQ(stats.bytes, b.MemoryBytes());
+    EXPECT_EQ(synapses, stats.synapses);
+    EXPECT_GE(stats.peak_bytes, stats.bytes);
+    EXPECT_EQ(stats.budget_bytes, 0u);
+    size_t subj_rows = 0;
+    for (const FiberMemory& fiber : stats.fibers) {
+        if (fiber.from == SUBJ && fiber.to == VERB) subj_rows = fiber.rows;
+    }
+    EXPECT_EQ(subj_rows, b.GetArea(SUBJ).support);
+
+    IncrementalParser limited;
+    limited.brain().SetMemoryBudget(stats.bytes / 2);
+    EXPECT_THROW({
+        for (const char* word : {"the", "dog", "chases", "a", "cat"}) limited.feed(word);
+    }, MemoryBudgetExceeded);
+    EXPECT_GT(limited.brain().MemoryBytes(), stats.bytes / 2);
+
+    // 压缩后仍然超出时同样抛出
+    IncrementalParser compacting;
+    compacting.brain().SetMemoryBudget(stats.bytes / 2, BudgetAction::kCompact);
+    EXPECT_THROW({
+        for (const char* word : {"the", "dog", "chases", "a", "cat"}) compacting.feed(word);
+    }, MemoryBudgetExceeded);
+}
+
+// 检查 fiber 的每一行按目标神经元递增、不超出目标脑区，且 num_synapses 与突触数一致
+void ExpectFiberConsistent(const Brain& b, const char* from, const char* to) {
+    const Fiber& fiber = b.GetFiber(from, to);
+    EXPECT_EQ(fiber.NumRows(), b.GetArea(from).support);
+    size_t synapses = 0;
+    for (uint32_t i = 0; i < fiber.NumRows(); ++i) {
+        int64_t last = -1;
+        fiber.ForEachSynapse(i, [&](uint32_t neuron, float) {
+            EXPECT_GT(int64_t(neuron), last);
+            EXPECT_LT(neuron, b.GetArea(to).support);
+            last = neuron;
+            ++synapses;
+        });
+    }
+    EXPECT_EQ(synapses, fiber.num_synapses);
+}
+
+// 先后学会两个刺激的 assembly 后，第一个 assembly 沉默：只删除未增强的突触时
+// support 不变；回收时 support 减少，编号改变后第二个 assembly 仍然稳定
+TEST(PruneTest, RecyclesSilentNeurons) {
+    auto train = [](Brain& b) {
+        b.AddStimulusInput("S1", 50);
+        b.AddStimulusInput("S2", 50);
+        b.AddArea("A", 10000, 50);
+        b.AddArea("B", 10000, 50, /*recurrent=*/false);
+        b.AddFiber("A", "B");
+        b.AddStimulusFiber("S1", "A");
+        b.AddStimulusFiber("S2", "A");
+        b.Project({{"S1", {"A"}}}, 1);
+        b.Project({{"S1", {"A"}}, {"A", {"A", "B"}}}, 10);
+        b.Project({{"S2", {"A"}}}, 1);
+        b.Project({{"S2", {"A"}}, {"A", {"A", "B"}}}, 30);
+    };
+    PruneOptions options;
+    options.max_idle_steps = 20;
+
+    Brain kept(0.05, 0.1, 10000.0, 7);
+    train(kept);
+    const uint32_t support = kept.GetArea("A").support;
+    const size_t synapses = kept.GetFiber("A", "A").num_synapses;
+    options.recycle_neurons = false;
+    PruneStats stats = kept.Prune(options);
+    EXPECT_EQ(stats.neurons_recycled, 0u);
+    EXPECT_GT(stats.synapses_removed, 0u);
+    EXPECT_EQ(kept.GetArea("A").support, support);
+    EXPECT_LT(kept.GetFiber("A", "A").num_synapses, synapses);
+    ExpectFiberConsistent(kept, "A", "A");
+
+    Brain b(0.05, 0.1, 10000.0, 7);
+    train(b);
+    options.recycle_neurons = true;
+    stats = b.Prune(options);
+    const Area& a = b.GetArea("A");
+    EXPECT_GE(stats.neurons_recycled, 50u);
+    EXPECT_GT(stats.synapses_removed, synapses - kept.GetFiber("A", "A").num_synapses);
+    EXPECT_EQ(a.support + b.GetArea("B").support + stats.neurons_recycled, support + 
+              kept.GetArea("B").support);
+    ASSERT_EQ(a.activated.size(), 50u);
+    for (uint32_t neuron : a.activated) EXPECT_LT(neuron, a.support);
+    ExpectFiberConsistent(b, "A", "A");
+    ExpectFiberConsistent(b, "A", "B");
+    EXPECT_EQ(b.GetStimulusFiber("S1", "A").weights.size(), a.support);
+    EXPECT_EQ(b.MemoryBytes(), b.MemoryStats().bytes);
+
+    std::vector<uint32_t> before = a.activated;
+    std::sort(before.begin(), before.end());
+    const uint32_t pruned_support = a.support;
+    b.Project({{"S2", {"A"}}, {"A", {"A", "B"}}}, 5);
+    std::vector<uint32_t> after = a.activated;
+    std::sort(after.begin(), after.end());
+    EXPECT_EQ(after, before);
+    EXPECT_EQ(a.support, pruned_support);
+
+    // 自动剪枝：第一个刺激重新学习后再次沉默，每 10 步的剪枝把它回收
+    b.SetPruneOptions({/*max_idle_steps=*/20, /*recycle_neurons=*/true, /*interval=*/10});
+    b.Project({{"S1", {"A"}}}, 1);
+    b.Project({{"S1", {"A"}}, {"A", {"A"}}}, 10);
+    const uint32_t grown = a.support;
+    EXPECT_GT(grown, pruned_support);
+    b.Project({{"S2", {"A"}}, {"A", {"A"}}}, 40);
+    EXPECT_LT(a.support, grown);
+    ExpectFiberConsistent(b, "A", "A");
+    EXPECT_EQ(b.MemoryBytes(), b.MemoryStats().bytes);
+}
+
+// 两个名词和两个动词在随机句子中学会，之后每个语境都能读出自己的单词
+TEST(LearnBrainTest, LearnsSmallLexicon) {
+    LearnOptions options;
+    options.LEX_k = 50;
+    options.seed = 0;
+    LearnBrain b(options);
+    const int sentences = b.TrainExperimentRandomized(200);
+    ASSERT_GE(sentences, 0);
+    for (uint32_t word = 0; word < b.lex_size(); ++word) {
+        EXPECT_EQ(b.TestIndexedWord(word), int(word));
+    }
+    // 单词的语音和语境共同驱动对应的词汇脑区
+    b.TutorSingleIndexedWord(0);
+    EXPECT_GT(b.GetTotalInput(learner::NOUN), 0.0f);
+}
+
+TEST(SamplingTest, DistinctAndUniform) {
+    std::mt19937 rng(42);
+    std::vector<uint32_t> sample;
+    const uint32_t n = 100;
+    // 覆盖 Floyd 算法（m <= n / 2）和取补集两种情形
+    for (uint32_t m : {0u, 1u, 10u, 50u, 51u, 90u, 100u}) {
+        std::vector<uint32_t> counts(n);
+        const int trials = 2000;
+        for (int t = 0; t < trials; ++t) {
+            SampleWithoutReplacement(n, m, rng, sample);
+            ASSERT_EQ(sample.size(), m);
+            std::vector<uint32_t> sorted = sample;
+            std::sort(sorted.begin(), sorted.end());
+            ASSERT_TRUE(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+            for (uint32_t x : sample) {
+                ASSERT_LT(x, n);
+                ++counts[x];
+            }
+        }
+        // 每个整数被选中的次数约为 trials * m / n
+        const double expected = double(trials) * m / n;
+        for (uint32_t c : counts) {
+            EXPECT_NEAR(c, expected, 5 * std::sqrt(expected) + 1) << "m = " << m;
+        }
+    }
+}
+
+TEST(IncrementalParserTest, NoDependenciesBeforeVerb) {
+    IncrementalParser parser;
+    parser.feed("the");
+    parser.feed("cat");
+    EXPECT_TRUE(parser.snapshot_dependencies().empty());
+    EXPECT_THROW(parser.feed("unknownword"), std::runtime_error);
+}
+
+// 复制模板 brain 得到的解析器与新构造的结果相同，模板本身不被改变
+TEST(IncrementalParserTest, TemplateCopyMatchesParse) {
+    EnglishParserBrain brain(0.1f);
+    for (int i = 0; i < 3; ++i) {
+        IncrementalParser parser(brain);
+        std::istringstream words(sentences[7].sentence);
+        std::string word;
+        while (words >> word) parser.feed(word);
+        EXPECT_EQ(parser.finish(), parse(sentences[7].sentence));
+    }
+}
+
+// readout 不改变 brain：各脑区的 activated、support、突触权重不变，随机数状态
+// 也不变（从 readout 之前的副本继续解析得到相同的结果）
+TEST(IncrementalParserTest, ReadoutDoesNotMutateBrain) {
+    IncrementalParser parser;
+    for (const char* word : {"the", "cat", "chases"}) parser.feed(word);
+    const EnglishParserBrain before = parser.brain();
+    EXPECT_FALSE(parser.snapshot_dependencies().empty());
+    const EnglishParserBrain& after = parser.brain();
+    for (const std::string& area : before.all_areas) {
+        EXPECT_EQ(after.GetArea(area).activated, before.GetArea(area).activated) << area;
+        EXPECT_EQ(after.GetArea(area).support, before.GetArea(area).support) << area;
+        for (const std::string& to : before.all_areas) {
+            const Fiber& a = after.GetFiber(area, to);
+            const Fiber& b = before.GetFiber(area, to);
+            ASSERT_EQ(a.NumRows(), b.NumRows()) << area << " -> " << to;
+            for (uint32_t row = 0; row < a.NumRows(); ++row) {
+                std::vector<std::pair<uint32_t, float>> x, y;
+                a.ForEachSynapse(row, [&](uint32_t n, float w) { x.emplace_back(n, w); });
+                b.ForEachSynapse(row, [&](uint32_t n, float w) { y.emplace_back(n, w); });
+                ASSERT_EQ(x, y) << area << " -> " << to << " row " << row;
+            }
+        }
+    }
+    IncrementalParser resumed(before);
+    for (const char* word : {"the", "mouse"}) {
+        parser.feed(word);
+        resumed.feed(word);
+    }
+    EXPECT_EQ(parser.finish(), resumed.finish());
+}
+
+TEST(ProtocolTest, RoundTripAndPartialFrames) {
+    protocol::ParseRequest request;
+    request.id = 1ull << 40;
+    request.p = 0.05f;
+    request.LEX_k = 30;
+    request.project_rounds = 7;
+    request.readout_method = 2;
+    request.sentence = "the cat chases the mouse";
+    protocol::ParseResponse response;
+    response.id = 3;
+    response.dependencies = parse(request.sentence);
+    protocol::ParseResponse error;
+    error.id = 4;
+    error.status = protocol::kError;
+    error.error = "Unknown word: x";
+
+    std::string frames;
+    protocol::AppendRequest(request, frames);
+    const size_t request_size = frames.size();
+    protocol::ParseRequest decoded;
+    EXPECT_EQ(protocol::ReadRequest(std::string_view(frames).substr(0, request_size - 1), decoded), 0u);
+    ASSERT_EQ(protocol::ReadRequest(frames, decoded), request_size);
+    EXPECT_EQ(decoded.id, request.id);
+    EXPECT_EQ(decoded.p, request.p);
+    EXPECT_EQ(decoded.LEX_k, request.LEX_k);
+    EXPECT_EQ(decoded.project_rounds, request.project_rounds);
+    EXPECT_EQ(decoded.readout_method, request.readout_method);
+    EXPECT_EQ(decoded.sentence, request.sentence);
+
+    frames.clear();
+    protocol::AppendResponse(response, frames);
+    protocol::AppendResponse(error, frames);
+    protocol::ParseResponse decoded_response;
+    size_t size = protocol::ReadResponse(frames, decoded_response);
+    ASSERT_GT(size, 0u);
+    EXPECT_EQ(decoded_response.id, response.id);
+    EXPECT_EQ(decoded_response.dependencies, response.dependencies);
+    ASSERT_GT(protocol::ReadResponse(std::string_view(frames).substr(size), decoded_response), 0u);
+    EXPECT_EQ(decoded_response.status, protocol::kError);
+    EXPECT_EQ(decoded_response.error, error.error);
+
+    // 过长的错误信息（例如约 1 MiB 的未知单词）被截断，帧不超过上限
+    error.error = "Unknown word: " + std::string(protocol::kMaxFrameBytes, 'x');
+    frames.clear();
+    protocol::AppendResponse(error, frames);
+    ASSERT_EQ(protocol::ReadResponse(frames, decoded_response), frames.size());
+    EXPECT_EQ(decoded_response.status, protocol::kError);
+    EXPECT_EQ(decoded_response.error.size(), protocol::kMaxErrorBytes);
+    EXPECT_EQ(decoded_response.error.substr(0, 16), "Unknown word: xx");
+    EXPECT_EQ(decoded_response.error.substr(protocol::kMaxErrorBytes - 3), "...");
+
+    // 长度超过上限的帧
+    std::string bad = "\xff\xff\xff\xff";
+    EXPECT_THROW(protocol::ReadRequest(bad, decoded), std::runtime_error);
+}
+
+TEST(ParseCacheTest, HitsMissesAndPersistence) {
+    auto lexicon = DefaultLexicon();
+    ParseCache cache(1 << 20, 4);
+    ParserOptions options;
+    auto first = parse("the cat chases the mouse", options, cache);
+    // 空白和标点不同的同一个句子命中缓存
+    EXPECT_EQ(parse(" the cat  chases the mouse.", options, cache), first);
+    EXPECT_EQ(first, parse("the cat chases the mouse"));
+    options.project_rounds = 10;
+    parse("the cat chases the mouse", options, cache);
+    ParseCache::Stats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.entries, 2u);
+
+    const std::string path = ::testing::TempDir() + "parse_cache_test.bin";
+    cache.Save(path, lexicon->Fingerprint());
+    ParseCache restored(1 << 20);
+    EXPECT_EQ(restored.Load(path, lexicon->Fingerprint()), 2u);
+    EXPECT_EQ(restored.Load(path, lexicon->Fingerprint() + 1), 0u);
+    ParseCacheKey key;
+    ASSERT_TRUE(MakeParseCacheKey(*lexicon, "the cat chases the mouse", 0.1f, 20, 20, 2, key));
+    ParseCache::Dependencies dependencies;
+    EXPECT_TRUE(restored.Get(key, dependencies));
+    EXPECT_EQ(dependencies, first);
+
+    // 损坏的单词数或依赖数抛出异常，而不是按损坏的长度分配内存
+    std::string bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t words_at = 8 + 8 + 4 + 4 + 4 + 1;
+    uint32_t num_words;
+    memcpy(&num_words, &bytes[words_at], sizeof(num_words));
+    for (size_t at : {words_at, words_at + 4 + 4 * size_t(num_words)}) {
+        std::string corrupt = bytes;
+        const uint32_t huge = 0xffffffff;
+        memcpy(&corrupt[at], &huge, sizeof(huge));
+        std::ofstream(path, std::ios::binary) << corrupt;
+        ParseCache loaded(1 << 20);
+        EXPECT_THROW(loaded.Load(path, lexicon->Fingerprint()), std::runtime_error);
+    }
+    std::remove(path.c_str());
+}
+
+TEST(ParseCacheTest, EvictsLeastRecentlyUsed) {
+    ParseCache cache(2000, 1);
+    ParseCache::Dependencies dependencies = {{"chases", "cat", "SUBJ"}, {"cat", "the", "DET"}};
+    std::vector<ParseCacheKey> keys(20);
+    for (uint32_t i = 0; i < keys.size(); ++i) {
+        keys[i].word_ids = {i, i + 1};
+        cache.Put(keys[i], dependencies);
+        ParseCache::Dependencies found;
+        EXPECT_TRUE(cache.Get(keys[0], found));  // 一直使用的条目不被淘汰
+    }
+    ParseCache::Stats stats = cache.stats();
+    EXPECT_LE(stats.bytes, cache.max_bytes());
+    EXPECT_GT(stats.evictions, 0u);
+    ParseCache::Dependencies found;
+    EXPECT_FALSE(cache.Get(keys[1], found));
+    EXPECT_TRUE(cache.Get(keys.back(), found));
+}
+
+// 从缓存的前缀状态继续解析的结果与 parse 相同；预算容不下一个快照时不缓存
+TEST(PrefixStateCacheTest, ResumesFromSharedPrefix) {
+    const std::vector<std::string> shared = {
+        "the cat chases the mouse", "the cat is very happy", "the cat chases a bird",
+        "the cat quickly jumps over the small fence"};
+    PrefixStateCache cache(ParserOptions(), 64 << 20);
+    PrefixStateCache tiny(ParserOptions(), 1024);
+    for (int round = 0; round < 2; ++round) {
+        for (const std::string& sentence : shared) {
+            auto expected = parse(sentence);
+            EXPECT_EQ(cache.Parse(sentence), expected) << sentence;
+            EXPECT_EQ(tiny.Parse(sentence), expected) << sentence;
+        }
+    }
+    EXPECT_GT(cache.stats().words_reused, 0u);
+    EXPECT_LE(cache.stats().bytes, 64u << 20);
+    EXPECT_EQ(tiny.stats().words_reused, 0u);
+    EXPECT_EQ(tiny.stats().entries, 0u);
+    EXPECT_THROW(cache.Parse("the cat unknownword"), std::runtime_error);
+}
+
+TEST(BatchParseTest, MatchesParse) {
+    const std::vector<std::string> batch = {
+        "the cat chases the mouse", "the cat is very happy", "the cat chases the mouse",
+        "a dog runs", "the cat unknownword", "the cat chases a bird", "the cat"};
+    BatchParseStats stats;
+    auto results = ParseBatch(batch, ParserOptions(), 2, nullptr, &stats);
+    ASSERT_EQ(results.size(), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (i == 4) {
+            EXPECT_EQ(results[i].error, "Unknown word: unknownword");
+            continue;
+        }
+        EXPECT_TRUE(results[i].error.empty()) << batch[i];
+        EXPECT_EQ(results[i].dependencies, parse(batch[i])) << batch[i];
+    }
+    EXPECT_EQ(stats.words, 25u);
+    EXPECT_LT(stats.words_simulated, stats.words);
+}
+
+// 没有从句的句子与 parse 的结果相同
+TEST(RecursiveParserTest, FlatSentencesMatchParse) {
+    for (const auto& args : sentences) {
+        EXPECT_TRUE(CompareDependency(parse_recursive(args.sentence),
+                                      expected_dependency[args.index])) << args.sentence;
+    }
+}
+
+TEST(RecursiveParserTest, RelativeClauses) {
+    std::set<std::vector<std::string>> subject_gap = {
+        {"cat", "the", "DET"}, {"runs", "cat", "SUBJ"},
+        {"cat", "chases", "DEP-VERB"}, {"chases", "cat", "SUBJ"},
+        {"chases", "mouse", "OBJ"}, {"mouse", "the", "DET"}};
+    EXPECT_EQ(parse_recursive("the cat that chases the mouse, runs"), subject_gap);
+
+    // 嵌套的从句：宾语缺失的从句中包含主语缺失的从句
+    auto nested = parse_recursive("the cat that the dog that chases the mouse , saw , runs");
+    for (const std::vector<std::string>& dependency :
+         std::vector<std::vector<std::string>>{
+             {"runs", "cat", "SUBJ"}, {"cat", "saw", "DEP-VERB"}, {"saw", "cat", "OBJ"},
+             {"saw", "dog", "SUBJ"}, {"dog", "chases", "DEP-VERB"}, {"chases", "dog", "SUBJ"},
+             {"chases", "mouse", "OBJ"}}) {
+        EXPECT_TRUE(nested.count(dependency)) << dependency[0] << " " << dependency[1];
+    }
+}
+
+TEST(RecursiveParserTest, DepthIsBounded) {
+    RecursiveParser parser(ParserOptions(), /*max_depth=*/2);
+    for (const char* word : {"the", "cat", "that", "the", "dog"}) parser.feed(word);
+    EXPECT_EQ(parser.depth(), 1u);
+    EXPECT_THROW(parser.feed(CLAUSE_START), std::runtime_error);
+    EXPECT_THROW(RecursiveParser().feed(CLAUSE_END), std::runtime_error);
+}
+
 } // namespace nemo
\ No newline at end of file
@@ -0,0 +1,232 @@
+# Drop-in replacement for brain.Brain that runs on the compiled nemo::Brain.
+#
+# Build the extension first:
+#   cmake -S cpp/python -B cpp/python/build && cmake --build cpp/python/build
+#   export PYTHONPATH=$PWD/cpp/python/build:$PYTHONPATH
+# then switch an experiment with `import nemo_brain as brain`.
+#
+# Differences from brain.py:
+# - winners are read-only numpy.uint32 arrays. The engine's winners are copied
+#   once per step, on the first read; later reads and saved_winners share that
+#   copy. Assign a new sequence to `area.winners` instead of mutating it in place.
+# - beta_by_area / beta_by_stimulus are read-only; use update_plasticity(ies).
+# - add_explicit_area only supports the brain-wide connection probability p.
+# - Brain objects can be deep-copied but not pickled.
+
+import collections.abc
+import types
+
+import numpy as np
+
+import _nemo
+
+EMPTY_MAPPING = types.MappingProxyType({})
+
+
+class Winners(np.ndarray):
+  """An area's winners: a read-only numpy.uint32 array that is also a Sequence.
+
+  Registered as collections.abc.Sequence so that code written against the
+  list-based brain.py (e.g. random.sample(area.winners, m)) keeps working.
+  """
+
+
+collections.abc.Sequence.register(Winners)
+
+
+def _as_winners(buffer):
+  return np.frombuffer(buffer, dtype=np.uint32).view(Winners)
+
+
+class Area:
+  """A brain area backed by an area of the compiled engine.
+
+  Attributes mirror brain.Area; `w`, `winners` and `fixed_assembly` are read
+  from the engine, so they are always current.
+  """
+  def __init__(self, brain, name, n, k, *, beta=0.05, explicit=False):
+    self._brain = brain
+    self.name = name
+    self.n = n
+    self.k = k
+    self.beta = beta
+    self._beta_by_stimulus = {}
+    self._beta_by_area = {}
+    self.saved_w = []
+    self.saved_winners = []
+    self.num_first_winners = -1
+    self.explicit = explicit
+
+  @property
+  def beta_by_stimulus(self):
+    return types.MappingProxyType(self._beta_by_stimulus)
+
+  @property
+  def beta_by_area(self):
+    return types.MappingProxyType(self._beta_by_area)
+
+  @property
+  def w(self):
+    return self._brain._engine.support(self.name)
+
+  @property
+  def winners(self):
+    return _as_winners(self._brain._engine.winners(self.name))
+
+  @winners.setter
+  def winners(self, neurons):
+    self._brain._engine.set_winners(self.name, neurons)
+
+  @property
+  def fixed_assembly(self):
+    return self._brain._engine.is_fixed(self.name)
+
+  def update_beta_by_stimulus(self, name, new_beta):
+    self._brain.update_plasticity(name, self.name, new_beta)
+
+  def update_area_beta(self, name, new_beta):
+    self._brain.update_plasticity(name, self.name, new_beta)
+
+  def fix_assembly(self):
+    if not len(self.winners):
+      raise ValueError(
+        f'Area {self.name!r} does not have assembly; cannot fix.')
+    self._brain._engine.set_fixed(self.name, True)
+
+  def unfix_assembly(self):
+    self._brain._engine.set_fixed(self.name, False)
+
+  def get_num_ever_fired(self):
+    return self.w
+
+
+class Brain:
+  """A model brain with the interface of brain.Brain.
+
+  As in brain.py, every pair of areas and every stimulus-area pair is
+  connected; the fiber into an area starts with that area's beta.
+  """
+  def __init__(self, p, save_size=True, save_winners=False, seed=0,
+               max_weight=float('inf')):
+    self._engine = _nemo.Brain(p, max_weight=max_weight, seed=seed)
+    self.area_by_name = {}
+    self.stimulus_size_by_name = {}
+    self.p = p
+    self.save_size = save_size
+    self.save_winners = save_winners
+    self.disable_plasticity = False
+
+  @property
+  def areas(self):
+    """Name of `area_by_name` in older experiments."""
+    return self.area_by_name
+
+  def _check_new_name(self, name):
+    if name in self.area_by_name or name in self.stimulus_size_by_name:
+      raise ValueError(f'Name already in use: {name!r}')
+
+  def _connect(self, from_name, to_area):
+    self._engine.add_fiber(from_name, to_area.name)
+    self._engine.set_fiber_beta(from_name, to_area.name, to_area.beta)
+
+  def add_stimulus(self, stimulus_name, size):
+    """Add a stimulus of `size` neurons, all of which fire when projected."""
+    self._check_new_name(stimulus_name)
+    self._engine.add_stimulus(stimulus_name, size)
+    self.stimulus_size_by_name[stimulus_name] = size
+    for area in self.area_by_name.values():
+      self._connect(stimulus_name, area)
+      area._beta_by_stimulus[stimulus_name] = area.beta
+
+  def _add_area(self, area_name, n, k, beta, explicit):
+    self._check_new_name(area_name)
+    self._engine.add_area(area_name, n, k, recurrent=False, explicit=explicit)
+    self.area_by_name[area_name] = the_area = Area(
+        self, area_name, n, k, beta=beta, explicit=explicit)
+    for stim_name in self.stimulus_size_by_name:
+      self._connect(stim_name, the_area)
+      the_area._beta_by_stimulus[stim_name] = beta
+    for other_area in self.area_by_name.values():
+      self._connect(other_area.name, the_area)
+      the_area._beta_by_area[other_area.name] = beta
+      if other_area is not the_area:
+        self._connect(area_name, other_area)
+        other_area._beta_by_area[area_name] = other_area.beta
+    return the_area
+
+  def add_area(self, area_name, n, k, beta):
+    """Add a sparsely simulated area of n neurons, k of which fire."""
+    self._add_area(area_name, n, k, beta, explicit=False)
+
+  def add_explicit_area(self,
+                        area_name, n, k, beta, *,
+                        custom_inner_p=None,
+                        custom_out_p=None,
+                        custom_in_p=None):
+    """Add an explicit (fully simulated) area of n neurons, k of which fire."""
+    for custom_p in (custom_inner_p, custom_out_p, custom_in_p):
+      if custom_p is not None and custom_p != self.p:
+        raise NotImplementedError(
+          'The compiled engine uses the same connection probability p '
+          'for every fiber.')
+    self._add_area(area_name, n, k, beta, explicit=True)
+
+  def update_plasticity(self, from_area, to_area, new_beta):
+    self._engine.set_fiber_beta(from_area, to_area, new_beta)
+    the_area = self.area_by_name[to_area]
+    if from_area in self.stimulus_size_by_name:
+      the_area._beta_by_stimulus[from_area] = new_beta
+    else:
+      the_area._beta_by_area[from_area] = new_beta
+
+  def update_plasticities(self,
+                          area_update_map=EMPTY_MAPPING,
+                          stim_update_map=EMPTY_MAPPING):
+    # area_update_map consists of area1: list[ (area2, new_beta) ]
+    # represents new plasticity FROM area2 INTO area1
+    for to_area, update_rules in area_update_map.items():
+      for from_area, new_beta in update_rules:
+        self.update_plasticity(from_area, to_area, new_beta)
+    # stim_update_map consists of area: list[ (stim, new_beta) ]
+    # represents new plasticity FROM stim INTO area
+    for area, update_rules in stim_update_map.items():
+      for stim, new_beta in update_rules:
+        self.update_plasticity(stim, area, new_beta)
+
+  def activate(self, area_name, index):
+    self._engine.activate(area_name, index)
+
+  def project(self, areas_by_stim, dst_areas_by_src_area, verbose=0):
+    # areas_by_stim: {"stim1":["A"], "stim2":["C","A"]}
+    # dst_areas_by_src_area: {"A":["A","B"],"C":["C","A"]}
+    graph = {}
+    for stim, areas in areas_by_stim.items():
+      if stim not in self.stimulus_size_by_name:
+        raise IndexError(f"Not in brain.stimulus_size_by_name: {stim}")
+      graph[stim] = list(areas)
+    for from_area_name, to_area_names in dst_areas_by_src_area.items():
+      if from_area_name not in self.area_by_name:
+        raise IndexError(f"Not in brain.area_by_name: {from_area_name}")
+      if to_area_names and not len(self.area_by_name[from_area_name].winners):
+        raise ValueError(
+          f"Projecting from area with no assembly: {from_area_name}")
+      graph[from_area_name] = list(to_area_names)
+    to_update_area_names = set()
+    for to_area_names in graph.values():
+      for to_area_name in to_area_names:
+        if to_area_name not in self.area_by_name:
+          raise IndexError(f"Not in brain.area_by_name: {to_area_name}")
+        to_update_area_names.add(to_area_name)
+
+    w_before = {name: self.area_by_name[name].w
+                for name in to_update_area_names}
+    self._engine.set_log_level(verbose)
+    self._engine.project(graph,
+                         update_plasticity=not self.disable_plasticity)
+    for area_name in to_update_area_names:
+      area = self.area_by_name[area_name]
+      area.num_first_winners = area.w - w_before[area_name]
+      if self.save_winners:
+        area.saved_winners.append(area.winners)
+      if self.save_size:
+        area.saved_w.append(area.w)
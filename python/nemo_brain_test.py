@@ -0,0 +1,68 @@
+#! /usr/bin/python
+# Run with the extension on the path:
+#   PYTHONPATH=cpp/python/build:python python3 python/nemo_brain_test.py
+
+import copy
+import random
+import unittest
+
+import numpy as np
+
+import nemo_brain as brain
+
+
+def _project_brain(n=100000, k=317, p=0.05, beta=0.05, t=25):
+  b = brain.Brain(p, save_winners=True)
+  b.add_stimulus("stim", k)
+  b.add_area("A", n, k, beta)
+  b.project({"stim": ["A"]}, {})
+  for _ in range(t - 1):
+    b.project({"stim": ["A"]}, {"A": ["A"]})
+  return b
+
+
+class TestNemoBrain(unittest.TestCase):
+  def test_projection_converges(self):
+    b = _project_brain()
+    w = b.areas["A"].saved_w
+    self.assertEqual(len(w), 25)
+    self.assertEqual(w[-2], w[-1])
+    self.assertEqual(b.areas["A"].num_first_winners, 0)
+
+  def test_winners_are_views_that_outlive_projection(self):
+    b = _project_brain(t=3)
+    winners = b.areas["A"].winners
+    self.assertEqual(winners.dtype, np.uint32)
+    self.assertFalse(winners.flags.writeable)
+    before = winners.copy()
+    b.project({"stim": ["A"]}, {"A": ["A"]})
+    np.testing.assert_array_equal(winners, before)
+    np.testing.assert_array_equal(b.areas["A"].saved_winners[-1],
+                                  b.areas["A"].winners)
+
+  def test_pattern_completion_on_copy(self):
+    b = _project_brain()
+    winners = b.areas["A"].winners
+    b_copy = copy.deepcopy(b)
+    b_copy.areas["A"].winners = random.sample(winners, 317 // 2)
+    for _ in range(5):
+      b_copy.project({}, {"A": ["A"]})
+    overlap = len(set(b_copy.areas["A"].winners) & set(winners))
+    self.assertGreaterEqual(overlap, 300)
+    self.assertEqual(len(b.areas["A"].saved_w), 25)
+
+  def test_unknown_names(self):
+    b = _project_brain(t=1)
+    with self.assertRaises(IndexError):
+      b.project({"missing": ["A"]}, {})
+    with self.assertRaises(IndexError):
+      b.project({}, {"A": ["missing"]})
+    with self.assertRaises(ValueError):
+      b.areas["A"].winners = [b.areas["A"].w]
+    # (index + 1) * k must not wrap around in 32 bits
+    with self.assertRaises(ValueError):
+      b.activate("A", 0xFFFFFFFF)
+
+
+if __name__ == '__main__':
+  unittest.main()